@@ -13,8 +13,14 @@ out_buf = io.StringIO()
 n = Writer(out_buf)
 
 file_extension = ''
+shared_prefix = 'lib'
+shared_extension = '.so'
 if sys.platform.startswith('win32'):
     file_extension = '.exe'
+    shared_prefix = ''
+    shared_extension = '.dll'
+elif sys.platform.startswith('darwin'):
+    shared_extension = '.dylib'
 
 n.variable('ninja_required_version', '1.3')
 n.newline()
@@ -24,6 +30,7 @@ n.variable('outdir', 'out')
 n.newline()
 
 n.variable('compiler', 'g++')
+n.variable('c_compiler', 'gcc')
 n.newline()
 
 common_ccflags = [
@@ -60,7 +67,27 @@ debug_cflags = [
     '-ggdb',
 ]
 
-common_ldflags = []
+profile_cflags = [
+    '-DBUILD_PROFILE',
+    '-O3',
+]
+
+# The engine's statics are plain statics instead of thread-local ones
+single_threaded_cflags = [
+    '-DBUILD_SINGLE_THREADED',
+    '-O3',
+]
+
+# Only the C interface in include/kinoko.h is exported
+shared_cflags = [
+    '-O3',
+    '-fPIC',
+    '-fvisibility=hidden',
+    '-fvisibility-inlines-hidden',
+]
+
+# Bench mode simulates races on several threads
+common_ldflags = ['-pthread']
 
 n.rule(
     'cc',
@@ -76,21 +103,51 @@ n.rule(
     command='$compiler $ldflags $in -o $out',
     description='LD $out',
 )
+n.newline()
 
-code_in_files = [file for file in glob('**/*.cc', recursive=True)]
+n.rule(
+    'c',
+    command='$c_compiler -MD -MT $out -MF $out.d $cflags -c $in -o $out',
+    depfile='$out.d',
+    deps='gcc',
+    description='CC $out',
+)
+
+# Tests are built into their own executables below
+test_dir = 'tests'
+code_in_files = [
+    file for file in glob('**/*.cc', recursive=True)
+    if not file.startswith(test_dir + os.sep)
+]
 
 target_code_out_files = []
+engine_code_out_files = []
 debug_code_out_files = []
+profile_code_out_files = []
+single_threaded_code_out_files = []
+shared_code_out_files = []
 
 for in_file in code_in_files:
     _, ext = os.path.splitext(in_file)
 
     target_out_file = os.path.join('$builddir', in_file + '.o')
     target_code_out_files.append(target_out_file)
+    if not in_file.endswith('main.cc'):
+        engine_code_out_files.append(target_out_file)
 
     debug_out_file = os.path.join('$builddir', in_file + 'D.o')
     debug_code_out_files.append(debug_out_file)
 
+    profile_out_file = os.path.join('$builddir', in_file + 'P.o')
+    profile_code_out_files.append(profile_out_file)
+
+    single_threaded_out_file = os.path.join('$builddir', in_file + 'ST.o')
+    single_threaded_code_out_files.append(single_threaded_out_file)
+
+    shared_out_file = os.path.join('$builddir', in_file + 'S.o')
+    if not in_file.endswith('main.cc'):
+        shared_code_out_files.append(shared_out_file)
+
     n.build(
         target_out_file,
         ext[1:],
@@ -111,6 +168,43 @@ for in_file in code_in_files:
     )
     n.newline()
 
+    n.build(
+        profile_out_file,
+        ext[1:],
+        in_file,
+        variables={
+            'ccflags': ' '.join([*common_ccflags, *profile_cflags])
+        }
+    )
+    n.newline()
+
+    n.build(
+        single_threaded_out_file,
+        ext[1:],
+        in_file,
+        variables={
+            'ccflags': ' '.join([*common_ccflags, *single_threaded_cflags])
+        }
+    )
+    n.newline()
+
+    n.build(
+        shared_out_file,
+        ext[1:],
+        in_file,
+        variables={
+            'ccflags': ' '.join([*common_ccflags, *shared_cflags])
+        }
+    )
+    n.newline()
+
+
+# The profiling, single-threaded and shared variants compile every source again, so they are only
+# built by naming their alias, e.g. `ninja profile`
+default_targets = [
+    os.path.join('$outdir', f'kinoko{file_extension}'),
+    os.path.join('$outdir', f'kinokoD{file_extension}'),
+]
 
 n.build(
     os.path.join('$outdir', f'kinoko{file_extension}'),
@@ -134,6 +228,107 @@ n.build(
     },
 )
 
+n.build(
+    os.path.join('$outdir', f'kinokoP{file_extension}'),
+    'ld',
+    profile_code_out_files,
+    variables={
+        'ldflags': ' '.join([
+            *common_ldflags,
+        ])
+    },
+)
+
+n.build(
+    os.path.join('$outdir', f'kinokoST{file_extension}'),
+    'ld',
+    single_threaded_code_out_files,
+    variables={
+        'ldflags': ' '.join([
+            *common_ldflags,
+        ])
+    },
+)
+
+n.build('profile', 'phony', os.path.join('$outdir', f'kinokoP{file_extension}'))
+n.build('single_threaded', 'phony', os.path.join('$outdir', f'kinokoST{file_extension}'))
+n.newline()
+
+shared_lib = os.path.join('$outdir', f'{shared_prefix}kinoko{shared_extension}')
+n.build(
+    shared_lib,
+    'ld',
+    shared_code_out_files,
+    variables={
+        'ldflags': ' '.join([
+            *common_ldflags,
+            '-shared',
+        ])
+    },
+)
+
+shared_targets = [shared_lib]
+if not sys.platform.startswith('win32'):
+    bench_episodes_out_file = os.path.join('$builddir', 'tools', 'bench_episodes.c.o')
+    n.build(
+        bench_episodes_out_file,
+        'c',
+        os.path.join('tools', 'bench_episodes.c'),
+        variables={
+            'cflags': '-O2 -Wall -Wextra -Werror -isystem include',
+        },
+    )
+    n.build(
+        os.path.join('$outdir', 'bench_episodes'),
+        'ld',
+        [bench_episodes_out_file, shared_lib],
+        variables={
+            'ldflags': ' '.join([
+                *common_ldflags,
+                "-Wl,-rpath,'$$ORIGIN'",
+            ])
+        },
+    )
+    shared_targets.append(os.path.join('$outdir', 'bench_episodes'))
+    n.newline()
+
+n.build('shared', 'phony', shared_targets)
+n.newline()
+
+# Standalone checks which need no game files, and exit with a non-zero status on failure. Checks
+# of the engine link every object but the entry point
+tests = {
+    'frsqrt': (os.path.join(test_dir, 'FrsqrtTest.cc'), False),
+    'ghostTimeline': (os.path.join(test_dir, 'GhostTimelineTest.cc'), True),
+}
+
+for test_name, (test_in_file, links_engine) in tests.items():
+    test_out_file = os.path.join('$builddir', test_in_file + '.o')
+    n.build(
+        test_out_file,
+        'cc',
+        test_in_file,
+        variables={
+            'ccflags': ' '.join([*common_ccflags, *target_cflags])
+        }
+    )
+    test_exe = os.path.join('$outdir', test_dir, f'{test_name}{file_extension}')
+    default_targets.append(test_exe)
+    n.build(
+        test_exe,
+        'ld',
+        [test_out_file, *(engine_code_out_files if links_engine else [])],
+        variables={
+            'ldflags': ' '.join([
+                *common_ldflags,
+            ])
+        },
+    )
+    n.newline()
+
+n.default(default_targets)
+n.newline()
+
 n.variable('configure', 'configure.py')
 n.newline()
 
@@ -417,7 +417,7 @@ static inline constexpr u32 f2u(f32 val) {
     return std::bit_cast<u32>(val);
 }
 
-// The size of memory blocks that are allocated for game heap space.
+// The default size of the memory block that is allocated for game heap space.
 static constexpr size_t MEMORY_SPACE_SIZE = 0x1000000;
 
 #ifdef BUILD_DEBUG
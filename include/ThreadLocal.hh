@@ -0,0 +1,12 @@
+#pragma once
+
+/// @brief Declares the engine's statics, which are per thread so that races can run concurrently.
+/// @details Defining BUILD_SINGLE_THREADED makes them plain statics instead, which removes the cost
+/// of thread-local access from every frame, at the expense of only simulating on one thread.
+#ifdef BUILD_SINGLE_THREADED
+#define THREAD_LOCAL
+#define THREAD_LOCAL_STATICS false
+#else
+#define THREAD_LOCAL thread_local
+#define THREAD_LOCAL_STATICS true
+#endif
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <Logger.hh>
+#include <ThreadLocal.hh>
 
 #include <egg/core/Heap.hh>
 
@@ -0,0 +1,134 @@
+#pragma once
+
+/// @file kinoko.h
+/// @brief C interface for driving races in-process, for hosts that can't link C++ directly.
+/// @details Link against the kinoko shared library, and call kinoko_init once before anything
+/// else. The engine is a process-wide singleton, so only one race exists at a time, and every call
+/// must be made from the thread that called kinoko_init. Functions return KINOKO_OK on success, or
+/// a negative KinokoStatus. Fatal engine errors, such as missing game files, still abort the
+/// process.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#ifdef KINOKO_BUILD
+#define KINOKO_API __declspec(dllexport)
+#else
+#define KINOKO_API __declspec(dllimport)
+#endif
+#elif defined(__GNUC__)
+#define KINOKO_API __attribute__((visibility("default")))
+#else
+#define KINOKO_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// @brief Incremented whenever a declaration in this file changes incompatibly.
+#define KINOKO_API_VERSION 1
+
+typedef enum KinokoStatus {
+    KINOKO_OK = 0,
+    KINOKO_ERROR_INVALID_ARGUMENT = -1,
+    KINOKO_ERROR_NOT_INITIALIZED = -2, ///< kinoko_init has not been called.
+    KINOKO_ERROR_ALREADY_INITIALIZED = -3,
+    KINOKO_ERROR_NO_RACE = -4,         ///< No race has been created yet.
+    KINOKO_ERROR_NOT_HOST = -5,        ///< The race's player is driven by a ghost.
+    KINOKO_ERROR_INVALID_INPUTS = -6,  ///< The inputs were set, but can't occur on a controller.
+    KINOKO_ERROR_STALE_CONTEXT = -7,   ///< The context was saved in a previous race.
+    KINOKO_ERROR_INVALID_GHOST = -8,   ///< The ghost file is malformed or can't be replayed.
+} KinokoStatus;
+
+/// @brief Mirrors System::RaceManager::Stage.
+typedef enum KinokoStage {
+    KINOKO_STAGE_INTRO = 0,
+    KINOKO_STAGE_COUNTDOWN = 1,
+    KINOKO_STAGE_RACE = 2,
+    KINOKO_STAGE_FINISH_LOCAL = 3,
+    KINOKO_STAGE_FINISH_GLOBAL = 4,
+} KinokoStage;
+
+/// @brief Mirrors System::Trick.
+typedef enum KinokoTrick {
+    KINOKO_TRICK_NONE = 0,
+    KINOKO_TRICK_UP = 1,
+    KINOKO_TRICK_DOWN = 2,
+    KINOKO_TRICK_LEFT = 3,
+    KINOKO_TRICK_RIGHT = 4,
+} KinokoTrick;
+
+/// @brief Mirrors the buttons of System::RaceInputState.
+typedef enum KinokoButton {
+    KINOKO_BUTTON_ACCELERATE = 0x1,
+    KINOKO_BUTTON_BRAKE = 0x2, ///< Also drifts while accelerating.
+    KINOKO_BUTTON_ITEM = 0x4,
+    KINOKO_BUTTON_DRIFT = 0x8, ///< Set if braking after accelerating.
+} KinokoButton;
+
+/// @brief Engine options, which are the library's equivalent of the generic command line options.
+/// @details Zero-initialize for the defaults.
+typedef struct KinokoConfig {
+    size_t arenaSize;         ///< See --arena-size. 0 uses the default of 16 MiB.
+    size_t retainBudget;      ///< See --retain-archives. 0 disables retained archives.
+    const char *archiveCache; ///< See --cache. NULL disables the archive cache.
+    int32_t sizeClasses;      ///< See --size-classes.
+    int32_t headless;         ///< See --headless.
+    int32_t incremental;      ///< Whether contexts only copy the pages written since last synced.
+} KinokoConfig;
+
+/// @brief A race driven through kinoko_set_inputs. Values are those of Course, Character and
+/// Vehicle in Common.hh.
+typedef struct KinokoRaceParams {
+    int32_t course;
+    int32_t character;
+    int32_t vehicle;
+    int32_t driftIsAuto; ///< Non-zero for automatic drift.
+} KinokoRaceParams;
+
+/// @brief The player's kart, as compared by test cases, along with the race's progress.
+/// @details Quaternions are stored as x, y, z, w.
+typedef struct KinokoKartState {
+    float pos[3];
+    float fullRot[4];
+    float extVel[3];
+    float intVel[3];
+    float speed;
+    float acceleration;
+    float softSpeedLimit;
+    float mainRot[4];
+    float angVel2[3];
+    float raceCompletion;
+    uint32_t frame; ///< Frames stepped since the race was created.
+    uint16_t checkpointId;
+    int8_t jugemId;
+    uint8_t stage; ///< A KinokoStage.
+} KinokoKartState;
+
+/// @brief A saved race state, which can be restored any number of times within the same race.
+typedef struct KinokoContext KinokoContext;
+
+KINOKO_API uint32_t kinoko_api_version(void);
+
+KINOKO_API int32_t kinoko_init(const KinokoConfig *config);
+
+KINOKO_API int32_t kinoko_race_create(const KinokoRaceParams *params);
+KINOKO_API int32_t kinoko_race_create_ghost(const void *rkg, size_t size);
+
+KINOKO_API int32_t kinoko_set_inputs(uint16_t buttons, float stickX, float stickY,
+        int32_t trick);
+KINOKO_API int32_t kinoko_set_inputs_raw(uint16_t buttons, uint8_t stickXRaw, uint8_t stickYRaw,
+        int32_t trick);
+KINOKO_API int32_t kinoko_step(uint32_t frameCount);
+KINOKO_API int32_t kinoko_get_kart_state(KinokoKartState *state);
+
+KINOKO_API KinokoContext *kinoko_context_create(void);
+KINOKO_API int32_t kinoko_context_save(KinokoContext *context);
+KINOKO_API int32_t kinoko_context_restore(const KinokoContext *context);
+KINOKO_API void kinoko_context_destroy(KinokoContext *context);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
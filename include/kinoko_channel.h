@@ -0,0 +1,106 @@
+#pragma once
+
+/// @file kinoko_channel.h
+/// @brief Shared-memory layout of the channel that drives `kinoko host` from another process.
+/// @details The agent creates a POSIX shared memory object of sizeof(KinokoChannel) bytes, zeroes
+/// it, fills in the magic, version, race and its PID, and then runs `kinoko host --channel <name>`.
+/// Once the race is created, Kinoko sets the status to KINOKO_CHANNEL_READY and pushes the state at
+/// the start of the race. From then on, every input the agent pushes is answered by exactly one
+/// state, until Kinoko sets the status to KINOKO_CHANNEL_CLOSED or KINOKO_CHANNEL_ERROR.
+///
+/// Each ring has a single producer and a single consumer. The producer writes the entry at
+/// `head % KINOKO_CHANNEL_RING_SIZE`, then increments `head` with release semantics. The consumer
+/// reads the entry once it observes `head` with acquire semantics, then increments `tail` with
+/// release semantics. Cursors wrap around at 2^32. Either side may spin on a cursor, or set its
+/// `waiting` flag, check the cursor again and futex-wait on its value. After incrementing a cursor,
+/// a side must wake it if its `waiting` flag is set. Both of these accesses to the cursor and its
+/// flag must be sequentially consistent. Agents in C can use the __atomic builtins on the fields.
+///
+/// Neither side should wait forever, as the other side may exit without closing the channel.
+/// Kinoko wakes at least every KINOKO_CHANNEL_CHECK_INTERVAL_MS while waiting, and stops once
+/// `agentClosed` is set or the process `agentPid` has exited. Agents should likewise time their
+/// futex waits, and stop once the status is KINOKO_CHANNEL_CLOSED or KINOKO_CHANNEL_ERROR, or the
+/// process `kinokoPid` has exited. A side that closes the channel wakes every cursor the other side
+/// waits on.
+
+#include <kinoko.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define KINOKO_CHANNEL_MAGIC 0x4B43484E // KCHN
+
+/// @brief Incremented whenever the layout in this file changes incompatibly.
+#define KINOKO_CHANNEL_VERSION 2
+
+/// @brief The number of entries in each ring, which is a power of two.
+#define KINOKO_CHANNEL_RING_SIZE 64
+
+/// @brief Cursors are kept on separate cache lines, so that both sides don't contend for them.
+#define KINOKO_CHANNEL_CACHE_LINE 64
+
+/// @brief The longest Kinoko sleeps on a cursor before checking that the agent is still running.
+#define KINOKO_CHANNEL_CHECK_INTERVAL_MS 100
+
+typedef enum KinokoChannelStatus {
+    KINOKO_CHANNEL_WAITING = 0, ///< Kinoko hasn't created the race yet.
+    KINOKO_CHANNEL_READY = 1,   ///< The race is created, and Kinoko is reading inputs.
+    KINOKO_CHANNEL_CLOSED = 2,  ///< Kinoko has stopped reading inputs.
+    KINOKO_CHANNEL_ERROR = 3,   ///< Kinoko has stopped after an input it couldn't handle.
+} KinokoChannelStatus;
+
+/// @brief What Kinoko does with an input. Any other command is answered with the unchanged state,
+/// after which Kinoko sets the status to KINOKO_CHANNEL_ERROR and stops.
+typedef enum KinokoChannelCommand {
+    KINOKO_CHANNEL_STEP = 0,  ///< Simulates a frame with the input.
+    KINOKO_CHANNEL_RESET = 1, ///< Restores the start of the race. The input is ignored.
+    KINOKO_CHANNEL_QUIT = 2,  ///< Closes the channel. No state is pushed in response.
+} KinokoChannelCommand;
+
+/// @brief An input pushed by the agent.
+typedef struct KinokoChannelInput {
+    uint32_t command;  ///< A KinokoChannelCommand.
+    uint16_t buttons;  ///< KinokoButton flags.
+    uint8_t stickXRaw; ///< In the range [0, 14], where 7 is neutral.
+    uint8_t stickYRaw; ///< In the range [0, 14], where 7 is neutral.
+    int32_t trick;     ///< A KinokoTrick.
+} KinokoChannelInput;
+
+typedef struct KinokoChannelCursor {
+    uint32_t value;   ///< The number of entries pushed (head) or popped (tail).
+    uint32_t waiting; ///< Non-zero while the other side may be futex-waiting on the value.
+    uint8_t padding[KINOKO_CHANNEL_CACHE_LINE - 2 * sizeof(uint32_t)];
+} KinokoChannelCursor;
+
+/// @brief Inputs, from the agent to Kinoko.
+typedef struct KinokoChannelInputRing {
+    KinokoChannelCursor head;
+    KinokoChannelCursor tail;
+    KinokoChannelInput entries[KINOKO_CHANNEL_RING_SIZE];
+} KinokoChannelInputRing;
+
+/// @brief The state after each input, from Kinoko to the agent. KinokoKartState::frame counts the
+/// frames stepped since the race was created or last reset.
+typedef struct KinokoChannelStateRing {
+    KinokoChannelCursor head;
+    KinokoChannelCursor tail;
+    KinokoKartState entries[KINOKO_CHANNEL_RING_SIZE];
+} KinokoChannelStateRing;
+
+typedef struct KinokoChannel {
+    uint32_t magic;        ///< KINOKO_CHANNEL_MAGIC, set by the agent.
+    uint32_t version;      ///< KINOKO_CHANNEL_VERSION, set by the agent.
+    KinokoRaceParams race; ///< The race to create, set by the agent.
+    uint32_t status;       ///< A KinokoChannelStatus, set by Kinoko.
+    uint32_t agentPid;     ///< The agent's process ID, set by the agent, or 0 to not check it.
+    uint32_t agentClosed;  ///< Non-zero once the agent has stopped using the channel.
+    uint32_t kinokoPid;    ///< Kinoko's process ID, set by Kinoko when it opens the channel.
+    uint8_t padding[KINOKO_CHANNEL_CACHE_LINE - 6 * sizeof(uint32_t) - sizeof(KinokoRaceParams)];
+    KinokoChannelInputRing inputs;
+    KinokoChannelStateRing states;
+} KinokoChannel;
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
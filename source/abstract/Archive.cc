@@ -1,9 +1,68 @@
 #include "Archive.hh"
 
+#include <bit>
 #include <cstring>
 
 namespace Kinoko::Abstract {
 
+static constexpr u32 HASH_BASIS = 0x811C9DC5;
+static constexpr u32 HASH_PRIME = 0x01000193;
+
+/// @brief Advances a 32-bit FNV-1a hash by one character.
+static u32 HashStep(u32 hash, char c) {
+    return (hash ^ static_cast<u8>(c)) * HASH_PRIME;
+}
+
+static bool IsCurrentDirectory(const char *name) {
+    return name[0] == '.' && name[1] == '\0';
+}
+
+/// @brief Sizes a hash table to be at most half full.
+static size_t IndexCapacity(size_t count) {
+    return std::bit_ceil(2 * count + 1);
+}
+
+static size_t IndexSlot(u32 nameHash, u32 anchor, size_t capacity) {
+    return (nameHash ^ (anchor * 0x9E3779B1)) & (capacity - 1);
+}
+
+static const ArchiveHandle::PathIndexEntry *FindIndexEntry(
+        std::span<const ArchiveHandle::PathIndexEntry> index, u32 nameHash, u32 nameLength,
+        u32 anchor) {
+    if (index.empty()) {
+        return nullptr;
+    }
+
+    for (size_t slot = IndexSlot(nameHash, anchor, index.size());; ++slot) {
+        const auto &entry = index[slot & (index.size() - 1)];
+        if (entry.entryId == 0) {
+            return nullptr;
+        }
+
+        if (entry.nameHash == nameHash && entry.nameLength == nameLength &&
+                entry.anchor == anchor) {
+            return &entry;
+        }
+    }
+}
+
+/// @brief Inserts an entry into a hash table, unless its key is already present.
+static void InsertIndexEntry(owning_span<ArchiveHandle::PathIndexEntry> &index,
+        const ArchiveHandle::PathIndexEntry &entry) {
+    for (size_t slot = IndexSlot(entry.nameHash, entry.anchor, index.size());; ++slot) {
+        auto &other = index[slot & (index.size() - 1)];
+        if (other.entryId == 0) {
+            other = entry;
+            return;
+        }
+
+        if (other.nameHash == entry.nameHash && other.nameLength == entry.nameLength &&
+                other.anchor == entry.anchor) {
+            return;
+        }
+    }
+}
+
 /// @addr{0x80124500}
 ArchiveHandle::ArchiveHandle(void *archiveStart) : m_startAddress(archiveStart) {
     RawArchive *rawArchive = reinterpret_cast<RawArchive *>(archiveStart);
@@ -17,6 +76,10 @@ ArchiveHandle::ArchiveHandle(void *archiveStart) : m_startAddress(archiveStart)
     // Strings exist directly after the last node
     m_strings = reinterpret_cast<const char *>(&m_nodes[m_count]);
     m_currentNode = 0;
+
+    if (s_pathIndexEnabled) {
+        buildPathIndex();
+    }
 }
 
 /// @addr{0x80124894}
@@ -64,39 +127,129 @@ s32 ArchiveHandle::convertPathToEntryId(const char *path) const {
         bool endOfPath = nameEnd[0] == '\0';
         s32 nameLength = nameEnd - path;
 
-        bool found = false;
-        const u32 anchor = entryId++;
-        while (entryId < parse<u32>(node(anchor)->directory.next)) {
-            if (!node(anchor)->isDirectory() && endOfPath) {
-                entryId++;
-                continue;
-            }
+        s32 found = findEntry(entryId, path, nameLength, endOfPath);
+        if (found < 0) {
+            return -1;
+        }
 
-            const char *entryName = m_strings + node(entryId)->stringOffset();
+        entryId = found;
 
-            if (entryName[0] == '.' && entryName[1] == '\0') {
-                entryId++;
+        if (endOfPath) {
+            return entryId;
+        }
+
+        path += nameLength + 1;
+    }
+}
+
+/// @brief Indexes every path component that findEntry can resolve.
+/// @details Not in the base game. Searching a directory visits every entry in its subtree, in
+/// order, and stops at the first entry whose name begins with the component. This is matched by
+/// mapping each directory and name prefix to the first entry found. Prefixes that aren't the name
+/// of any entry are left out, as they aren't looked up in practice.
+void ArchiveHandle::buildPathIndex() {
+    owning_span<PathIndexEntry> names(IndexCapacity(m_count));
+    for (u32 i = 1; i < m_count; ++i) {
+        const char *name = entryName(i);
+        if (IsCurrentDirectory(name)) {
+            continue;
+        }
+
+        u32 hash = HASH_BASIS;
+        u32 length = 0;
+        for (; name[length] != '\0'; ++length) {
+            hash = HashStep(hash, name[length]);
+        }
+
+        InsertIndexEntry(names, {hash, length, 0, static_cast<s32>(i)});
+    }
+
+    size_t count = 0;
+    forEachIndexedName(names.view(), [&](const PathIndexEntry &) { ++count; });
+
+    m_pathIndex = owning_span<PathIndexEntry>(IndexCapacity(count));
+    forEachIndexedName(names.view(),
+            [&](const PathIndexEntry &entry) { InsertIndexEntry(m_pathIndex, entry); });
+}
+
+/// @brief Calls back with every directory and name prefix that findEntry can resolve.
+/// @details Entries are visited in the same order as a search, so the first entry for each key is
+/// the one that search finds.
+/// @param names Every entry name in the archive, with an anchor of 0.
+template <typename F>
+void ArchiveHandle::forEachIndexedName(std::span<const PathIndexEntry> names,
+        F &&callback) const {
+    for (u32 anchor = 0; anchor < m_count; ++anchor) {
+        if (!node(anchor)->isDirectory()) {
+            continue;
+        }
+
+        u32 end = parse<u32>(node(anchor)->directory.next);
+        for (u32 i = anchor + 1; i < end; ++i) {
+            const char *name = entryName(i);
+            if (IsCurrentDirectory(name)) {
                 continue;
             }
 
-            if (strncmp(path, entryName, nameLength) == 0) {
-                found = true;
-                break;
+            u32 hash = HASH_BASIS;
+            for (u32 length = 1; name[length - 1] != '\0'; ++length) {
+                hash = HashStep(hash, name[length - 1]);
+                if (FindIndexEntry(names, hash, length, 0)) {
+                    callback(PathIndexEntry{hash, length, anchor, static_cast<s32>(i)});
+                }
             }
+        }
+    }
+}
 
+/// @brief Finds the entry a path component refers to, searching from a directory.
+/// @details Not in the base game. Uses the path index if possible, which gives the same result as
+/// scanEntry.
+/// @return The entry ID, or -1 if not found.
+s32 ArchiveHandle::findEntry(u32 anchor, const char *name, s32 nameLength, bool endOfPath) const {
+    if (s_pathIndexEnabled && node(anchor)->isDirectory()) {
+        u32 hash = HASH_BASIS;
+        for (s32 i = 0; i < nameLength; ++i) {
+            hash = HashStep(hash, name[i]);
+        }
+
+        // Hashes may collide, so the entry found must also begin with the component
+        const auto *entry = FindIndexEntry(m_pathIndex.view(), hash, nameLength, anchor);
+        if (entry && strncmp(name, entryName(entry->entryId), nameLength) == 0) {
+            return entry->entryId;
+        }
+    }
+
+    return scanEntry(anchor, name, nameLength, endOfPath);
+}
+
+/// @brief Finds the entry a path component refers to by scanning a directory's subtree.
+/// @addr{Inlined in 0x80124894}
+/// @return The entry ID, or -1 if not found.
+s32 ArchiveHandle::scanEntry(u32 anchor, const char *name, s32 nameLength, bool endOfPath) const {
+    u32 entryId = anchor + 1;
+
+    while (entryId < parse<u32>(node(anchor)->directory.next)) {
+        if (!node(anchor)->isDirectory() && endOfPath) {
             entryId++;
+            continue;
         }
 
-        if (!found) {
-            return -1;
+        const char *entryName_ = entryName(entryId);
+
+        if (entryName_[0] == '.' && entryName_[1] == '\0') {
+            entryId++;
+            continue;
         }
 
-        if (endOfPath) {
+        if (strncmp(name, entryName_, nameLength) == 0) {
             return entryId;
         }
 
-        path += nameLength + 1;
+        entryId++;
     }
+
+    return -1;
 }
 
 /// @addr{0x80124844}
@@ -115,4 +268,6 @@ bool ArchiveHandle::open(s32 entryId, FileInfo &info) const {
     return true;
 }
 
+bool ArchiveHandle::s_pathIndexEnabled = true;
+
 } // namespace Kinoko::Abstract
@@ -52,6 +52,14 @@ public:
         u32 length;
     };
 
+    /// @brief Maps a path component, searched for from a directory, to the entry that is found.
+    struct PathIndexEntry {
+        u32 nameHash;
+        u32 nameLength;
+        u32 anchor;  ///< The directory the search starts from.
+        s32 entryId; ///< 0 if the slot is empty, as the root is never the result of a search.
+    };
+
     ArchiveHandle(void *archiveStart);
 
     [[nodiscard]] s32 convertPathToEntryId(const char *path) const;
@@ -70,12 +78,37 @@ public:
         return m_startAddress;
     }
 
+    [[nodiscard]] u32 count() const {
+        return m_count;
+    }
+
+    [[nodiscard]] const char *entryName(s32 entryId) const {
+        return m_strings + node(entryId)->stringOffset();
+    }
+
+    /// @brief Sets whether archives index their paths. Only useful to measure the index.
+    static void SetPathIndexEnabled(bool enabled) {
+        s_pathIndexEnabled = enabled;
+    }
+
 private:
+    void buildPathIndex();
+    template <typename F>
+    void forEachIndexedName(std::span<const PathIndexEntry> names, F &&callback) const;
+
+    [[nodiscard]] s32 findEntry(u32 anchor, const char *name, s32 nameLength,
+            bool endOfPath) const;
+    [[nodiscard]] s32 scanEntry(u32 anchor, const char *name, s32 nameLength,
+            bool endOfPath) const;
+
     void *m_startAddress;
     Node *m_nodes;
     u32 m_count;
     u32 m_currentNode;
     const char *m_strings;
+    owning_span<PathIndexEntry> m_pathIndex; ///< Hash table of every component findEntry resolves.
+
+    static bool s_pathIndexEnabled;
 };
 
 } // namespace Kinoko::Abstract
@@ -0,0 +1,244 @@
+#include "ArchiveCache.hh"
+
+#include <egg/core/Heap.hh>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define ARCHIVE_CACHE_MMAP
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Kinoko::Abstract::ArchiveCache {
+
+static constexpr u32 CACHE_SIGNATURE = 0x4B415243; // KARC
+static constexpr u32 CACHE_VERSION = 1;
+
+static char s_directory[256] = {};
+static Stats s_stats = {0, 0};
+
+/// @brief 64-bit FNV-1a, consuming eight bytes at a time.
+/// @details This is not meant to resist collisions crafted on purpose, only to notice that a source
+/// file has changed.
+static u64 Hash(const void *data, size_t size, u64 hash = 0xCBF29CE484222325) {
+    constexpr u64 PRIME = 0x100000001B3;
+
+    const u8 *bytes = static_cast<const u8 *>(data);
+    for (; size >= sizeof(u64); size -= sizeof(u64), bytes += sizeof(u64)) {
+        u64 word;
+        memcpy(&word, bytes, sizeof(word));
+        hash = (hash ^ word) * PRIME;
+    }
+
+    for (; size > 0; --size, ++bytes) {
+        hash = (hash ^ *bytes) * PRIME;
+    }
+
+    return hash;
+}
+
+/// @brief Formats the path of the cache entry for a key.
+static void GetEntryPath(char *buffer, size_t bufferSize, const Key &key) {
+    u64 entryHash = Hash(key.path, strlen(key.path), key.sourceHash ^ key.sourceSize);
+    snprintf(buffer, bufferSize, "%s/%016llx.u8", s_directory,
+            static_cast<unsigned long long>(entryHash));
+}
+
+/// @brief Counts a lookup, which may happen on any thread that loads archives.
+static void CountLookup(u32 &counter) {
+    std::atomic_ref<u32>(counter).fetch_add(1, std::memory_order_relaxed);
+}
+
+/// @brief Maps or reads an entire cache entry.
+/// @return The entry, or nullptr if it doesn't exist.
+static CacheHeader *ReadEntry(const char *entryPath, size_t &entrySize) {
+#ifdef ARCHIVE_CACHE_MMAP
+    int fd = open(entryPath, O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    struct stat st;
+    void *entry = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(CacheHeader)) {
+        entrySize = static_cast<size_t>(st.st_size);
+
+        // Private and writable, so that the archive behaves like a heap buffer without writes ever
+        // reaching the cache
+        entry = mmap(nullptr, entrySize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    }
+
+    close(fd);
+    return entry != MAP_FAILED ? static_cast<CacheHeader *>(entry) : nullptr;
+#else
+    std::ifstream stream(entryPath, std::ios::binary);
+    if (!stream) {
+        return nullptr;
+    }
+
+    stream.seekg(0, std::ios::end);
+    entrySize = static_cast<size_t>(stream.tellg());
+    stream.seekg(0, std::ios::beg);
+    if (entrySize < sizeof(CacheHeader)) {
+        return nullptr;
+    }
+
+    auto *entry = static_cast<CacheHeader *>(EGG::egg_alloc(entrySize, 32));
+    stream.read(reinterpret_cast<char *>(entry), entrySize);
+    if (!stream) {
+        EGG::egg_free(entry);
+        return nullptr;
+    }
+
+    return entry;
+#endif // ARCHIVE_CACHE_MMAP
+}
+
+/// @brief Frees a cache entry returned by ReadEntry.
+static void FreeEntry(CacheHeader *entry, size_t entrySize) {
+#ifdef ARCHIVE_CACHE_MMAP
+    munmap(entry, entrySize);
+#else
+    (void)entrySize;
+    EGG::egg_free(entry);
+#endif // ARCHIVE_CACHE_MMAP
+}
+
+/// @brief Sets the directory cache entries are kept in, which is created on the first store.
+/// @param directory The directory, or nullptr to disable the cache.
+void SetDirectory(const char *directory) {
+    if (!directory) {
+        s_directory[0] = '\0';
+        return;
+    }
+
+    if (strlen(directory) >= sizeof(s_directory)) {
+        PANIC("Archive cache directory path is too long: %s", directory);
+    }
+
+    snprintf(s_directory, sizeof(s_directory), "%s", directory);
+}
+
+bool IsEnabled() {
+    return s_directory[0] != '\0';
+}
+
+/// @brief Hashes a compressed archive to look up or store its decompressed form.
+/// @param path The path the archive was loaded from.
+/// @param source The compressed archive.
+/// @param sourceSize The size of the compressed archive.
+Key CreateKey(const char *path, const void *source, size_t sourceSize) {
+    Key key;
+    key.path = strlen(path) < sizeof(CacheHeader::path) ? path : nullptr;
+    key.sourceSize = sourceSize;
+    key.sourceHash = Hash(source, sourceSize);
+    return key;
+}
+
+/// @brief Looks up the decompressed archive for a key.
+/// @param key The key created from the compressed archive.
+/// @param size Set to the size of the decompressed archive, if found.
+/// @return The decompressed archive, which must be freed with Release, or nullptr if not cached.
+void *Load(const Key &key, size_t &size) {
+    if (!IsEnabled() || !key.path) {
+        return nullptr;
+    }
+
+    char entryPath[512];
+    GetEntryPath(entryPath, sizeof(entryPath), key);
+
+    size_t entrySize = 0;
+    CacheHeader *header = ReadEntry(entryPath, entrySize);
+    if (!header) {
+        CountLookup(s_stats.misses);
+        return nullptr;
+    }
+
+    // Entries are only ever renamed into place once complete, but may belong to another key that
+    // hashes to the same entry path
+    bool valid = header->signature == CACHE_SIGNATURE && header->version == CACHE_VERSION &&
+            header->sourceSize == key.sourceSize && header->sourceHash == key.sourceHash &&
+            header->archiveSize == entrySize - sizeof(CacheHeader) &&
+            strncmp(header->path, key.path, sizeof(header->path)) == 0;
+
+    if (!valid) {
+        FreeEntry(header, entrySize);
+        CountLookup(s_stats.misses);
+        return nullptr;
+    }
+
+    CountLookup(s_stats.hits);
+    size = header->archiveSize;
+    return header + 1;
+}
+
+/// @brief Writes the decompressed archive for a key to the cache, replacing any existing entry.
+/// @details Failures are reported, but not fatal, as the archive is already decompressed.
+/// @param key The key created from the compressed archive.
+/// @param archive The decompressed archive.
+/// @param size The size of the decompressed archive.
+void Store(const Key &key, const void *archive, size_t size) {
+    if (!IsEnabled() || !key.path) {
+        return;
+    }
+
+    CacheHeader header;
+    memset(&header, 0, sizeof(header));
+    header.signature = CACHE_SIGNATURE;
+    header.version = CACHE_VERSION;
+    header.sourceSize = key.sourceSize;
+    header.sourceHash = key.sourceHash;
+    header.archiveSize = size;
+    snprintf(header.path, sizeof(header.path), "%s", key.path);
+
+    std::error_code ec;
+    std::filesystem::create_directories(s_directory, ec);
+
+    char entryPath[512];
+    char tempPath[544];
+    GetEntryPath(entryPath, sizeof(entryPath), key);
+    snprintf(tempPath, sizeof(tempPath), "%s.%llx.%zx.tmp", entryPath,
+            static_cast<unsigned long long>(
+                    std::chrono::steady_clock::now().time_since_epoch().count()),
+            std::hash<std::thread::id>{}(std::this_thread::get_id()));
+
+    {
+        std::ofstream stream(tempPath, std::ios::binary);
+        stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        stream.write(static_cast<const char *>(archive), size);
+
+        if (!stream) {
+            WARN("Failed to write archive cache entry %s", tempPath);
+            stream.close();
+            std::filesystem::remove(tempPath, ec);
+            return;
+        }
+    }
+
+    std::filesystem::rename(tempPath, entryPath, ec);
+    if (ec) {
+        WARN("Failed to store archive cache entry %s", entryPath);
+        std::filesystem::remove(tempPath, ec);
+    }
+}
+
+/// @brief Frees a decompressed archive returned by Load.
+void Release(void *archive) {
+    CacheHeader *header = static_cast<CacheHeader *>(archive) - 1;
+    FreeEntry(header, sizeof(CacheHeader) + header->archiveSize);
+}
+
+const Stats &GetStats() {
+    return s_stats;
+}
+
+} // namespace Kinoko::Abstract::ArchiveCache
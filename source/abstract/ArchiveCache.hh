@@ -0,0 +1,44 @@
+#pragma once
+
+#include <Common.hh>
+
+// On-disk cache of decompressed archives, to skip decoding SZS files on every launch. Entries are
+// keyed by the archive's path, and the size and hash of its compressed source.
+
+namespace Kinoko::Abstract::ArchiveCache {
+
+/// @brief Precedes the decompressed U8 archive in every cache entry.
+struct CacheHeader {
+    u32 signature;
+    u32 version;
+    u64 sourceSize;
+    u64 sourceHash;
+    u64 archiveSize;
+    char path[224];
+};
+STATIC_ASSERT(sizeof(CacheHeader) == 0x100);
+
+/// @brief Identifies the decompressed form of a compressed archive.
+struct Key {
+    const char *path; ///< nullptr if the path is too long to be cached.
+    u64 sourceSize;
+    u64 sourceHash;
+};
+
+/// @brief Counts how archive loads were served since launch.
+struct Stats {
+    u32 hits;
+    u32 misses;
+};
+
+void SetDirectory(const char *directory);
+[[nodiscard]] bool IsEnabled();
+
+[[nodiscard]] Key CreateKey(const char *path, const void *source, size_t sourceSize);
+[[nodiscard]] void *Load(const Key &key, size_t &size);
+void Store(const Key &key, const void *archive, size_t size);
+void Release(void *archive);
+
+[[nodiscard]] const Stats &GetStats();
+
+} // namespace Kinoko::Abstract::ArchiveCache
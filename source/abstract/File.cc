@@ -6,14 +6,19 @@
 
 namespace Kinoko::Abstract::File {
 
-u8 *Load(const char *path, size_t &size) {
-    char filepath[256];
-
+/// @brief Resolves a game path, which is always relative to the working directory.
+static void GetFilePath(const char *path, char (&filepath)[256]) {
     if (path[0] == '/') {
         path++;
     }
 
     snprintf(filepath, sizeof(filepath), "./%s", path);
+}
+
+u8 *Load(const char *path, size_t &size) {
+    char filepath[256];
+    GetFilePath(path, filepath);
+
     std::ifstream file(filepath, std::ios::binary);
     if (!file) {
         PANIC("File with provided path %s was not loaded correctly!", path);
@@ -29,6 +34,14 @@ u8 *Load(const char *path, size_t &size) {
     return buffer;
 }
 
+/// @brief Checks whether Load() would find a file, without panicking if it doesn't.
+bool Exists(const char *path) {
+    char filepath[256];
+    GetFilePath(path, filepath);
+
+    return std::ifstream(filepath, std::ios::binary).good();
+}
+
 void Append(const char *path, const char *data, size_t size) {
     std::ofstream stream;
     stream.open(path, std::ios::app | std::ios::binary);
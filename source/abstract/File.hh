@@ -5,6 +5,7 @@
 namespace Kinoko::Abstract::File {
 
 [[nodiscard]] u8 *Load(const char *path, size_t &size);
+[[nodiscard]] bool Exists(const char *path);
 void Append(const char *path, const char *data, size_t size);
 int Remove(const char *path);
 
@@ -0,0 +1,190 @@
+#include "Profiler.hh"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace Kinoko::Abstract::Profiler {
+
+#ifdef BUILD_PROFILE
+static constexpr size_t STAGE_COUNT = static_cast<size_t>(Stage::Count);
+
+static constexpr std::array<const char *, STAGE_COUNT> STAGE_NAMES = {{
+        "RaceScene::calcEngines",
+        "RaceManager::calc",
+        "BoxColManager::calc",
+        "ObjectDirector::calc",
+        "KartObjectManager::calc",
+        "JugemDirector::calc",
+        "ItemDirector::calc",
+        "KartSub::calcPass0",
+        "KartMove::calc",
+        "KartPhysics::calc",
+        "KartSub::calcPass1",
+        "KartCollide::calcObjectCollision",
+        "KartCollide::findCollision",
+        "KartSuspensionPhysics::calcCollision",
+}};
+
+/// @brief Bounds the memory used by the trace to roughly 100 MB. Summaries cover every frame.
+static constexpr size_t MAX_TRACE_EVENTS = 4 * 1024 * 1024;
+
+/// @brief A single timed call, as written to the trace.
+struct Event {
+    Stage stage;
+    s64 startNs;
+    s64 endNs;
+};
+
+static bool s_enabled = false;
+
+// Per thread, so that races on other threads are recorded without racing the thread that writes
+// the report, which only covers its own races
+static THREAD_LOCAL std::vector<Event> s_events;
+/// @brief Per stage, time spent this frame.
+static THREAD_LOCAL std::array<s64, STAGE_COUNT> s_frameNs = {};
+/// @brief Per stage, whether it ran this frame.
+static THREAD_LOCAL std::array<bool, STAGE_COUNT> s_frameCalled = {};
+
+/// @brief Per stage, the time spent in it during each frame that it ran.
+static THREAD_LOCAL std::array<std::vector<s64>, STAGE_COUNT> s_samples;
+
+bool IsEnabled() {
+    return s_enabled;
+}
+
+/// @brief Adds a timed call to the current frame, and ends the frame once CalcEngines returns.
+void Record(Stage stage, s64 startNs, s64 endNs) {
+    size_t idx = static_cast<size_t>(stage);
+    s_frameNs[idx] += endNs - startNs;
+    s_frameCalled[idx] = true;
+
+    if (s_events.size() < MAX_TRACE_EVENTS) {
+        s_events.push_back({stage, startNs, endNs});
+    }
+
+    if (stage != Stage::CalcEngines) {
+        return;
+    }
+
+    for (size_t i = 0; i < STAGE_COUNT; ++i) {
+        if (s_frameCalled[i]) {
+            s_samples[i].push_back(s_frameNs[i]);
+        }
+    }
+
+    s_frameNs.fill(0);
+    s_frameCalled.fill(false);
+}
+
+/// @brief Writes a Chrome trace event file, which can be opened in chrome://tracing or Perfetto.
+static void WriteTrace(const char *path) {
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        WARN("Failed to open %s", path);
+        return;
+    }
+
+    constexpr f64 NS_PER_US = 1000.0;
+    s64 originNs = s_events.empty() ? 0 : s_events.front().startNs;
+    for (const auto &event : s_events) {
+        originNs = std::min(originNs, event.startNs);
+    }
+
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    for (size_t i = 0; i < s_events.size(); ++i) {
+        const Event &event = s_events[i];
+        fprintf(file, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+                i == 0 ? "" : ",", STAGE_NAMES[static_cast<size_t>(event.stage)],
+                static_cast<f64>(event.startNs - originNs) / NS_PER_US,
+                static_cast<f64>(event.endNs - event.startNs) / NS_PER_US);
+    }
+    fprintf(file, "\n]}\n");
+
+    fclose(file);
+}
+#endif // BUILD_PROFILE
+
+/// @brief Whether this build can profile, i.e. was built with BUILD_PROFILE defined.
+bool IsSupported() {
+#ifdef BUILD_PROFILE
+    return true;
+#else
+    return false;
+#endif // BUILD_PROFILE
+}
+
+/// @brief Starts timing stages.
+void Enable() {
+#ifdef BUILD_PROFILE
+    s_enabled = true;
+#else
+    PANIC("Profiling is compiled out. Rebuild with BUILD_PROFILE defined");
+#endif // BUILD_PROFILE
+}
+
+/// @brief Reports the time spent in each stage per frame, and writes a timeline of every call.
+/// @details The summary is printed, and written to `<prefix>.txt`. The timeline is written to
+/// `<prefix>.json` in the Chrome trace event format.
+/// @param prefix The path to write both files to, without an extension.
+void WriteReport(const char *prefix) {
+#ifdef BUILD_PROFILE
+    if (s_samples[static_cast<size_t>(Stage::CalcEngines)].empty()) {
+        WARN("No frames were profiled");
+        return;
+    }
+
+    constexpr f64 NS_PER_US = 1000.0;
+    std::string summary;
+    char line[256];
+
+    snprintf(line, sizeof(line), "%-40s %8s %10s %10s %10s\n", "Stage (us per frame)", "Frames",
+            "Min", "Mean", "P99");
+    summary += line;
+
+    for (size_t i = 0; i < STAGE_COUNT; ++i) {
+        std::vector<s64> samples = s_samples[i];
+        if (samples.empty()) {
+            continue;
+        }
+
+        std::sort(samples.begin(), samples.end());
+
+        f64 total = 0.0;
+        for (s64 sample : samples) {
+            total += static_cast<f64>(sample);
+        }
+
+        size_t p99 = (samples.size() * 99 + 99) / 100 - 1;
+        snprintf(line, sizeof(line), "%-40s %8zu %10.2f %10.2f %10.2f\n", STAGE_NAMES[i],
+                samples.size(), static_cast<f64>(samples.front()) / NS_PER_US,
+                total / static_cast<f64>(samples.size()) / NS_PER_US,
+                static_cast<f64>(samples[p99]) / NS_PER_US);
+        summary += line;
+    }
+
+    printf("%s", summary.c_str());
+
+    std::string path = std::string(prefix) + ".txt";
+    FILE *file = fopen(path.c_str(), "w");
+    if (file) {
+        fwrite(summary.data(), 1, summary.size(), file);
+        fclose(file);
+    } else {
+        WARN("Failed to open %s", path.c_str());
+    }
+
+    if (s_events.size() >= MAX_TRACE_EVENTS) {
+        WARN("The trace only covers the first %zu calls", MAX_TRACE_EVENTS);
+    }
+
+    path = std::string(prefix) + ".json";
+    WriteTrace(path.c_str());
+#else
+    (void)prefix;
+#endif // BUILD_PROFILE
+}
+
+} // namespace Kinoko::Abstract::Profiler
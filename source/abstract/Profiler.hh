@@ -0,0 +1,86 @@
+#pragma once
+
+#include <Common.hh>
+
+#ifdef BUILD_PROFILE
+#include <chrono>
+#endif // BUILD_PROFILE
+
+// Frame profiler for the engine's hot paths. Stages are only timed in builds with BUILD_PROFILE
+// defined, and only once enabled. Otherwise, the macros below compile to nothing.
+
+namespace Kinoko::Abstract::Profiler {
+
+/// @brief A timed section of a frame. Stages may nest, and CalcEngines delimits frames.
+enum class Stage {
+    CalcEngines,
+    RaceManager,
+    BoxColManager,
+    ObjectDirector,
+    KartObjectManager,
+    JugemDirector,
+    ItemDirector,
+    KartCalcPass0,
+    KartMove,
+    KartPhysics,
+    KartCalcPass1,
+    KartObjectCollision,
+    KartBodyCollision,
+    KartWheelCollision,
+    Count,
+};
+
+[[nodiscard]] bool IsSupported();
+void Enable();
+void WriteReport(const char *prefix);
+
+#ifdef BUILD_PROFILE
+[[nodiscard]] bool IsEnabled();
+void Record(Stage stage, s64 startNs, s64 endNs);
+
+[[nodiscard]] inline s64 Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+}
+
+/// @brief Times a stage for as long as it is in scope.
+class Scope {
+public:
+    Scope(Stage stage) : m_stage(stage), m_start(IsEnabled() ? Now() : -1) {}
+
+    ~Scope() {
+        if (m_start >= 0) {
+            Record(m_stage, m_start, Now());
+        }
+    }
+
+    Scope(const Scope &) = delete;
+    Scope(Scope &&) = delete;
+
+private:
+    Stage m_stage;
+    s64 m_start; ///< -1 if the profiler was disabled when the scope was entered.
+};
+#endif // BUILD_PROFILE
+
+} // namespace Kinoko::Abstract::Profiler
+
+#ifdef BUILD_PROFILE
+/// @brief Times the rest of the enclosing scope as the given stage.
+#define PROFILE_SCOPE(stage) \
+    Kinoko::Abstract::Profiler::Scope _profileScope(Kinoko::Abstract::Profiler::Stage::stage)
+
+/// @brief Times a single call as the given stage.
+#define PROFILE_CALL(stage, call) \
+    do { \
+        PROFILE_SCOPE(stage); \
+        call; \
+    } while (0)
+#else
+#define PROFILE_SCOPE(stage) \
+    do { \
+    } while (0)
+
+#define PROFILE_CALL(stage, call) call
+#endif // BUILD_PROFILE
@@ -24,6 +24,6 @@ f32 PlayPolicy_Loop(f32 start, f32 end, f32 frame) {
     return offset >= 0.0f ? offset : offset + length;
 }
 
-f32 FrameCtrl::s_baseUpdateRate = 1.0f;
+THREAD_LOCAL f32 FrameCtrl::s_baseUpdateRate = 1.0f;
 
 } // namespace Kinoko::Abstract::g3d
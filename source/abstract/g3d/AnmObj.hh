@@ -79,7 +79,7 @@ private:
     f32 m_endFrame;
     PlayPolicyFunc m_playPolicy;
 
-    static f32 s_baseUpdateRate;
+    static THREAD_LOCAL f32 s_baseUpdateRate;
 };
 
 } // namespace Kinoko::Abstract::g3d
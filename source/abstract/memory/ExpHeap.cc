@@ -95,6 +95,7 @@ MEMiExpHeapHead::MEMiExpHeapHead(void *end, u16 opt)
     m_tag = 0;
 #endif // BUILD_DEBUG
     m_attribute.makeAllZero();
+    m_bins.fill(nullptr);
 
     Region region = Region(getHeapStart(), getHeapEnd());
     MEMiExpBlockHead *block = MEMiExpBlockHead::createFree(region);
@@ -142,11 +143,22 @@ void *MEMiExpHeapHead::alloc(size_t size, s32 align) {
 
     void *block = nullptr;
     if (align >= 0) {
-        block = allocFromHead(size, align);
+        if (tstOptFlag(eOptFlag::SizeClasses)) {
+            block = allocFromBin(size, align);
+        }
+
+        if (!block) {
+            block = allocFromHead(size, align);
+        }
     } else {
         block = allocFromTail(size, -align);
     }
 
+    // Binned blocks may be all that stands in the way, so merge them and try again
+    if (!block && flushBins()) {
+        return alloc(size, align);
+    }
+
     return block;
 }
 
@@ -159,13 +171,24 @@ void MEMiExpHeapHead::free(void *block) {
     MEMiExpBlockHead *head =
             reinterpret_cast<MEMiExpBlockHead *>(SubOffset(block, sizeof(MEMiExpBlockHead)));
 
+    if (tstOptFlag(eOptFlag::SizeClasses) && freeToBin(head)) {
+        return;
+    }
+
     Region region = head->getRegion();
     m_usedBlocks.remove(head);
     recycleRegion(region);
 }
 
 /// @addr{0x80199180}
-u32 MEMiExpHeapHead::getAllocatableSize(s32 align) const {
+/// @details With the SizeClasses option, binned blocks are flushed first, which is why this isn't
+/// const. They are only held back from the free list until an allocation needs them, and merging
+/// them may form a larger block.
+u32 MEMiExpHeapHead::getAllocatableSize(s32 align) {
+    if (tstOptFlag(eOptFlag::SizeClasses)) {
+        flushBins();
+    }
+
     // Doesn't matter which direction it can be allocated from, take absolute value
     align = std::abs(align);
 
@@ -360,4 +383,107 @@ bool MEMiExpHeapHead::recycleRegion(const Region &initialRegion) {
     return true;
 }
 
+/// @brief Takes a block from the bin of the size class, refilling the smallest classes from a
+/// new pooled chunk if their bin is empty.
+/// @return The block's memory, or nullptr if the size isn't binned or no suitable block is cached.
+void *MEMiExpHeapHead::allocFromBin(size_t size, s32 alignment) {
+    u32 sizeClass = (size + SIZE_CLASS_GRANULE - 1) / SIZE_CLASS_GRANULE;
+    if (sizeClass > SIZE_CLASS_COUNT) {
+        return nullptr;
+    }
+
+    MEMiExpBlockHead *&bin = m_bins[sizeClass - 1];
+    if (!bin && sizeClass <= POOL_CLASS_COUNT) {
+        refillBin(sizeClass);
+    }
+
+    MEMiExpBlockHead *block = bin;
+    if (!block || (alignment > 1 && GetAddrNum(block->getMemoryStart()) % alignment != 0)) {
+        return nullptr;
+    }
+
+    bin = block->m_link.m_next;
+    block->m_link.m_next = nullptr;
+    block->m_attribute.fields.groupId = m_groupId;
+#ifdef BUILD_DEBUG
+    block->m_tag = ++m_tag;
+#endif // BUILD_DEBUG
+
+    m_usedBlocks.append(block);
+    fillAllocMemory(block->getMemoryStart(), block->m_size);
+
+    return block->getMemoryStart();
+}
+
+/// @brief Keeps a freed block in the bin of the largest size class it can serve.
+/// @details Only blocks allocated from the head are binned, as tail blocks are meant to be
+/// temporary. The block remains carved out of the free list until the bins are flushed.
+/// @return Whether the block was binned.
+bool MEMiExpHeapHead::freeToBin(MEMiExpBlockHead *block) {
+    if (block->m_attribute.fields.direction != 0) {
+        return false;
+    }
+
+    u32 sizeClass = block->m_size / SIZE_CLASS_GRANULE;
+    if (sizeClass == 0 || sizeClass > SIZE_CLASS_COUNT) {
+        return false;
+    }
+
+    m_usedBlocks.remove(block);
+    fillFreeMemory(block->getMemoryStart(), block->m_size);
+
+    block->m_link.m_prev = nullptr;
+    block->m_link.m_next = m_bins[sizeClass - 1];
+    m_bins[sizeClass - 1] = block;
+
+    return true;
+}
+
+/// @brief Carves a chunk from the head into blocks of a small size class, and bins all of them.
+/// @details Each block's memory is aligned to the granule. The first block also covers any padding
+/// before the chunk, and the last block any slack after it, so flushing returns the whole chunk.
+void MEMiExpHeapHead::refillBin(u32 sizeClass) {
+    constexpr u32 HEAD_SIZE = sizeof(MEMiExpBlockHead);
+    const u32 stride = RoundUp(HEAD_SIZE + sizeClass * SIZE_CLASS_GRANULE, SIZE_CLASS_GRANULE);
+
+    void *memory = allocFromHead(stride * POOL_BLOCK_COUNT - HEAD_SIZE, SIZE_CLASS_GRANULE);
+    if (!memory) {
+        return;
+    }
+
+    auto *chunk = static_cast<MEMiExpBlockHead *>(SubOffset(memory, HEAD_SIZE));
+    u16 padding = chunk->m_attribute.fields.alignment;
+    void *chunkEnd = chunk->getMemoryEnd();
+    m_usedBlocks.remove(chunk);
+
+    // Carve from the back, so that the bin hands out blocks in address order
+    MEMiExpBlockHead *&bin = m_bins[sizeClass - 1];
+    for (u32 i = POOL_BLOCK_COUNT; i-- > 0;) {
+        void *start = AddOffset(chunk, i * stride);
+        void *end = i + 1 == POOL_BLOCK_COUNT ? chunkEnd : AddOffset(start, stride);
+
+        MEMiExpBlockHead *block = MEMiExpBlockHead::createUsed(Region(start, end));
+        block->m_attribute.fields.alignment = i == 0 ? padding : 0;
+        block->m_link.m_next = bin;
+        bin = block;
+    }
+}
+
+/// @brief Returns every binned block to the free list, where it merges with its neighbors.
+/// @return Whether any block was returned.
+bool MEMiExpHeapHead::flushBins() {
+    bool flushed = false;
+
+    for (auto &bin : m_bins) {
+        while (bin) {
+            MEMiExpBlockHead *block = bin;
+            bin = block->m_link.m_next;
+            recycleRegion(block->getRegion());
+            flushed = true;
+        }
+    }
+
+    return flushed;
+}
+
 } // namespace Kinoko::Abstract::Memory
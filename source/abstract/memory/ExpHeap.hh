@@ -69,6 +69,12 @@ public:
 /// non-existent, but external fragmentation is still possible. Allocating temporary blocks from the
 /// tail, and scene-permanent blocks from the head, is recommended. The memory overhead per
 /// allocation is `sizeof(MEMiExpBlockHead)`.
+///
+/// With the SizeClasses option, small blocks allocated from the head are kept in per-size bins
+/// once freed, rather than merged back into the free list, and the smallest sizes are carved from
+/// pooled chunks. Bins live in the heap itself, and are returned to the free list whenever an
+/// allocation would otherwise fail, or when the allocatable size is queried. This is not part of
+/// the base game.
 class MEMiExpHeapHead : public MEMiHeapHead {
 private:
     MEMiExpHeapHead(void *end, u16 opt);
@@ -82,7 +88,7 @@ public:
 
     void *alloc(size_t size, s32 align);
     void free(void *block);
-    [[nodiscard]] u32 getAllocatableSize(s32 align) const;
+    [[nodiscard]] u32 getAllocatableSize(s32 align);
     void visitAllocated(Visitor visitor, uintptr_t param);
 
     [[nodiscard]] u16 getGroupID() const;
@@ -100,6 +106,16 @@ private:
             u32 size, s32 direction);
     bool recycleRegion(const Region &initialRegion);
 
+    [[nodiscard]] void *allocFromBin(size_t size, s32 alignment);
+    [[nodiscard]] bool freeToBin(MEMiExpBlockHead *block);
+    void refillBin(u32 sizeClass);
+    bool flushBins();
+
+    static constexpr u32 SIZE_CLASS_GRANULE = 16;
+    static constexpr u32 SIZE_CLASS_COUNT = 16; ///< Sizes up to 256 bytes are binned.
+    static constexpr u32 POOL_CLASS_COUNT = 4;  ///< Sizes up to 64 bytes are pooled.
+    static constexpr u32 POOL_BLOCK_COUNT = 32; ///< The number of blocks carved per pooled chunk.
+
     MEMiExpBlockList m_freeBlocks;
     MEMiExpBlockList m_usedBlocks;
     u16 m_groupId;
@@ -108,6 +124,9 @@ private:
 #endif // BUILD_DEBUG
     Attribute m_attribute;
 
+    /// @brief Per size class, freed blocks of at least that many granules, linked by m_link.m_next.
+    std::array<MEMiExpBlockHead *, SIZE_CLASS_COUNT> m_bins;
+
     static constexpr u32 EXP_HEAP_SIGNATURE = 0x45585048; // EXPH
 };
 
@@ -96,6 +96,6 @@ MEMList &MEMiHeapHead::findListContainHeap() const {
     return containHeap ? containHeap->getChildList() : getRootList();
 }
 
-MEMList MEMiHeapHead::s_rootList = MEMList(MEMiHeapHead::getLinkOffset());
+THREAD_LOCAL MEMList MEMiHeapHead::s_rootList = MEMList(MEMiHeapHead::getLinkOffset());
 
 } // namespace Kinoko::Abstract::Memory
@@ -2,6 +2,8 @@
 
 #include "abstract/memory/List.hh"
 
+#include <ThreadLocal.hh>
+
 #include <egg/core/BitFlag.hh>
 
 #include <array>
@@ -31,6 +33,7 @@ public:
     enum class eOptFlag {
         ZeroFillAlloc = 0,
         DebugFillAlloc = 1,
+        SizeClasses = 2, ///< Serve small allocations from size-segregated free lists, if supported.
     };
     typedef EGG::TBitFlag<u16, eOptFlag> OptFlag;
 
@@ -54,6 +57,10 @@ protected:
     void fillAllocMemory(void *address, u32 size);
     void fillFreeMemory(void *address, u32 size);
 
+    [[nodiscard]] bool tstOptFlag(eOptFlag flag) const {
+        return m_optFlag.onBit(flag);
+    }
+
 private:
     [[nodiscard]] static MEMiHeapHead *findContainHeap(MEMList *list, const void *block);
     [[nodiscard]] MEMList &findListContainHeap() const;
@@ -65,7 +72,7 @@ private:
     void *m_heapStart;
     void *m_heapEnd;
 
-    static MEMList s_rootList;
+    static THREAD_LOCAL MEMList s_rootList;
     static constexpr std::array<u32, 3> s_fillVals = {{
             0xC3C3C3C3,
             0xF3F3F3F3,
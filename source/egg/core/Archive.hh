@@ -48,7 +48,8 @@ private:
     s32 m_refCount = 1;
     Abstract::Memory::MEMLink m_link;
 
-    static Abstract::Memory::MEMList s_archiveList; ///< The linked list of all mounted archives.
+    /// The linked list of all mounted archives.
+    static THREAD_LOCAL Abstract::Memory::MEMList s_archiveList;
 };
 
 } // namespace EGG
@@ -1,7 +1,81 @@
 #include "Decomp.hh"
 
+#include <algorithm>
+#include <array>
+#include <cstring>
+
 namespace Kinoko::EGG::Decomp {
 
+/// @brief The most bytes a group of eight tokens can write, including what CopyRunFast overwrites.
+static constexpr ptrdiff_t GROUP_MAX_WRITE_SIZE = 8 * 0x111 + 16;
+
+static constexpr u32 MAX_RUN_DIST = 0x1000;
+static constexpr u32 MIN_RUN_LEN = 3;
+static constexpr u32 MAX_RUN_LEN = 0x111;
+
+/// @brief How many earlier positions with the same prefix the encoder tries for each run.
+static constexpr u32 MAX_MATCH_CANDIDATES = 0x100;
+
+static constexpr u32 MATCH_HASH_BITS = 12;
+
+/// @brief Parses a back-reference token.
+/// @param src The token, which is advanced past.
+/// @param dist Set to how far back the run starts, from 1 to 0x1000.
+/// @param len Set to the length of the run, from 3 to 0x111.
+static inline void ReadRun(const u8 *&src, ptrdiff_t &dist, ptrdiff_t &len) {
+    // Upper nibble of byte 1 is the length, lower nibble of byte 1 + byte 2 is the distance
+    u32 pair = (src[0] << 8) | src[1];
+    src += 2;
+
+    dist = (pair & 0xfff) + 1;
+    len = (pair >> 12) == 0 ? *src++ + 0x12 : (pair >> 12) + 2;
+}
+
+/// @brief Copies a back-reference run to dst.
+/// @details Runs which overlap their own source repeat with a period of dist. The bytes copied so
+/// far always span a whole number of periods, so they can be copied again as one block, doubling
+/// the block size each time.
+static inline void CopyRun(u8 *dst, ptrdiff_t dist, ptrdiff_t len) {
+    const u8 *run = dst - dist;
+
+    if (dist >= len) {
+        memcpy(dst, run, len);
+    } else if (dist == 1) {
+        memset(dst, *run, len);
+    } else {
+        for (ptrdiff_t copied = 0; copied < len;) {
+            ptrdiff_t block = std::min(len - copied, dst + copied - run);
+            memcpy(dst + copied, run, block);
+            copied += block;
+        }
+    }
+}
+
+/// @brief Copies a back-reference run to dst one word at a time.
+/// @details Up to 15 bytes past the end of the run may be written. The caller must ensure they are
+/// in bounds, after which they are overwritten by the following tokens.
+static inline void CopyRunFast(u8 *dst, ptrdiff_t dist, ptrdiff_t len) {
+    ptrdiff_t i = 0;
+
+    if (dist < 8) {
+        // Any multiple of the distance is also a period of the run, so widen it to a whole word
+        ptrdiff_t period = dist;
+        while (period < 8) {
+            period += dist;
+        }
+
+        for (; i < period; ++i) {
+            dst[i] = dst[i - dist];
+        }
+
+        dist = period;
+    }
+
+    for (; i < len; i += 8) {
+        memcpy(dst + i, dst + i - dist, 8);
+    }
+}
+
 /// @addr{0x8021997C}
 s32 GetExpandSize(const u8 *src) {
     if (src[0] == 'Y' && src[1] == 'a' && src[2] == 'z') {
@@ -12,45 +86,213 @@ s32 GetExpandSize(const u8 *src) {
 }
 
 /// @brief Performs YAZ0 decompression on a given buffer.
+/// @details Unlike the base game, which decodes one byte at a time, literal groups and runs are
+/// copied in bulk. Groups which can't reach the end of the buffer skip all bounds checks, and copy
+/// runs a word at a time.
 /// @return The size of the decompressed data.
 /// @addr{0x80218C2C}
 s32 DecodeSZS(const u8 *src, u8 *dst) {
     s32 expandSize = GetExpandSize(src);
-    s32 srcIdx = 0x10;
-    u8 code = 0;
+    if (expandSize <= 0) {
+        return expandSize;
+    }
+
+    src += 0x10;
+    u8 *dstEnd = dst + expandSize;
+
+    while (dst < dstEnd) {
+        u8 code = *src++;
+        ptrdiff_t dist;
+        ptrdiff_t len;
+
+        if (dstEnd - dst >= GROUP_MAX_WRITE_SIZE) {
+            // Direct copy of all eight bytes (code bits = 1)
+            if (code == 0xFF) {
+                memcpy(dst, src, 8);
+                src += 8;
+                dst += 8;
+                continue;
+            }
+
+            for (u8 bit = 0x80; bit != 0; bit >>= 1) {
+                if (code & bit) {
+                    *dst++ = *src++;
+                } else {
+                    ReadRun(src, dist, len);
+                    CopyRunFast(dst, dist, len);
+                    dst += len;
+                }
+            }
+
+            continue;
+        }
+
+        for (u8 bit = 0x80; bit != 0 && dst < dstEnd; bit >>= 1) {
+            // Direct copy (code bit = 1)
+            if (code & bit) {
+                *dst++ = *src++;
+                continue;
+            }
+
+            // RLE compressed data (code bit = 0)
+            ReadRun(src, dist, len);
+            if (len > dstEnd - dst) {
+                PANIC("Malformed compressed SZS data.");
+            }
+
+            CopyRun(dst, dist, len);
+            dst += len;
+        }
+    }
+
+    return expandSize;
+}
+
+/// @brief Checks that a YAZ0 stream decodes without reading or writing out of bounds.
+/// @details DecodeSZS trusts its input, so this walks the tokens the same way without writing
+/// anything, to vet data which doesn't come from the game's own archives.
+/// @param src The stream, including its header.
+/// @param size The size of the stream.
+/// @return Whether the stream can be passed to DecodeSZS.
+bool IsValidSZS(const u8 *src, size_t size) {
+    if (size < 0x10) {
+        return false;
+    }
+
+    s32 expandSize = GetExpandSize(src);
+    if (expandSize <= 0) {
+        return false;
+    }
 
-    u8 byte;
+    const u8 *srcEnd = src + size;
+    src += 0x10;
 
-    for (s32 destIdx = 0; destIdx < expandSize; code >>= 1) {
-        if (!code) {
-            code = 0x80;
-            byte = src[srcIdx++];
+    for (ptrdiff_t written = 0; written < expandSize;) {
+        if (src == srcEnd) {
+            return false;
         }
 
-        // Direct copy (code bit = 1)
-        if (byte & code) {
-            dst[destIdx++] = src[srcIdx++];
+        u8 code = *src++;
+        for (u8 bit = 0x80; bit != 0 && written < expandSize; bit >>= 1) {
+            if (code & bit) {
+                if (src == srcEnd) {
+                    return false;
+                }
+
+                ++src;
+                ++written;
+                continue;
+            }
+
+            // A run needs a third byte when the upper nibble is zero
+            if (srcEnd - src < 2 || (src[0] >> 4 == 0 && srcEnd - src < 3)) {
+                return false;
+            }
+
+            ptrdiff_t dist;
+            ptrdiff_t len;
+            ReadRun(src, dist, len);
+            if (dist > written || len > expandSize - written) {
+                return false;
+            }
+
+            written += len;
         }
-        // RLE compressed data (code bit = 0)
-        else {
-            // Lower nibble of byte1 + byte2
-            s32 distToDest = (src[srcIdx] << 8) | src[srcIdx + 1];
-            srcIdx += sizeof(u8) * 2;
-            s32 runSrcIdx = destIdx - (distToDest & 0xfff);
+    }
+
+    return true;
+}
+
+/// @brief Hashes the three bytes a run must start with.
+static inline u32 HashPrefix(const u8 *src) {
+    u32 prefix = (src[0] << 16) | (src[1] << 8) | src[2];
+    return (prefix * 0x9E3779B1) >> (32 - MATCH_HASH_BITS);
+}
+
+/// @brief Performs YAZ0 compression, so that files the game reads compressed can be written.
+/// @details Runs are found greedily. Earlier positions are chained by the hash of their first three
+/// bytes, and only the most recent MAX_MATCH_CANDIDATES of them are tried, which keeps encoding
+/// linear at the cost of a slightly larger stream.
+/// @param src The data to compress.
+/// @param size The size of the data.
+/// @param dst Where to write the stream, which must hold at least GetEncodeBound(size) bytes.
+/// @return The size of the stream, including its header.
+s32 EncodeSZS(const u8 *src, u32 size, u8 *dst) {
+    // The most recent position with each hash, and the previous position with the same hash as
+    // each position in the window
+    std::array<s32, 1 << MATCH_HASH_BITS> head;
+    std::array<s32, MAX_RUN_DIST> prev;
+    head.fill(-1);
+
+    auto insert = [&](u32 pos) {
+        if (pos + MIN_RUN_LEN <= size) {
+            u32 hash = HashPrefix(src + pos);
+            prev[pos % MAX_RUN_DIST] = head[hash];
+            head[hash] = pos;
+        }
+    };
+
+    memcpy(dst, "Yaz0", 4);
+    dst[4] = static_cast<u8>(size >> 24);
+    dst[5] = static_cast<u8>(size >> 16);
+    dst[6] = static_cast<u8>(size >> 8);
+    dst[7] = static_cast<u8>(size);
+    memset(dst + 8, 0, 8);
 
-            // Upper nibble of byte 1
-            s32 runLen = ((distToDest >> 12) == 0) ? src[srcIdx++] + 0x12 : (distToDest >> 12) + 2;
+    u8 *out = dst + 0x10;
+    for (u32 pos = 0; pos < size;) {
+        u8 &code = *out++;
+        code = 0;
 
-            for (; runLen > 0; runLen--, destIdx++, runSrcIdx++) {
-                if (destIdx >= expandSize) {
-                    PANIC("Malformed compressed SZS data.");
+        for (u8 bit = 0x80; bit != 0 && pos < size; bit >>= 1) {
+            u32 maxLen = std::min(MAX_RUN_LEN, size - pos);
+            u32 bestLen = 0;
+            u32 bestDist = 0;
+
+            if (maxLen >= MIN_RUN_LEN) {
+                s32 candidate = head[HashPrefix(src + pos)];
+                for (u32 i = 0; i < MAX_MATCH_CANDIDATES && candidate >= 0 &&
+                        pos - candidate <= MAX_RUN_DIST;
+                        ++i, candidate = prev[candidate % MAX_RUN_DIST]) {
+                    u32 len = 0;
+                    while (len < maxLen && src[candidate + len] == src[pos + len]) {
+                        ++len;
+                    }
+
+                    if (len > bestLen) {
+                        bestLen = len;
+                        bestDist = pos - candidate;
+                        if (len == maxLen) {
+                            break;
+                        }
+                    }
                 }
+            }
+
+            if (bestLen < MIN_RUN_LEN) {
+                code |= bit;
+                *out++ = src[pos];
+                insert(pos++);
+                continue;
+            }
 
-                dst[destIdx] = dst[runSrcIdx - 1];
+            u32 dist = bestDist - 1;
+            if (bestLen < 0x12) {
+                *out++ = static_cast<u8>(((bestLen - 2) << 4) | (dist >> 8));
+                *out++ = static_cast<u8>(dist);
+            } else {
+                *out++ = static_cast<u8>(dist >> 8);
+                *out++ = static_cast<u8>(dist);
+                *out++ = static_cast<u8>(bestLen - 0x12);
+            }
+
+            for (u32 end = pos + bestLen; pos < end; ++pos) {
+                insert(pos);
             }
         }
     }
-    return expandSize;
+
+    return static_cast<s32>(out - dst);
 }
 
 } // namespace Kinoko::EGG::Decomp
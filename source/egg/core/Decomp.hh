@@ -6,5 +6,13 @@ namespace Kinoko::EGG::Decomp {
 
 [[nodiscard]] s32 GetExpandSize(const u8 *src);
 s32 DecodeSZS(const u8 *src, u8 *dst);
+[[nodiscard]] bool IsValidSZS(const u8 *src, size_t size);
+
+/// @brief The most bytes EncodeSZS writes for a given size, when nothing can be compressed.
+[[nodiscard]] constexpr u32 GetEncodeBound(u32 size) {
+    return 0x10 + size + (size + 7) / 8;
+}
+
+s32 EncodeSZS(const u8 *src, u32 size, u8 *dst);
 
 } // namespace Kinoko::EGG::Decomp
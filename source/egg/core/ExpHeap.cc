@@ -6,7 +6,9 @@ namespace Kinoko::EGG {
 
 using namespace Abstract::Memory;
 
-ExpHeap::ExpHeap(MEMiHeapHead *handle) : Heap(handle) {}
+ExpHeap::ExpHeap(MEMiHeapHead *handle) : Heap(handle), m_usedSize(0), m_peakUsedSize(0) {
+    m_groupUsage.fill({0, 0, 0});
+}
 
 /// @addr{0x802269A8}
 ExpHeap::~ExpHeap() {
@@ -50,6 +52,8 @@ ExpHeap *ExpHeap::create(size_t size, Heap *pHeap, u16 opt) {
         size = pHeap->getAllocatableSize();
     }
 
+    // The child heap's own totals account for its memory
+    s_isChildHeapBlock = true;
     void *block = pHeap->alloc(size, 4);
     if (block) {
         heap = create(block, size, opt);
@@ -59,6 +63,7 @@ ExpHeap *ExpHeap::create(size_t size, Heap *pHeap, u16 opt) {
             pHeap->free(block);
         }
     }
+    s_isChildHeapBlock = false;
 
     return heap;
 }
@@ -68,7 +73,9 @@ void ExpHeap::destroy() {
     Heap *pParent = getParentHeap();
     this->~ExpHeap();
     if (pParent) {
+        s_isChildHeapBlock = true;
         pParent->free(this);
+        s_isChildHeapBlock = false;
     }
 }
 
@@ -78,16 +85,33 @@ void *ExpHeap::alloc(size_t size, s32 align) {
         PANIC("HEAP ALLOC FAIL (%p, %s): Heap is locked", this, m_name);
     }
 
-    return dynamicCastHandleToExp()->alloc(size, align);
+    void *block = dynamicCastHandleToExp()->alloc(size, align);
+    if (block && !s_isChildHeapBlock) {
+        addUsage(block);
+    }
+
+    if (s_trace) {
+        s_trace->push_back({this, block, static_cast<u32>(size), align, false});
+    }
+
+    return block;
 }
 
 /// @addr{0x80226C78}
 void ExpHeap::free(void *block) {
+    if (s_trace) {
+        s_trace->push_back({this, block, 0, 0, true});
+    }
+
+    if (block && !s_isChildHeapBlock) {
+        removeUsage(block);
+    }
+
     dynamicCastHandleToExp()->free(block);
 }
 
 /// @addr{0x80226C90}
-u32 ExpHeap::getAllocatableSize(s32 align) const {
+u32 ExpHeap::getAllocatableSize(s32 align) {
     return dynamicCastHandleToExp()->getAllocatableSize(align);
 }
 
@@ -116,6 +140,57 @@ u16 ExpHeap::getGroupID() const {
     return dynamicCastHandleToExp()->getGroupID();
 }
 
+/// @brief Records every allocation and free on any expanded heap, for replay in benchmarks.
+/// @param trace The trace to append to, or nullptr to stop recording.
+void ExpHeap::SetTrace(std::vector<TraceEvent> *trace) {
+    s_trace = trace;
+}
+
+/// @brief Counts a newly allocated block towards its group.
+void ExpHeap::addUsage(void *block) {
+    const MEMiExpBlockHead *blockHead =
+            static_cast<const MEMiExpBlockHead *>(SubOffset(block, sizeof(MEMiExpBlockHead)));
+    u32 size = static_cast<u32>(blockHead->getRegion().getRange());
+
+    GroupUsage &usage = m_groupUsage[blockHead->m_attribute.fields.groupId];
+    usage.current += size;
+    usage.peak = std::max(usage.peak, usage.current);
+    ++usage.allocCount;
+
+    m_usedSize += size;
+    if (m_usedSize > m_peakUsedSize) {
+        m_peakUsedSize = m_usedSize;
+        updatePeakArenaUse();
+    }
+}
+
+/// @brief Removes a block that is about to be freed from its group's total.
+void ExpHeap::removeUsage(void *block) {
+    const MEMiExpBlockHead *blockHead =
+            static_cast<const MEMiExpBlockHead *>(SubOffset(block, sizeof(MEMiExpBlockHead)));
+    u32 size = static_cast<u32>(blockHead->getRegion().getRange());
+
+    m_groupUsage[blockHead->m_attribute.fields.groupId].current -= size;
+    m_usedSize -= size;
+}
+
+/// @brief Estimates how much of the outermost heap's memory would be in use if this heap only
+/// spanned its used bytes.
+/// @details Scene heaps take all of the allocatable memory of their parent, so the arena only needs
+/// to fit the memory around this heap's region, plus what is allocated within it. Fragmentation
+/// is not accounted for.
+void ExpHeap::updatePeakArenaUse() {
+    Heap *root = this;
+    while (root->getParentHeap()) {
+        root = root->getParentHeap();
+    }
+
+    MEMiExpHeapHead *handle = dynamicCastHandleToExp();
+    size_t before = GetAddrNum(handle->getHeapStart()) - GetAddrNum(root->getStartAddress());
+    size_t after = GetAddrNum(root->getEndAddress()) - GetAddrNum(handle->getHeapEnd());
+    s_peakArenaUse = std::max(s_peakArenaUse, before + m_peakUsedSize + after);
+}
+
 MEMiExpHeapHead *ExpHeap::dynamicCastHandleToExp() {
     return reinterpret_cast<MEMiExpHeapHead *>(m_handle);
 }
@@ -145,4 +220,8 @@ void ExpHeap::GroupSizeRecord::addSize(u16 groupID, size_t size) {
     m_entries[groupID] += size;
 }
 
+THREAD_LOCAL std::vector<ExpHeap::TraceEvent> *ExpHeap::s_trace = nullptr;
+THREAD_LOCAL size_t ExpHeap::s_peakArenaUse = 0;
+THREAD_LOCAL bool ExpHeap::s_isChildHeapBlock = false;
+
 } // namespace Kinoko::EGG
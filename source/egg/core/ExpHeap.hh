@@ -4,6 +4,8 @@
 
 #include <abstract/memory/ExpHeap.hh>
 
+#include <vector>
+
 namespace Kinoko::EGG {
 
 /// @brief High-level implementation of a memory heap for managing dynamic memory allocation.
@@ -33,6 +35,24 @@ public:
         std::array<size_t, 256> m_entries;
     };
 
+    /// @brief Running totals of the blocks allocated with a group ID.
+    /// @details Sizes include each block's header and alignment padding. Totals are kept in the
+    /// heap itself, so that restoring a context restores them as well.
+    struct GroupUsage {
+        u32 current;    ///< The bytes currently allocated.
+        u32 peak;       ///< The most bytes allocated at once.
+        u32 allocCount; ///< The number of allocations since the heap was created.
+    };
+
+    /// @brief An allocation or free, as recorded while a trace is set.
+    struct TraceEvent {
+        ExpHeap *heap;
+        void *block; ///< The block returned by an allocation, or passed to a free.
+        u32 size;    ///< The size requested by an allocation.
+        s32 align;   ///< The alignment requested by an allocation.
+        bool isFree;
+    };
+
     ~ExpHeap() override;
     void destroy() override;
 
@@ -43,7 +63,7 @@ public:
 
     [[nodiscard]] void *alloc(size_t size, s32 align) override;
     void free(void *block) override;
-    [[nodiscard]] u32 getAllocatableSize(s32 align = 4) const override;
+    [[nodiscard]] u32 getAllocatableSize(s32 align = 4) override;
 
     static void addGroupSize(void *block, Abstract::Memory::MEMiHeapHead *heap, uintptr_t param);
     void calcGroupSize(GroupSizeRecord *record);
@@ -51,14 +71,50 @@ public:
     void setGroupID(u16 groupID);
     [[nodiscard]] u16 getGroupID() const;
 
+    /// @beginGetters
+    [[nodiscard]] const GroupUsage &groupUsage(u16 groupID) const {
+        return m_groupUsage[groupID];
+    }
+
+    [[nodiscard]] u32 usedSize() const {
+        return m_usedSize;
+    }
+
+    [[nodiscard]] u32 peakUsedSize() const {
+        return m_peakUsedSize;
+    }
+    /// @endGetters
+
     [[nodiscard]] Abstract::Memory::MEMiExpHeapHead *dynamicCastHandleToExp();
     [[nodiscard]] const Abstract::Memory::MEMiExpHeapHead *dynamicCastHandleToExp() const;
 
     [[nodiscard]] static ExpHeap *create(void *startAddress, size_t size, u16 opt);
     [[nodiscard]] static ExpHeap *create(size_t size, Heap *heap, u16 opt);
 
+    static void SetTrace(std::vector<TraceEvent> *trace);
+
+    [[nodiscard]] static size_t PeakArenaUse() {
+        return s_peakArenaUse;
+    }
+
 private:
     ExpHeap(Abstract::Memory::MEMiHeapHead *handle);
+
+    void addUsage(void *block);
+    void removeUsage(void *block);
+    void updatePeakArenaUse();
+
+    std::array<GroupUsage, 256> m_groupUsage; ///< Indexed by the group ID of each block.
+    u32 m_usedSize;
+    u32 m_peakUsedSize;
+
+    /// The most bytes of the outermost heap's memory ever in use, across all heaps. Host-side, so
+    /// that it survives restoring contexts and destroying heaps.
+    static THREAD_LOCAL size_t s_peakArenaUse;
+    /// Whether the block being allocated or freed is a heap.
+    static THREAD_LOCAL bool s_isChildHeapBlock;
+    /// Host-side, so that tracing has no effect on heaps.
+    static THREAD_LOCAL std::vector<TraceEvent> *s_trace;
 };
 
 } // namespace Kinoko::EGG
@@ -40,7 +40,7 @@ public:
     virtual Kind getHeapKind() const = 0;
     virtual void *alloc(size_t size, s32 align) = 0;
     virtual void free(void *block) = 0;
-    virtual u32 getAllocatableSize(s32 align = 4) const = 0;
+    virtual u32 getAllocatableSize(s32 align = 4) = 0;
 
     void dispose();
 
@@ -130,10 +130,10 @@ protected:
     Abstract::Memory::MEMList m_children;
     const char *m_name;
 
-    static Abstract::Memory::MEMList s_heapList;
+    static THREAD_LOCAL Abstract::Memory::MEMList s_heapList;
 
-    static Heap *s_currentHeap;
-    static Heap *s_allocatableHeap;
+    static THREAD_LOCAL Heap *s_currentHeap;
+    static THREAD_LOCAL Heap *s_allocatableHeap;
 };
 
 [[nodiscard]] void *egg_alloc(size_t size, s32 align = 4, Heap *pHeap = nullptr);
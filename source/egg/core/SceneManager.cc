@@ -213,9 +213,9 @@ void SceneManager::setupNextSceneId() {
     m_nextSceneId = -1;
 }
 
-Heap *SceneManager::s_heapForCreateScene = nullptr;
-u16 SceneManager::s_heapOptionFlg = DEFAULT_OPT;
+THREAD_LOCAL Heap *SceneManager::s_heapForCreateScene = nullptr;
+THREAD_LOCAL u16 SceneManager::s_heapOptionFlg = DEFAULT_OPT;
 
-Heap *SceneManager::s_rootHeap = nullptr;
+THREAD_LOCAL Heap *SceneManager::s_rootHeap = nullptr;
 
 } // namespace Kinoko::EGG
@@ -68,6 +68,10 @@ public:
         return s_heapForCreateScene;
     }
 
+    [[nodiscard]] static u16 HeapOptionFlg() {
+        return s_heapOptionFlg;
+    }
+
     /*----------*
         Setters
      *----------*/
@@ -80,6 +84,10 @@ public:
         s_rootHeap = heap;
     }
 
+    static void SetHeapOptionFlg(u16 opt) {
+        s_heapOptionFlg = opt;
+    }
+
 private:
     /*----------*
         Members
@@ -91,10 +99,10 @@ private:
     int m_currentSceneId;
     int m_prevSceneId;
 
-    static Heap *s_heapForCreateScene;
-    static u16 s_heapOptionFlg;
+    static THREAD_LOCAL Heap *s_heapForCreateScene;
+    static THREAD_LOCAL u16 s_heapOptionFlg;
 
-    static Heap *s_rootHeap;
+    static THREAD_LOCAL Heap *s_rootHeap;
 };
 
 } // namespace EGG
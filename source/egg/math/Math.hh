@@ -611,6 +611,35 @@ static constexpr std::array<BaseAndDec64, 32> RSQRTE_TABLE = {{
     return c64(new_exp | new_mantissa).f;
 }
 
+/// @brief frsqrte for single-precision inputs, which is how the game uses it.
+/// @details Positive normal floats are always normal as doubles, so they skip the special cases
+/// and denormal handling of the double-precision version. Floats also only have 23 mantissa bits,
+/// so the table key is read straight from the float's bits. The result is bit-identical to
+/// converting to double first for every float, which tests/FrsqrtTest.cc checks exhaustively.
+[[nodiscard]] static inline constexpr f64 frsqrte(const f32 val) {
+    constexpr u32 EXPONENT_SHIFT_F32 = 23;
+    constexpr u32 MIN_NORMAL_F32 = 0x00800000;
+    constexpr u32 NORMAL_RANGE_F32 = 0x7f000000; // Exponents 1 through 254
+    constexpr u64 EXPONENT_BIAS_DIFF = 1023 - 127;
+
+    u32 bits = std::bit_cast<u32>(val);
+
+    // Zero, negative, denormal, infinite and NaN inputs take the double-precision path
+    if (bits - MIN_NORMAL_F32 >= NORMAL_RANGE_F32) {
+        return frsqrte(static_cast<f64>(val));
+    }
+
+    u64 exponent = (bits >> EXPONENT_SHIFT_F32) + EXPONENT_BIAS_DIFF;
+    u64 new_exp = ((0xbfcULL - exponent) << (EXPONENT_SHIFT_F64 - 1)) & EXPONENT_MASK_F64;
+
+    // The same key as the double-precision version: the exponent's LSB, then 15 mantissa bits
+    u32 key = static_cast<u32>((exponent & 1) << 15) | ((bits >> 8) & 0x7fff);
+    const auto &entry = RSQRTE_TABLE[0x1f & (key >> 11)];
+    u64 new_mantissa = static_cast<u64>(entry.base + entry.dec * static_cast<s64>(key & 0x7ff));
+
+    return std::bit_cast<f64>(new_exp | new_mantissa);
+}
+
 static constexpr std::array<BaseAndDec32, 32> FRES_TABLE = {{
         {0x00fff000UL, -0x3e1L},
         {0x00f07000UL, -0x3a7L},
@@ -134,7 +134,7 @@ private:
     f32 m_cacheRadius;
     BoxColFlag m_cacheFlag;
 
-    static BoxColManager *s_instance;
+    static THREAD_LOCAL BoxColManager *s_instance;
 };
 
 } // namespace Field
@@ -318,6 +318,6 @@ CollisionDirector::~CollisionDirector() {
     CourseColMgr::DestroyInstance();
 }
 
-CollisionDirector *CollisionDirector::s_instance = nullptr; ///< @addr{0x809C2F44}
+THREAD_LOCAL CollisionDirector *CollisionDirector::s_instance = nullptr; ///< @addr{0x809C2F44}
 
 } // namespace Kinoko::Field
@@ -121,7 +121,7 @@ private:
     std::array<CollisionEntry, COLLISION_ARR_LENGTH> m_entries;
     size_t m_collisionEntryCount;
 
-    static CollisionDirector *s_instance; ///< @addr{0x809C2F44}
+    static THREAD_LOCAL CollisionDirector *s_instance; ///< @addr{0x809C2F44}
 };
 
 } // namespace Field
@@ -107,6 +107,10 @@ public:
     /// @endSetters
 
     /// @beginGetters
+    [[nodiscard]] KColData *data() {
+        return m_data;
+    }
+
     [[nodiscard]] const KColData *data() const {
         return m_data;
     }
@@ -150,7 +154,7 @@ private:
     NoBounceWallColInfo *m_noBounceWallInfo;
     EGG::Matrix34f *m_localMtx;
 
-    static CourseColMgr *s_instance; ///< @addr{0x809C3C10}
+    static THREAD_LOCAL CourseColMgr *s_instance; ///< @addr{0x809C3C10}
 };
 
 } // namespace Field
@@ -49,6 +49,11 @@ KColData::KColData(const void *file) {
     preloadPrisms();
     preloadNormals();
     preloadVertices();
+    preloadOctree();
+
+    m_prismCacheStamps = owning_span<u16>(m_prisms.size());
+    std::fill(m_prismCacheStamps.begin(), m_prismCacheStamps.end(), 0);
+    m_prismCacheGeneration = 1;
 
     computeBBox();
 }
@@ -58,6 +63,14 @@ KColData::~KColData() = default;
 /// @addr{0x807C24C0}
 void KColData::narrowScopeLocal(const EGG::Vector3f &pos, f32 radius, KCLTypeMask mask) {
     m_prismCacheTop = m_prismCache.data();
+
+    // Emptying the cache invalidates all stamps. Once the generation wraps around, stale stamps
+    // could match again, so they are cleared instead.
+    if (++m_prismCacheGeneration == 0) {
+        std::fill(m_prismCacheStamps.begin(), m_prismCacheStamps.end(), 0);
+        m_prismCacheGeneration = 1;
+    }
+
     m_pos = pos;
     m_radius = radius;
     m_typeMask = mask;
@@ -76,14 +89,18 @@ void KColData::narrowPolygon_EachBlock(const u16 *prismArray) {
     m_prismIter = prismArray;
 
     while (checkSphereSingle(nullptr, nullptr, nullptr)) {
-        /// We assume the cache has same endianness as the archive file,
-        /// so do not parse out the prism index and directly store it in the cache.
+        /// The cache is iterated just like a prism list from searchBlock, so it is kept in the same
+        /// native endianness.
         *(m_prismCacheTop++) = *m_prismIter;
 
         if (m_prismCacheTop == m_prismCache.end()) {
             --m_prismCacheTop;
             return;
         }
+
+        // Only stamp prisms that stay below the top, as the last slot is reserved for the null
+        // terminator
+        m_prismCacheStamps[*m_prismIter] = m_prismCacheGeneration;
     }
 }
 
@@ -139,7 +156,7 @@ bool KColData::checkSphere(f32 *distOut, EGG::Vector3f *fnrmOut, u16 *flagsOut)
 
     // Check collision for all triangles, and continuously call the function until we're out
     while (*++m_prismIter != 0) {
-        const KCollisionPrism &prism = m_prisms[parse<u16>(*m_prismIter)];
+        const KCollisionPrism &prism = m_prisms[*m_prismIter];
         if (checkCollision<CollisionCheckType::Plane>(prism, distOut, fnrmOut, flagsOut)) {
             return true;
         }
@@ -157,20 +174,13 @@ bool KColData::checkSphereSingle(f32 *distOut, EGG::Vector3f *fnrmOut, u16 *flag
     }
 
     while (*++m_prismIter != 0) {
-        if (m_prismCacheTop != m_prismCache.begin()) {
-            u16 *puVar10 = m_prismCacheTop - 1;
-            while (*m_prismIter != *puVar10) {
-                if (puVar10-- < m_prismCache.begin()) {
-                    break;
-                }
-            }
-
-            if (puVar10 >= m_prismCache.begin()) {
-                continue;
-            }
+        // The base game scans the prism cache backwards for the prism. Instead, every cached prism
+        // is stamped with the current generation, which makes skipping it constant-time.
+        if (m_prismCacheStamps[*m_prismIter] == m_prismCacheGeneration) {
+            continue;
         }
 
-        const KCollisionPrism &prism = m_prisms[parse<u16>(*m_prismIter)];
+        const KCollisionPrism &prism = m_prisms[*m_prismIter];
         if (checkCollision<CollisionCheckType::Edge>(prism, distOut, fnrmOut, flagsOut)) {
             return true;
         }
@@ -226,8 +236,9 @@ void KColData::lookupSphereCached(const EGG::Vector3f &p1, const EGG::Vector3f &
 /// @brief Finds the data block corresponding to the provided position
 /// @addr{0x807BE030}
 /// @param point The player's position
-/// @return the address of the leaf node containing the input point.
-const u16 *KColData::searchBlock(const EGG::Vector3f &point) {
+/// @return the prism list of the leaf node containing the input point. The list is native-endian
+/// and starts at the element after the returned address.
+const u16 *KColData::searchBlock(const EGG::Vector3f &point) const {
     // Calculate the x, y, and z offsets of the point from the minimum
     // corner of the tree's bounding box.
     const int x = point.x - m_areaMinPos.x;
@@ -242,37 +253,29 @@ const u16 *KColData::searchBlock(const EGG::Vector3f &point) {
 
     // Initialize the current tree node to the root node of the tree.
     u32 shift = m_blockWidthShift;
-    const u8 *curBlock = reinterpret_cast<const u8 *>(m_blockData);
-    s32 offset;
 
     // Traverse the tree to find the leaf node containing the input point.
-    u32 index = 4 *
-            (((u32)z >> shift) << m_areaXYBlocksShift | ((u32)y >> shift) << m_areaXBlocksShift |
-                    (u32)x >> shift);
+    u32 index = ((u32)z >> shift) << m_areaXYBlocksShift | ((u32)y >> shift) << m_areaXBlocksShift |
+            (u32)x >> shift;
 
     while (true) {
-        // Get the offset of the current node's child node.
-        offset = parse<u32>(*reinterpret_cast<const u32 *>(curBlock + index));
+        u32 node = octreeNode(index);
 
-        // If the offset is negative, the current node is a leaf node.
-        if ((offset & 0x80000000) != 0) {
-            break;
+        // If the MSB is set, the current node is a leaf node.
+        if ((node & 0x80000000) != 0) {
+            // We have to remove the MSB since it's solely used to identify leaves.
+            return m_prismLists.begin() + (node & ~0x80000000);
         }
 
-        // If the offset is non-negative, update the current node to be
-        // the child node and continue traversing the tree.
+        // Otherwise, the node holds the index of its first child. Continue traversing the tree.
         shift--;
-        curBlock += offset;
 
         u32 x_shift = ((1 * ((u32)x >> shift)) & 1);
         u32 y_shift = ((2 * ((u32)y >> shift)) & 2);
         u32 z_shift = ((4 * ((u32)z >> shift)) & 4);
 
-        index = 4 * (x_shift | y_shift | z_shift);
+        index = node | x_shift | y_shift | z_shift;
     }
-
-    // We have to remove the MSB since it's solely used to identify leaves.
-    return reinterpret_cast<const u16 *>(curBlock + (offset & ~0x80000000));
 }
 
 /// @brief Computes a prism vertex based off of the triangle's normal vectors
@@ -353,6 +356,98 @@ void KColData::preloadVertices() {
     }
 }
 
+/// @brief Creates a native copy of the octree and the prism lists it references.
+/// @details Optimizes for time by avoiding byteswapping every node visited by searchBlock, as well
+/// as every prism index read while iterating a list. The lists are copied as one contiguous range,
+/// so lists shared between leaves in the file stay shared. Branch nodes are laid out depth-first.
+/// Memory cost is about the size of the file's octree section.
+void KColData::preloadOctree() {
+    const u8 *root = reinterpret_cast<const u8 *>(m_blockData);
+    u32 zBlocks = ((~m_areaZWidthMask) >> m_blockWidthShift) + 1;
+    u32 rootCount = zBlocks << m_areaXYBlocksShift;
+    u32 rootBlocks = (rootCount + 7) / 8;
+
+    // The first pass sizes both buffers
+    size_t blockCount = rootBlocks;
+    const u8 *listsBegin = nullptr;
+    const u8 *listsEnd = nullptr;
+    for (u32 i = 0; i < rootCount; ++i) {
+        scanOctreeNode(root, i, blockCount, listsBegin, listsEnd);
+    }
+
+    ASSERT(listsBegin && blockCount * 8 < 0x80000000);
+
+    size_t listsSize = static_cast<size_t>(listsEnd - listsBegin) / sizeof(u16);
+    m_prismLists = owning_span<u16>(listsSize);
+    const u16 *lists = reinterpret_cast<const u16 *>(listsBegin);
+    for (size_t i = 0; i < listsSize; ++i) {
+        m_prismLists[i] = parse<u16>(lists[i]);
+    }
+
+    m_octree = owning_span<OctreeBlock>(blockCount);
+    m_octree[rootBlocks - 1].nodes.fill(0);
+
+    u32 nextBlock = rootBlocks;
+    for (u32 i = 0; i < rootCount; ++i) {
+        m_octree[i >> 3].nodes[i & 7] = flattenOctreeNode(root, i, listsBegin, nextBlock);
+    }
+
+    ASSERT(nextBlock == blockCount);
+}
+
+/// @brief Counts the branch blocks below a node of the file's octree, and extends the range of
+/// prism lists to cover the lists of its leaves.
+/// @param block The block containing the node.
+/// @param entry The index of the node in the block.
+void KColData::scanOctreeNode(const u8 *block, u32 entry, size_t &blockCount,
+        const u8 *&listsBegin, const u8 *&listsEnd) const {
+    u32 offset = parse<u32>(*reinterpret_cast<const u32 *>(block + 4 * entry));
+
+    if ((offset & 0x80000000) == 0) {
+        ++blockCount;
+        for (u32 i = 0; i < 8; ++i) {
+            scanOctreeNode(block + offset, i, blockCount, listsBegin, listsEnd);
+        }
+
+        return;
+    }
+
+    const u16 *list = reinterpret_cast<const u16 *>(block + (offset & ~0x80000000));
+    const u16 *iter = list;
+    while (parse<u16>(*++iter) != 0) {}
+
+    // Every list must share the same alignment to be indexable as one u16 range
+    const u8 *begin = reinterpret_cast<const u8 *>(list);
+    const u8 *end = reinterpret_cast<const u8 *>(iter + 1);
+    ASSERT(((begin - reinterpret_cast<const u8 *>(m_blockData)) & 1) == 0);
+
+    listsBegin = listsBegin ? std::min(listsBegin, begin) : begin;
+    listsEnd = listsEnd ? std::max(listsEnd, end) : end;
+}
+
+/// @brief Converts a node of the file's octree, allocating blocks for its children if needed.
+/// @param block The block containing the node.
+/// @param entry The index of the node in the block.
+/// @param listsBegin The start of the range copied to m_prismLists.
+/// @param nextBlock The next unused block of m_octree.
+/// @return The native node.
+u32 KColData::flattenOctreeNode(const u8 *block, u32 entry, const u8 *listsBegin,
+        u32 &nextBlock) {
+    u32 offset = parse<u32>(*reinterpret_cast<const u32 *>(block + 4 * entry));
+
+    if ((offset & 0x80000000) != 0) {
+        const u8 *list = block + (offset & ~0x80000000);
+        return 0x80000000 | static_cast<u32>((list - listsBegin) / sizeof(u16));
+    }
+
+    u32 childBlock = nextBlock++;
+    for (u32 i = 0; i < 8; ++i) {
+        m_octree[childBlock].nodes[i] = flattenOctreeNode(block + offset, i, listsBegin, nextBlock);
+    }
+
+    return childBlock * 8;
+}
+
 /// @brief This is a combination of the three collision checks in the base game.
 /// @details The checks vary only by a few if-statements, related to whether we are checking for:
 /// 1. A collision with at least the triangle edge (0x807C0F00)
@@ -617,7 +712,7 @@ bool KColData::checkSphereMovement(f32 *distOut, EGG::Vector3f *fnrmOut, u16 *at
 
     // Check collision for all triangles, and continuously call the function until we're out
     while (*++m_prismIter != 0) {
-        const KCollisionPrism &prism = m_prisms[parse<u16>(*m_prismIter)];
+        const KCollisionPrism &prism = m_prisms[*m_prismIter];
         if (checkCollision<CollisionCheckType::Movement>(prism, distOut, fnrmOut, attributeOut)) {
             return true;
         }
@@ -637,7 +732,7 @@ bool KColData::checkPoint(f32 *distOut, EGG::Vector3f *fnrmOut, u16 *attributeOu
 
     // Check collision for all triangles, and continuously call the function until we're out
     while (*++m_prismIter != 0) {
-        const KCollisionPrism &prism = m_prisms[parse<u16>(*m_prismIter)];
+        const KCollisionPrism &prism = m_prisms[*m_prismIter];
         if (checkPointCollision(prism, distOut, fnrmOut, attributeOut, false)) {
             return true;
         }
@@ -657,7 +752,7 @@ bool KColData::checkPointMovement(f32 *distOut, EGG::Vector3f *fnrmOut, u16 *att
 
     // Check collision for all triangles, and continuously call the function until we're out
     while (*++m_prismIter != 0) {
-        const KCollisionPrism &prism = m_prisms[parse<u16>(*m_prismIter)];
+        const KCollisionPrism &prism = m_prisms[*m_prismIter];
         if (checkPointCollision(prism, distOut, fnrmOut, attributeOut, true)) {
             return true;
         }
@@ -101,7 +101,7 @@ public:
     void lookupSphereCached(const EGG::Vector3f &p1, const EGG::Vector3f &p2, u32 typeMask,
             f32 radius);
 
-    [[nodiscard]] const u16 *searchBlock(const EGG::Vector3f &pos);
+    [[nodiscard]] const u16 *searchBlock(const EGG::Vector3f &pos) const;
 
     /// @beginGetters
     [[nodiscard]] const EGG::BoundBox3f &bbox() const {
@@ -129,9 +129,27 @@ public:
             const EGG::Vector3f &fnrm, const EGG::Vector3f &enrm3, const EGG::Vector3f &enrm);
 
 private:
+    /// @brief Eight sibling octree nodes, in native endianness.
+    /// @details Each node is either a leaf, whose MSB is set and whose remaining bits index the
+    /// element preceding its prism list in m_prismLists, or a branch, which holds the index of its
+    /// first child node. Blocks are aligned, so that each level of a lookup touches one cache line.
+    struct alignas(32) OctreeBlock {
+        std::array<u32, 8> nodes;
+    };
+
     void preloadPrisms();
     void preloadNormals();
     void preloadVertices();
+    void preloadOctree();
+
+    void scanOctreeNode(const u8 *block, u32 entry, size_t &blockCount, const u8 *&listsBegin,
+            const u8 *&listsEnd) const;
+    [[nodiscard]] u32 flattenOctreeNode(const u8 *block, u32 entry, const u8 *listsBegin,
+            u32 &nextBlock);
+
+    [[nodiscard]] u32 octreeNode(u32 idx) const {
+        return m_octree[idx >> 3].nodes[idx & 7];
+    }
 
     template <CollisionCheckType Type>
     [[nodiscard]] bool checkCollision(const KCollisionPrism &prism, f32 *distOut,
@@ -168,12 +186,16 @@ private:
     u16 *m_cachedPrismArray;
     EGG::Vector3f m_cachedPos;
     f32 m_cachedRadius;
+    owning_span<u16> m_prismCacheStamps; ///< Per prism, the generation it was last cached in.
+    u16 m_prismCacheGeneration;          ///< Advanced whenever the prism cache is emptied.
 
     /// @brief Optimizes for time by avoiding unnecessary byteswapping.
     /// The Wii doesn't have this problem because big endian is always assumed.
     owning_span<KCollisionPrism> m_prisms;
     owning_span<EGG::Vector3f> m_nrms;
     owning_span<EGG::Vector3f> m_vertices;
+    owning_span<OctreeBlock> m_octree; ///< The root grid, followed by every branch's children.
+    owning_span<u16> m_prismLists;     ///< All prism lists referenced by leaves of m_octree.
 };
 
 } // namespace Kinoko::Field
@@ -56,7 +56,7 @@ private:
 
     EGG::Vector3f m_00;
 
-    static std::array<std::array<f32, 4>, 4> s_dotProductCache;
+    static THREAD_LOCAL std::array<std::array<f32, 4>, 4> s_dotProductCache;
 };
 
 } // namespace Kinoko::Field
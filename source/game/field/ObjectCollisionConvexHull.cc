@@ -1,7 +1,240 @@
 #include "ObjectCollisionConvexHull.hh"
 
+#include <limits>
+
+#ifdef __SSE2__
+#define CONVEX_HULL_SIMD
+
+#include <immintrin.h>
+#endif
+
 namespace Kinoko::Field {
 
+#ifdef CONVEX_HULL_SIMD
+// Each row of EGG::Matrix34f::ps_multVector is fma(m2, z, m0 * x) + fma(m3, 1.0f, m1 * y), where
+// both fmas are computed in double precision. The products of floats are exact in double precision,
+// so computing the same operations on vectors gives bit-identical results. No function here may be
+// contracted into a native FMA, which the build already disables.
+
+STATIC_ASSERT(sizeof(EGG::Vector3f) == 3 * sizeof(f32));
+
+/// @brief Loads four consecutive points, and transposes them into x, y and z vectors.
+static inline void LoadPointsSSE2(const EGG::Vector3f *points, __m128 &x, __m128 &y, __m128 &z) {
+    const f32 *src = &points->x;
+    __m128 a = _mm_loadu_ps(src);     // x0 y0 z0 x1
+    __m128 b = _mm_loadu_ps(src + 4); // y1 z1 x2 y2
+    __m128 c = _mm_loadu_ps(src + 8); // z2 x3 y3 z3
+
+    x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+    y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)),
+            _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+    z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)),
+            _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+/// @brief Transposes x, y and z vectors, and stores them as four consecutive points.
+static inline void StorePointsSSE2(EGG::Vector3f *points, __m128 x, __m128 y, __m128 z) {
+    f32 *dst = &points->x;
+    __m128 a = _mm_shuffle_ps(_mm_unpacklo_ps(x, y), _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0)),
+            _MM_SHUFFLE(2, 0, 1, 0));
+    __m128 b = _mm_shuffle_ps(_mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1)),
+            _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0));
+    __m128 c = _mm_shuffle_ps(_mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2)),
+            _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+
+    _mm_storeu_ps(dst, a);
+    _mm_storeu_ps(dst + 4, b);
+    _mm_storeu_ps(dst + 8, c);
+}
+
+/// @brief Transforms four points by one row of a matrix.
+static inline __m128 TransformRowSSE2(const EGG::Matrix34f &mat, size_t row, __m128 x, __m128 y,
+        __m128 z) {
+    __m128 m0x = _mm_mul_ps(_mm_set1_ps(mat[row, 0]), x);
+    __m128 m1y = _mm_mul_ps(_mm_set1_ps(mat[row, 1]), y);
+    __m128d m2 = _mm_set1_pd(mat[row, 2]);
+    __m128d m3 = _mm_set1_pd(mat[row, 3]);
+
+    __m128d lhsLo = _mm_add_pd(_mm_mul_pd(m2, _mm_cvtps_pd(z)), _mm_cvtps_pd(m0x));
+    __m128d lhsHi = _mm_add_pd(_mm_mul_pd(m2, _mm_cvtps_pd(_mm_movehl_ps(z, z))),
+            _mm_cvtps_pd(_mm_movehl_ps(m0x, m0x)));
+    __m128d rhsLo = _mm_add_pd(m3, _mm_cvtps_pd(m1y));
+    __m128d rhsHi = _mm_add_pd(m3, _mm_cvtps_pd(_mm_movehl_ps(m1y, m1y)));
+
+    __m128 lhs = _mm_movelh_ps(_mm_cvtpd_ps(lhsLo), _mm_cvtpd_ps(lhsHi));
+    __m128 rhs = _mm_movelh_ps(_mm_cvtpd_ps(rhsLo), _mm_cvtpd_ps(rhsHi));
+    return _mm_add_ps(lhs, rhs);
+}
+
+/// @brief Transforms points in groups of four into the world points and the x, y and z arrays.
+/// @return The number of points transformed, which is a multiple of four.
+static size_t TransformSSE2(const EGG::Matrix34f &mat, const EGG::Vector3f *points, size_t count,
+        EGG::Vector3f *world, f32 *xs, f32 *ys, f32 *zs) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 x, y, z;
+        LoadPointsSSE2(points + i, x, y, z);
+
+        __m128 worldX = TransformRowSSE2(mat, 0, x, y, z);
+        __m128 worldY = TransformRowSSE2(mat, 1, x, y, z);
+        __m128 worldZ = TransformRowSSE2(mat, 2, x, y, z);
+
+        _mm_storeu_ps(xs + i, worldX);
+        _mm_storeu_ps(ys + i, worldY);
+        _mm_storeu_ps(zs + i, worldZ);
+        StorePointsSSE2(world + i, worldX, worldY, worldZ);
+    }
+
+    return i;
+}
+
+/// @brief Transforms eight points by one row of a matrix.
+[[gnu::target("avx2")]] static inline __m256 TransformRowAVX2(const EGG::Matrix34f &mat, size_t row,
+        __m256 x, __m256 y, __m256 z) {
+    __m256 m0x = _mm256_mul_ps(_mm256_set1_ps(mat[row, 0]), x);
+    __m256 m1y = _mm256_mul_ps(_mm256_set1_ps(mat[row, 1]), y);
+    __m256d m2 = _mm256_set1_pd(mat[row, 2]);
+    __m256d m3 = _mm256_set1_pd(mat[row, 3]);
+
+    __m256d lhsLo = _mm256_add_pd(_mm256_mul_pd(m2, _mm256_cvtps_pd(_mm256_castps256_ps128(z))),
+            _mm256_cvtps_pd(_mm256_castps256_ps128(m0x)));
+    __m256d lhsHi = _mm256_add_pd(_mm256_mul_pd(m2, _mm256_cvtps_pd(_mm256_extractf128_ps(z, 1))),
+            _mm256_cvtps_pd(_mm256_extractf128_ps(m0x, 1)));
+    __m256d rhsLo = _mm256_add_pd(m3, _mm256_cvtps_pd(_mm256_castps256_ps128(m1y)));
+    __m256d rhsHi = _mm256_add_pd(m3, _mm256_cvtps_pd(_mm256_extractf128_ps(m1y, 1)));
+
+    __m256 lhs = _mm256_set_m128(_mm256_cvtpd_ps(lhsHi), _mm256_cvtpd_ps(lhsLo));
+    __m256 rhs = _mm256_set_m128(_mm256_cvtpd_ps(rhsHi), _mm256_cvtpd_ps(rhsLo));
+    return _mm256_add_ps(lhs, rhs);
+}
+
+/// @brief Transforms points in groups of eight into the world points and the x, y and z arrays.
+/// @return The number of points transformed, which is a multiple of eight.
+[[gnu::target("avx2")]] static size_t TransformAVX2(const EGG::Matrix34f &mat,
+        const EGG::Vector3f *points, size_t count, EGG::Vector3f *world, f32 *xs, f32 *ys,
+        f32 *zs) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128 xLo, yLo, zLo, xHi, yHi, zHi;
+        LoadPointsSSE2(points + i, xLo, yLo, zLo);
+        LoadPointsSSE2(points + i + 4, xHi, yHi, zHi);
+        __m256 x = _mm256_set_m128(xHi, xLo);
+        __m256 y = _mm256_set_m128(yHi, yLo);
+        __m256 z = _mm256_set_m128(zHi, zLo);
+
+        __m256 worldX = TransformRowAVX2(mat, 0, x, y, z);
+        __m256 worldY = TransformRowAVX2(mat, 1, x, y, z);
+        __m256 worldZ = TransformRowAVX2(mat, 2, x, y, z);
+
+        _mm256_storeu_ps(xs + i, worldX);
+        _mm256_storeu_ps(ys + i, worldY);
+        _mm256_storeu_ps(zs + i, worldZ);
+        StorePointsSSE2(world + i, _mm256_castps256_ps128(worldX), _mm256_castps256_ps128(worldY),
+                _mm256_castps256_ps128(worldZ));
+        StorePointsSSE2(world + i + 4, _mm256_extractf128_ps(worldX, 1),
+                _mm256_extractf128_ps(worldY, 1), _mm256_extractf128_ps(worldZ, 1));
+    }
+
+    return i;
+}
+
+/// @brief Picks the first maximum out of the candidates found by each of four lanes.
+/// @details Each lane holds the first maximum out of the points it searched, or negative infinity
+/// and -1 if it found nothing greater. The lowest index wins ties between lanes, which matches the
+/// scalar search.
+static inline size_t ReduceSupportSSE2(__m128 best, __m128i bestIdx) {
+    __m128 max = _mm_max_ps(best, _mm_shuffle_ps(best, best, _MM_SHUFFLE(2, 3, 0, 1)));
+    max = _mm_max_ps(max, _mm_shuffle_ps(max, max, _MM_SHUFFLE(1, 0, 3, 2)));
+
+    // Every dot product is negative infinity or NaN, so the first point wins
+    if (_mm_cvtss_f32(max) == -std::numeric_limits<f32>::infinity()) {
+        return 0;
+    }
+
+    __m128i match = _mm_castps_si128(_mm_cmpeq_ps(best, max));
+    __m128i idx = _mm_or_si128(_mm_and_si128(match, bestIdx),
+            _mm_andnot_si128(match, _mm_set1_epi32(std::numeric_limits<s32>::max())));
+
+    __m128i other = _mm_shuffle_epi32(idx, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128i less = _mm_cmplt_epi32(other, idx);
+    idx = _mm_or_si128(_mm_and_si128(less, other), _mm_andnot_si128(less, idx));
+    other = _mm_shuffle_epi32(idx, _MM_SHUFFLE(1, 0, 3, 2));
+    less = _mm_cmplt_epi32(other, idx);
+    idx = _mm_or_si128(_mm_and_si128(less, other), _mm_andnot_si128(less, idx));
+
+    return static_cast<size_t>(_mm_cvtsi128_si32(idx));
+}
+
+/// @brief Searches four points at a time for the first point with the greatest dot product.
+/// @param stride The padded length of each array, which must be a multiple of four.
+static size_t SupportSSE2(const f32 *xs, const f32 *ys, const f32 *zs, size_t stride,
+        const EGG::Vector3f &v) {
+    __m128 vx = _mm_set1_ps(v.x);
+    __m128 vy = _mm_set1_ps(v.y);
+    __m128 vz = _mm_set1_ps(v.z);
+
+    __m128 best = _mm_set1_ps(-std::numeric_limits<f32>::infinity());
+    __m128i bestIdx = _mm_set1_epi32(-1);
+    __m128i idx = _mm_setr_epi32(0, 1, 2, 3);
+    const __m128i step = _mm_set1_epi32(4);
+
+    for (size_t i = 0; i < stride; i += 4) {
+        __m128 xy = _mm_add_ps(_mm_mul_ps(vx, _mm_loadu_ps(xs + i)),
+                _mm_mul_ps(vy, _mm_loadu_ps(ys + i)));
+        __m128 dot = _mm_add_ps(xy, _mm_mul_ps(vz, _mm_loadu_ps(zs + i)));
+
+        // Strictly greater, so that each lane keeps its first maximum and skips NaN padding
+        __m128 mask = _mm_cmplt_ps(best, dot);
+        __m128i maskIdx = _mm_castps_si128(mask);
+        best = _mm_or_ps(_mm_and_ps(mask, dot), _mm_andnot_ps(mask, best));
+        bestIdx = _mm_or_si128(_mm_and_si128(maskIdx, idx), _mm_andnot_si128(maskIdx, bestIdx));
+        idx = _mm_add_epi32(idx, step);
+    }
+
+    return ReduceSupportSSE2(best, bestIdx);
+}
+
+/// @brief Searches eight points at a time for the first point with the greatest dot product.
+/// @param stride The padded length of each array, which must be a multiple of eight.
+[[gnu::target("avx2")]] static size_t SupportAVX2(const f32 *xs, const f32 *ys, const f32 *zs,
+        size_t stride, const EGG::Vector3f &v) {
+    __m256 vx = _mm256_set1_ps(v.x);
+    __m256 vy = _mm256_set1_ps(v.y);
+    __m256 vz = _mm256_set1_ps(v.z);
+
+    __m256 best = _mm256_set1_ps(-std::numeric_limits<f32>::infinity());
+    __m256i bestIdx = _mm256_set1_epi32(-1);
+    __m256i idx = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i step = _mm256_set1_epi32(8);
+
+    for (size_t i = 0; i < stride; i += 8) {
+        __m256 xy = _mm256_add_ps(_mm256_mul_ps(vx, _mm256_loadu_ps(xs + i)),
+                _mm256_mul_ps(vy, _mm256_loadu_ps(ys + i)));
+        __m256 dot = _mm256_add_ps(xy, _mm256_mul_ps(vz, _mm256_loadu_ps(zs + i)));
+
+        // Strictly greater, so that each lane keeps its first maximum and skips NaN padding
+        __m256 mask = _mm256_cmp_ps(best, dot, _CMP_LT_OQ);
+        best = _mm256_blendv_ps(best, dot, mask);
+        bestIdx = _mm256_blendv_epi8(bestIdx, idx, _mm256_castps_si256(mask));
+        idx = _mm256_add_epi32(idx, step);
+    }
+
+    // Fold the upper lanes onto the lower lanes, keeping the first maximum of each pair
+    __m128 bestLo = _mm256_castps256_ps128(best);
+    __m128 bestHi = _mm256_extractf128_ps(best, 1);
+    __m128i idxLo = _mm256_castsi256_si128(bestIdx);
+    __m128i idxHi = _mm256_extracti128_si256(bestIdx, 1);
+
+    __m128 hiWins = _mm_or_ps(_mm_cmplt_ps(bestLo, bestHi),
+            _mm_and_ps(_mm_cmpeq_ps(bestLo, bestHi),
+                    _mm_castsi128_ps(_mm_cmplt_epi32(idxHi, idxLo))));
+    best = _mm256_castps128_ps256(_mm_blendv_ps(bestLo, bestHi, hiWins));
+    __m128i idxFolded = _mm_blendv_epi8(idxLo, idxHi, _mm_castps_si128(hiWins));
+
+    return ReduceSupportSSE2(_mm256_castps256_ps128(best), idxFolded);
+}
+#endif // CONVEX_HULL_SIMD
+
 /// @addr{0x808364E0}
 /// @brief Creates a convex hull with the provided points.
 /// @details The base game has the possibility to only provide a count to allocate space.
@@ -10,6 +243,8 @@ namespace Kinoko::Field {
 ObjectCollisionConvexHull::ObjectCollisionConvexHull(const std::span<const EGG::Vector3f> &points)
     : m_points(points), m_initRadius(70.0f), m_worldPoints(points.size()), m_worldRadius(70.0f) {
     ASSERT(points.size() < 0x100);
+
+    initWorldSoA();
 }
 
 /// @addr{0x808365A8}
@@ -22,13 +257,9 @@ void ObjectCollisionConvexHull::transform(const EGG::Matrix34f &mat, const EGG::
         temp.makeS(EGG::Vector3f(scale.x, scale.x, scale.x));
         temp = mat.multiplyTo(temp);
 
-        for (size_t i = 0; i < m_points.size(); ++i) {
-            m_worldPoints[i] = temp.ps_multVector(m_points[i]);
-        }
+        transformPoints(temp);
     } else {
-        for (size_t i = 0; i < m_points.size(); ++i) {
-            m_worldPoints[i] = mat.ps_multVector(m_points[i]);
-        }
+        transformPoints(mat);
     }
 }
 
@@ -38,22 +269,37 @@ void ObjectCollisionConvexHull::transform(const EGG::Matrix34f &mat, const EGG::
     m_translation = speed;
 
     if (scale.x == 0.0f) {
-        for (size_t i = 0; i < m_points.size(); ++i) {
-            m_worldPoints[i] = mat.ps_multVector(m_points[i]);
-        }
+        transformPoints(mat);
     } else {
         EGG::Matrix34f temp;
         temp.makeS(EGG::Vector3f(scale.x, scale.x, scale.x));
         temp = mat.multiplyTo(temp);
 
-        for (size_t i = 0; i < m_points.size(); ++i) {
-            m_worldPoints[i] = temp.ps_multVector(m_points[i]);
-        }
+        transformPoints(temp);
     }
 }
 
 /// @addr{0x80836628}
 const EGG::Vector3f &ObjectCollisionConvexHull::getSupport(const EGG::Vector3f &v) const {
+#ifdef CONVEX_HULL_SIMD
+    if (s_simdLevel != SimdLevel::Scalar) {
+        // Lanes can't tell a NaN first point apart from padding, but the scalar search never moves
+        // past one, as every comparison against it is false
+        f32 firstDot = v.dot(m_worldPoints[0]);
+        if (firstDot != firstDot) {
+            return m_worldPoints[0];
+        }
+
+        const f32 *xs = m_worldSoA.begin();
+        const f32 *ys = xs + m_soaStride;
+        const f32 *zs = ys + m_soaStride;
+
+        size_t idx = s_simdLevel == SimdLevel::AVX2 ? SupportAVX2(xs, ys, zs, m_soaStride, v) :
+                                                      SupportSSE2(xs, ys, zs, m_soaStride, v);
+        return m_worldPoints[idx];
+    }
+#endif // CONVEX_HULL_SIMD
+
     const EGG::Vector3f *result = &m_worldPoints[0];
     f32 maxDot = v.dot(*result);
 
@@ -70,6 +316,36 @@ const EGG::Vector3f &ObjectCollisionConvexHull::getSupport(const EGG::Vector3f &
     return *result;
 }
 
+/// @brief Selects the instruction set used by every convex hull.
+/// @details Every level gives the same results, so this is only useful for testing.
+void ObjectCollisionConvexHull::SetSimdLevel(SimdLevel level) {
+    if (!IsSimdLevelSupported(level)) {
+        PANIC("SIMD level %d is not supported on this host!", static_cast<s32>(level));
+    }
+
+    s_simdLevel = level;
+}
+
+ObjectCollisionConvexHull::SimdLevel ObjectCollisionConvexHull::GetSimdLevel() {
+    return s_simdLevel;
+}
+
+bool ObjectCollisionConvexHull::IsSimdLevelSupported(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::Scalar:
+        return true;
+#ifdef CONVEX_HULL_SIMD
+    case SimdLevel::SSE2:
+        return true;
+    case SimdLevel::AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif // CONVEX_HULL_SIMD
+    default:
+        return false;
+    }
+}
+
 /// @addr{0x808364E0}
 /// @brief Allocates space for a convex hull with the provided point count.
 /// This overload can only be called via inheritance or delegating constructors.
@@ -83,6 +359,62 @@ ObjectCollisionConvexHull::ObjectCollisionConvexHull(size_t count) : m_initRadiu
 
     m_points = owning_span<EGG::Vector3f>(count);
     m_worldPoints = owning_span<EGG::Vector3f>(count);
+
+    initWorldSoA();
+}
+
+/// @brief Allocates the x, y and z arrays. Padding is NaN, so that it is never a support point.
+void ObjectCollisionConvexHull::initWorldSoA() {
+    m_soaStride = (m_worldPoints.size() + SOA_LANES - 1) / SOA_LANES * SOA_LANES;
+    m_worldSoA = owning_span<f32>(m_soaStride * 3);
+
+    for (auto &val : m_worldSoA) {
+        val = std::numeric_limits<f32>::quiet_NaN();
+    }
 }
 
+/// @brief Transforms every point by a matrix into m_worldPoints and m_worldSoA.
+void ObjectCollisionConvexHull::transformPoints(const EGG::Matrix34f &mat) {
+    size_t count = m_points.size();
+    f32 *xs = m_worldSoA.begin();
+    f32 *ys = xs + m_soaStride;
+    f32 *zs = ys + m_soaStride;
+
+    size_t i = 0;
+
+#ifdef CONVEX_HULL_SIMD
+    if (s_simdLevel == SimdLevel::AVX2) {
+        i = TransformAVX2(mat, m_points.begin(), count, m_worldPoints.begin(), xs, ys, zs);
+    }
+
+    if (s_simdLevel != SimdLevel::Scalar) {
+        i += TransformSSE2(mat, m_points.begin() + i, count - i, m_worldPoints.begin() + i, xs + i,
+                ys + i, zs + i);
+    }
+#endif // CONVEX_HULL_SIMD
+
+    for (; i < count; ++i) {
+        m_worldPoints[i] = mat.ps_multVector(m_points[i]);
+        xs[i] = m_worldPoints[i].x;
+        ys[i] = m_worldPoints[i].y;
+        zs[i] = m_worldPoints[i].z;
+    }
+}
+
+/// @brief Picks the widest instruction set supported by the host.
+ObjectCollisionConvexHull::SimdLevel ObjectCollisionConvexHull::DetectSimdLevel() {
+    if (IsSimdLevelSupported(SimdLevel::AVX2)) {
+        return SimdLevel::AVX2;
+    }
+
+    if (IsSimdLevelSupported(SimdLevel::SSE2)) {
+        return SimdLevel::SSE2;
+    }
+
+    return SimdLevel::Scalar;
+}
+
+ObjectCollisionConvexHull::SimdLevel ObjectCollisionConvexHull::s_simdLevel =
+        ObjectCollisionConvexHull::DetectSimdLevel();
+
 } // namespace Kinoko::Field
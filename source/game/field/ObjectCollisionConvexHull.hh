@@ -5,8 +5,18 @@
 namespace Kinoko::Field {
 
 /// @brief Smallest convex shape that encloses a given set of points.
+/// @details Transformed points are also kept as separate x, y and z arrays, so that support points
+/// can be searched several points at a time. Every SIMD level gives bit-identical results, other
+/// than the sign of NaNs.
 class ObjectCollisionConvexHull : public ObjectCollisionBase {
 public:
+    /// @brief The instruction set used to transform points and search for support points.
+    enum class SimdLevel {
+        Scalar,
+        SSE2,
+        AVX2,
+    };
+
     ObjectCollisionConvexHull(const std::span<const EGG::Vector3f> &points);
     ~ObjectCollisionConvexHull() override;
 
@@ -25,20 +35,42 @@ public:
         return m_initRadius;
     }
 
+    [[nodiscard]] std::span<const EGG::Vector3f> worldPoints() const {
+        return m_worldPoints.view();
+    }
+
     /// @addr{0x8080C414}
     virtual void setBoundingRadius(f32 val) {
         m_worldRadius = val;
     }
 
+    static void SetSimdLevel(SimdLevel level);
+    [[nodiscard]] static SimdLevel GetSimdLevel();
+    [[nodiscard]] static bool IsSimdLevelSupported(SimdLevel level);
+
 protected:
     ObjectCollisionConvexHull(size_t count);
 
     owning_span<EGG::Vector3f> m_points;
 
 private:
+    void initWorldSoA();
+    void transformPoints(const EGG::Matrix34f &mat);
+
+    [[nodiscard]] static SimdLevel DetectSimdLevel();
+
+    /// The number of points searched at once by the widest SIMD level.
+    static constexpr size_t SOA_LANES = 8;
+
     const f32 m_initRadius;
     owning_span<EGG::Vector3f> m_worldPoints;
     f32 m_worldRadius;
+
+    /// @brief m_worldPoints as x, y and z arrays, each padded to a multiple of SOA_LANES with NaN.
+    owning_span<f32> m_worldSoA;
+    size_t m_soaStride; ///< The padded length of each array in m_worldSoA.
+
+    static SimdLevel s_simdLevel;
 };
 
 } // namespace Kinoko::Field
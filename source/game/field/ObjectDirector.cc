@@ -401,8 +401,8 @@ ObjectBase *ObjectDirector::createObject(const System::MapdataGeoObj &params) {
     }
 }
 
-f32 ObjectDirector::s_wanwanMaxPitch; ///< @addr{0x808C70E8}
+THREAD_LOCAL f32 ObjectDirector::s_wanwanMaxPitch; ///< @addr{0x808C70E8}
 
-ObjectDirector *ObjectDirector::s_instance = nullptr; ///< @addr{0x809C4330}
+THREAD_LOCAL ObjectDirector *ObjectDirector::s_instance = nullptr; ///< @addr{0x809C4330}
 
 } // namespace Kinoko::Field
@@ -115,11 +115,11 @@ private:
     ObjectPsea *m_psea;
     fixed_vector<ObjectCollidable *> m_managedObjects;
 
-    static f32 s_wanwanMaxPitch; ///< @addr{0x808C70E8}
+    static THREAD_LOCAL f32 s_wanwanMaxPitch; ///< @addr{0x808C70E8}
 
     static constexpr size_t MAX_MANAGED_OBJECTS = 400; ///< Maximum number of managed objects
 
-    static ObjectDirector *s_instance;
+    static THREAD_LOCAL ObjectDirector *s_instance;
 };
 
 } // namespace Field
@@ -237,6 +237,7 @@ ObjectDrivableDirector::~ObjectDrivableDirector() {
     }
 }
 
-ObjectDrivableDirector *ObjectDrivableDirector::s_instance = nullptr; ///< @addr{0x809C4310}
+/// @addr{0x809C4310}
+THREAD_LOCAL ObjectDrivableDirector *ObjectDrivableDirector::s_instance = nullptr;
 
 } // namespace Kinoko::Field
@@ -54,6 +54,10 @@ public:
         return m_obakeManager;
     }
 
+    [[nodiscard]] bool hasObjects() const {
+        return !m_objects.empty();
+    }
+
     static ObjectDrivableDirector *CreateInstance();
     static void DestroyInstance();
 
@@ -73,7 +77,7 @@ private:
 
     static constexpr size_t MAX_OBJECTS = 400; ///< Maximum number of objects in the vectors
 
-    static ObjectDrivableDirector *s_instance;
+    static THREAD_LOCAL ObjectDrivableDirector *s_instance;
 };
 
 } // namespace Field
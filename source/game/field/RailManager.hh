@@ -53,7 +53,7 @@ private:
     u16 m_extraInterplatorCount;
     u16 m_pointCount;
 
-    static RailManager *s_instance; ///< @addr{0x809C22B0}
+    static THREAD_LOCAL RailManager *s_instance; ///< @addr{0x809C22B0}
 };
 
 } // namespace Field
@@ -41,6 +41,6 @@ void JugemDirector::createUnits() {
     m_unit->createSwitchRace();
 }
 
-JugemDirector *JugemDirector::s_instance = nullptr; ///< @addr{0x809C28B8}
+THREAD_LOCAL JugemDirector *JugemDirector::s_instance = nullptr; ///< @addr{0x809C28B8}
 
 } // namespace Kinoko::Field
@@ -34,7 +34,7 @@ private:
 
     JugemUnit *m_unit; ///< Assumes 1 Lakitu because 1 player
 
-    static JugemDirector *s_instance; ///< @addr{0x809C28B8}
+    static THREAD_LOCAL JugemDirector *s_instance; ///< @addr{0x809C28B8}
 };
 
 } // namespace Kinoko::Field
@@ -126,7 +126,7 @@ void ObjectBasabasa::calc() {
     ++m_cycleTimer;
 }
 
-f32 ObjectBasabasa::s_initialXRange;
-f32 ObjectBasabasa::s_initialYRange;
+THREAD_LOCAL f32 ObjectBasabasa::s_initialXRange;
+THREAD_LOCAL f32 ObjectBasabasa::s_initialYRange;
 
 } // namespace Kinoko::Field
@@ -106,8 +106,8 @@ private:
     u32 m_cycleTimer;         ///< Used to determine when to spawn next bat
     u32 m_batsActive;         ///< The number of bats currently spawned
 
-    static f32 s_initialXRange;
-    static f32 s_initialYRange;
+    static THREAD_LOCAL f32 s_initialXRange;
+    static THREAD_LOCAL f32 s_initialYRange;
 };
 
 } // namespace Kinoko::Field
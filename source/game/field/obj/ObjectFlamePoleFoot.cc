@@ -214,6 +214,6 @@ void ObjectFlamePoleFoot::calcEruptingStay() {
     m_heightOffset = m_scaledHeight + AMPLITUDE * EGG::Mathf::SinFIdx(DEG2FIDX * angle);
 }
 
-u32 ObjectFlamePoleFoot::s_flamePoleCount = 0;
+THREAD_LOCAL u32 ObjectFlamePoleFoot::s_flamePoleCount = 0;
 
 } // namespace Kinoko::Field
@@ -108,7 +108,7 @@ private:
     f32 m_eruptAccel;
     f32 m_initEruptVel;
 
-    static u32 s_flamePoleCount;
+    static THREAD_LOCAL u32 s_flamePoleCount;
 
     static constexpr std::array<StateManagerEntry, 6> STATE_ENTRIES = {{
             {StateEntry<ObjectFlamePoleFoot, &ObjectFlamePoleFoot::enterExpanding,
@@ -51,6 +51,6 @@ ItemDirector::~ItemDirector() {
     }
 }
 
-ItemDirector *ItemDirector::s_instance = nullptr; ///< @addr{0x809C3618}
+THREAD_LOCAL ItemDirector *ItemDirector::s_instance = nullptr; ///< @addr{0x809C3618}
 
 } // namespace Kinoko::Item
@@ -47,7 +47,7 @@ private:
 
     owning_span<KartItem> m_karts;
 
-    static ItemDirector *s_instance; ///< @addr{0x809C3618}
+    static THREAD_LOCAL ItemDirector *s_instance; ///< @addr{0x809C3618}
 };
 
 } // namespace Item
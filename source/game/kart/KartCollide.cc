@@ -9,6 +9,7 @@
 #include "game/field/ObjectCollisionKart.hh"
 #include "game/field/ObjectDirector.hh"
 
+#include <abstract/Profiler.hh>
 #include <egg/math/BoundBox.hh>
 #include <egg/math/Math.hh>
 
@@ -64,6 +65,8 @@ void KartCollide::calcHitboxes() {
 /// @stage All
 /// @addr{0x80572C20}
 void KartCollide::findCollision() {
+    PROFILE_SCOPE(KartBodyCollision);
+
     bool wasHalfPipe = status().onBit(eStatus::EndHalfPipe, eStatus::ActionMidZipper);
     const EGG::Quatf &rot = wasHalfPipe ? mainRot() : fullRot();
     calcBodyCollision(move()->totalScale(), body()->sinkDepth(), rot, scale());
@@ -556,6 +559,8 @@ void KartCollide::calcBoundingRadius() {
 
 /// @addr{0x80571F10}
 void KartCollide::calcObjectCollision() {
+    PROFILE_SCOPE(KartObjectCollision);
+
     constexpr f32 COS_PI_OVER_4 = 0.707f;
     constexpr s32 DUMMY_POLE_ANG_VEL_TIME = 3;
     constexpr f32 DUMMY_POLE_ANG_VEL = 0.005f;
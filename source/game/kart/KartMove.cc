@@ -21,6 +21,7 @@
 #include "game/system/map/MapdataCannonPoint.hh"
 #include "game/system/map/MapdataJugemPoint.hh"
 
+#include <abstract/Profiler.hh>
 #include <egg/math/Math.hh>
 #include <egg/math/Quat.hh>
 
@@ -288,6 +289,8 @@ void KartMove::setInitialPhysicsValues(const EGG::Vector3f &position, const EGG:
 /// @details Calls various functions to handle drifts, hops, boosts.
 /// Afterwards, calculates the kart's speed and rotation.
 void KartMove::calc() {
+    PROFILE_SCOPE(KartMove);
+
     auto &status = KartObjectProxy::status();
 
     if (status.onBit(eStatus::InRespawn)) {
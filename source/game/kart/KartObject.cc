@@ -148,7 +148,7 @@ void KartObject::createSub() {
 
 /// @addr{0x8058F820}
 void KartObject::createModel() {
-    s_proxyList.clear();
+    proxyList().clear();
 
     if (isBike()) {
         m_pointers.model = EGG::egg_new<Render::KartModelBike>();
@@ -178,7 +178,7 @@ const KartAccessor *KartObject::accessor() const {
 
 /// @addr{0x8058F5B4}
 KartObject *KartObject::Create(Character character, Vehicle vehicle, u8 playerIdx) {
-    s_proxyList.clear();
+    proxyList().clear();
 
     KartParam *param = EGG::egg_new<KartParam>(character, vehicle, playerIdx);
 
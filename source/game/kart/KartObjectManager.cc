@@ -82,10 +82,9 @@ KartObjectManager::~KartObjectManager() {
     EGG::egg_delete(s_thunderScaleDownAnmChr);
     EGG::egg_delete(s_pressScaleUpAnmChr);
 
-    // If the proxy list is not cleared when we're done with the KartObjectManager, the list's
-    // destructor calls delete on all of the links remaining in the list. Since the heaps are
-    // gone by that point, this results in a segmentation fault. So, we clear the links here.
-    KartObjectProxy::proxyList().clear();
+    // The proxy list and its links are allocated on the race's heap, so they are freed along with
+    // the KartObjectManager rather than outliving the heap.
+    KartObjectProxy::DestroyProxyList();
 }
 
 /// @addr{0x8056AB6C}
@@ -103,9 +102,9 @@ void KartObjectManager::loadScaleAnimations() {
     s_pressScaleUpAnmChr = EGG::egg_new<Abstract::g3d::ResAnmChr>(resAnmChr);
 }
 
-Abstract::g3d::ResAnmChr *KartObjectManager::s_thunderScaleUpAnmChr = nullptr;
-Abstract::g3d::ResAnmChr *KartObjectManager::s_thunderScaleDownAnmChr = nullptr;
-Abstract::g3d::ResAnmChr *KartObjectManager::s_pressScaleUpAnmChr = nullptr;
-KartObjectManager *KartObjectManager::s_instance = nullptr;
+THREAD_LOCAL Abstract::g3d::ResAnmChr *KartObjectManager::s_thunderScaleUpAnmChr = nullptr;
+THREAD_LOCAL Abstract::g3d::ResAnmChr *KartObjectManager::s_thunderScaleDownAnmChr = nullptr;
+THREAD_LOCAL Abstract::g3d::ResAnmChr *KartObjectManager::s_pressScaleUpAnmChr = nullptr;
+THREAD_LOCAL KartObjectManager *KartObjectManager::s_instance = nullptr;
 
 } // namespace Kinoko::Kart
@@ -20,7 +20,7 @@ namespace Kinoko::Kart {
 
 /// @addr{0x8059018C}
 KartObjectProxy::KartObjectProxy() : m_accessor(nullptr) {
-    s_proxyList.push_back(this);
+    proxyList().push_back(this);
 }
 
 KartObjectProxy::~KartObjectProxy() = default;
@@ -466,12 +466,29 @@ void KartObjectProxy::apply(size_t idx) {
 /// @brief For all proxies in the static list, synchronizes all pointers to the KartAccessor.
 /// @param pointers The pointer to synchronize all other proxies to.
 void KartObjectProxy::ApplyAll(const KartAccessor *pointers) {
-    for (auto iter = s_proxyList.begin(); iter != s_proxyList.end(); ++iter) {
+    auto &list = proxyList();
+    for (auto iter = list.begin(); iter != list.end(); ++iter) {
         (*iter)->m_accessor = pointers;
     }
 }
 
-std::list<KartObjectProxy *, EGG::Allocator<KartObjectProxy *>>
-        KartObjectProxy::s_proxyList; ///< @addr{0x809C1900}
+/// @brief Gets the list of all KartObjectProxy children, creating it on the current heap if needed.
+std::list<KartObjectProxy *, EGG::Allocator<KartObjectProxy *>> &KartObjectProxy::proxyList() {
+    if (!s_proxyList) {
+        s_proxyList =
+                EGG::egg_new<std::list<KartObjectProxy *, EGG::Allocator<KartObjectProxy *>>>();
+    }
+
+    return *s_proxyList;
+}
+
+/// @brief Frees the list of all KartObjectProxy children, along with its links.
+void KartObjectProxy::DestroyProxyList() {
+    EGG::egg_delete(s_proxyList);
+    s_proxyList = nullptr;
+}
+
+THREAD_LOCAL std::list<KartObjectProxy *, EGG::Allocator<KartObjectProxy *>>
+        *KartObjectProxy::s_proxyList = nullptr; ///< @addr{0x809C1900}
 
 } // namespace Kinoko::Kart
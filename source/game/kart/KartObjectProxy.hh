@@ -14,6 +14,12 @@
 
 namespace Kinoko {
 
+namespace Host {
+
+class Context;
+
+} // namespace Host
+
 namespace Field {
 
 class BoxColUnit;
@@ -71,6 +77,7 @@ struct KartAccessor {
 /// @nosubgrouping
 class KartObjectProxy {
     friend class KartObject;
+    friend class Host::Context;
 
 public:
     KartObjectProxy();
@@ -170,11 +177,11 @@ public:
     [[nodiscard]] KartParam::Stats::DriftType vehicleType() const;
 
     [[nodiscard]] static std::list<KartObjectProxy *, EGG::Allocator<KartObjectProxy *>> &
-    proxyList() {
-        return s_proxyList;
-    }
+    proxyList();
     /// @endGetters
 
+    static void DestroyProxyList();
+
 protected:
     void apply(size_t idx);
 
@@ -183,8 +190,11 @@ private:
 
     const KartAccessor *m_accessor;
 
-    static std::list<KartObjectProxy *, EGG::Allocator<KartObjectProxy *>>
-            s_proxyList; ///< List of all KartObjectProxy children.
+    /// @brief List of all KartObjectProxy children.
+    /// @details Unlike the base game, the list itself is allocated on the heap along with its
+    /// links, so that contexts and arenas only need to save a pointer to it.
+    static THREAD_LOCAL std::list<KartObjectProxy *, EGG::Allocator<KartObjectProxy *>>
+            *s_proxyList;
 };
 
 } // namespace Kart
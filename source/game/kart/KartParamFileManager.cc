@@ -207,6 +207,6 @@ bool KartParamFileManager::validate() const {
     return true;
 }
 
-KartParamFileManager *KartParamFileManager::s_instance = nullptr;
+THREAD_LOCAL KartParamFileManager *KartParamFileManager::s_instance = nullptr;
 
 } // namespace Kinoko::Kart
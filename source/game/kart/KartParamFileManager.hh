@@ -72,7 +72,7 @@ private:
     FileInfo m_kartDispParam;   // kartPartsDispParam.bin
     FileInfo m_kartCameraParam; // kartCameraParam.bin
 
-    static KartParamFileManager *s_instance;
+    static THREAD_LOCAL KartParamFileManager *s_instance;
 };
 
 } // namespace Kart
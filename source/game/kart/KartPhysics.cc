@@ -1,5 +1,6 @@
 #include "KartPhysics.hh"
 
+#include <abstract/Profiler.hh>
 #include <egg/math/Quat.hh>
 
 namespace Kinoko::Kart {
@@ -54,6 +55,8 @@ void KartPhysics::updatePose() {
 /// @param maxSpeed 120.0f, unless we're in a bullet (145.0f)
 /// @param air Whether we're touching ground. Currently unused.
 void KartPhysics::calc(f32 dt, f32 maxSpeed, const EGG::Vector3f &scale, bool air) {
+    PROFILE_SCOPE(KartPhysics);
+
     m_specialRot = m_instantaneousStuntRot * m_decayingStuntRot;
     m_extraRot = m_instantaneousExtraRot * m_decayingExtraRot;
 
@@ -15,6 +15,7 @@
 #include "game/system/RaceConfig.hh"
 #include "game/system/RaceManager.hh"
 
+#include <abstract/Profiler.hh>
 #include <egg/math/Math.hh>
 
 namespace Kinoko::Kart {
@@ -101,6 +102,8 @@ void KartSub::resetPhysics() {
 /// @details Handles the first-half of physics calculations. This includes input processing,
 /// subsequent position/speed updates, as well as responding to last frame's collisions.
 void KartSub::calcPass0() {
+    PROFILE_SCOPE(KartCalcPass0);
+
     auto &status = KartObjectProxy::status();
 
     if (status.onBit(eStatus::CannonStart)) {
@@ -175,6 +178,8 @@ void KartSub::calcPass0() {
 /// Handles the second-half of physics calculations. This mainly includes
 /// collision detection, as well as suspension physics.
 void KartSub::calcPass1() {
+    PROFILE_SCOPE(KartCalcPass1);
+
     constexpr s16 SIDE_COLLISION_TIME = 5;
 
     state()->resetEjection();
@@ -7,6 +7,7 @@
 #include "game/kart/KartSub.hh"
 #include "game/kart/KartTire.hh"
 
+#include <abstract/Profiler.hh>
 #include <egg/math/Math.hh>
 
 namespace Kinoko::Kart {
@@ -171,6 +172,8 @@ void KartSuspensionPhysics::setInitialState() {
 /// @addr{0x8059A278}
 void KartSuspensionPhysics::calcCollision(f32 dt, const EGG::Vector3f &gravity,
         const EGG::Matrix34f &mat) {
+    PROFILE_SCOPE(KartWheelCollision);
+
     m_maxTravelScaled = m_bspWheel->maxTravel * sub()->someScale();
 
     EGG::Vector3f scaledRelPos = m_bspWheel->relPosition * scale();
@@ -198,6 +198,6 @@ void KartCamera::calcCollision(KartCameraState &state, bool isBackwards) const {
     }
 }
 
-KartCamera *KartCamera::s_instance = nullptr;
+THREAD_LOCAL KartCamera *KartCamera::s_instance = nullptr;
 
 } // namespace Kinoko::Render
@@ -1,5 +1,7 @@
 #include "GameScene.hh"
 
+#include "game/field/ObjectDrivableDirector.hh"
+
 #include "game/render/KartCamera.hh"
 
 #include "game/system/KPadDirector.hh"
@@ -84,9 +86,26 @@ void GameScene::initCamera() {
 
 /// @addr{0x805A1AF0}
 void GameScene::calcCamera() {
+    // The camera's collision checks only leave behind query state that every other check resets
+    // first, except against drivable objects, whose collision matrices are refreshed and reused.
+    // Model calculations are never skipped, as KartModel sets the body's angle.
+    if (s_headless && !Field::ObjectDrivableDirector::Instance()->hasObjects()) {
+        return;
+    }
+
     Render::KartCamera::Instance()->calc();
 }
 
+/// @brief Sets whether to skip the camera, which the race never reads from.
+/// @details On courses with drivable objects, the camera still runs. @see calcCamera.
+void GameScene::SetHeadless(bool isHeadless) {
+    s_headless = isHeadless;
+}
+
+bool GameScene::IsHeadless() {
+    return s_headless;
+}
+
 /// @addr{0x8051AA58}
 void GameScene::appendResource(System::MultiDvdArchive *archive, s32 id) {
     m_resources.push_back(EGG::egg_new<Resource>(archive, id));
@@ -209,4 +228,6 @@ void GameScene::IncreaseTagCount(void * /*block*/, Abstract::Memory::MEMiHeapHea
 }
 #endif // BUILD_DEBUG
 
+bool GameScene::s_headless = false;
+
 } // namespace Kinoko::Scene
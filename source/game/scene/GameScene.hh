@@ -32,6 +32,9 @@ public:
     static void initCamera();
     static void calcCamera();
 
+    static void SetHeadless(bool isHeadless);
+    [[nodiscard]] static bool IsHeadless();
+
 protected:
     void appendResource(System::MultiDvdArchive *archive, s32 id);
 
@@ -63,6 +66,8 @@ private:
     int m_nextSceneId;
 
     [[maybe_unused]] size_t m_totalMemoryUsed;
+
+    static bool s_headless; ///< Whether to skip render-only work where it can't affect the race.
 };
 
 } // namespace Kinoko::Scene
@@ -15,6 +15,7 @@
 #include "game/system/ResourceManager.hh"
 
 #include <ScopeLock.hh>
+#include <abstract/Profiler.hh>
 
 namespace Kinoko::Scene {
 
@@ -106,13 +107,15 @@ void RaceScene::initEngines() {
 /// @details In Kinoko, it is not possible to pause the race scene, so Kinoko's implementation for
 /// this function is really the base game's `calcEnginesUnpaused` located at `0x80554AD4`.
 void RaceScene::calcEngines() {
+    PROFILE_SCOPE(CalcEngines);
+
     auto *raceMgr = System::RaceManager::Instance();
-    raceMgr->calc();
-    Field::BoxColManager::Instance()->calc();
-    Field::ObjectDirector::Instance()->calc();
-    Kart::KartObjectManager::Instance()->calc();
-    Field::JugemDirector::Instance()->calc();
-    Item::ItemDirector::Instance()->calc();
+    PROFILE_CALL(RaceManager, raceMgr->calc());
+    PROFILE_CALL(BoxColManager, Field::BoxColManager::Instance()->calc());
+    PROFILE_CALL(ObjectDirector, Field::ObjectDirector::Instance()->calc());
+    PROFILE_CALL(KartObjectManager, Kart::KartObjectManager::Instance()->calc());
+    PROFILE_CALL(JugemDirector, Field::JugemDirector::Instance()->calc());
+    PROFILE_CALL(ItemDirector, Item::ItemDirector::Instance()->calc());
     raceMgr->random().next();
 }
 
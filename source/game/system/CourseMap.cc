@@ -32,6 +32,11 @@ void CourseMap::init() {
 
     ASSERT(m_area);
     m_area->sort();
+    m_area->buildIndex();
+
+    if (m_checkPoint) {
+        m_checkPoint->buildSectorIndex();
+    }
 
     MapdataStageInfo *stageInfo = getStageInfo();
     constexpr u8 TRANSLATION_MODE_NARROW = 1;
@@ -53,11 +58,13 @@ void CourseMap::init() {
 s16 CourseMap::findSector(const EGG::Vector3f &pos, u16 checkpointIdx, f32 &distanceRatio) {
     clearSectorChecked();
 
+    ++s_sectorSearchStats.searches;
+    m_sectorCandidates = m_checkPoint->sectorCandidates(pos);
+
     MapdataCheckPoint *checkpoint = getCheckPoint(checkpointIdx);
     s16 id = -1;
 
-    MapdataCheckPoint::SectorOccupancy occupancy =
-            checkpoint->checkSectorAndDistanceRatio(pos, distanceRatio);
+    MapdataCheckPoint::SectorOccupancy occupancy = testSector(checkpoint, pos, distanceRatio);
     checkpoint->setSearched();
 
     switch (occupancy) {
@@ -82,7 +89,12 @@ s16 CourseMap::findSector(const EGG::Vector3f &pos, u16 checkpointIdx, f32 &dist
         break;
     }
 
-    return id > -1 ? id : findSectorRegional(pos, checkpoint, distanceRatio);
+    if (id == -1) {
+        id = findSectorRegional(pos, checkpoint, distanceRatio);
+    }
+
+    m_sectorCandidates = nullptr;
+    return id;
 }
 
 /// @addr{0x80511110}
@@ -98,7 +110,7 @@ s16 CourseMap::findRecursiveSector(const EGG::Vector3f &pos, s16 depth, bool sea
             MapdataCheckPoint::SectorOccupancy::OutsideSector;
 
     if (!checkpoint->searched()) {
-        completion = checkpoint->checkSectorAndDistanceRatio(pos, distanceRatio);
+        completion = testSector(checkpoint, pos, distanceRatio);
         checkpoint->setSearched();
     }
 
@@ -196,14 +208,8 @@ s16 CourseMap::getCurrentAreaID(s16 i, const EGG::Vector3f &pos, MapdataAreaBase
     }
 
     // Search all areas of the same type
-    for (i = 0; i < getAreaCount(); ++i) {
-        const MapdataAreaBase *area = getAreaSorted(i);
-        if (area->type() == type && area->test(pos)) {
-            return area->index();
-        }
-    }
-
-    return -1;
+    const MapdataAreaBase *area = m_area->findSorted(pos, type);
+    return area ? area->index() : -1;
 }
 
 /// @addr{0x80512694}
@@ -224,7 +230,8 @@ void CourseMap::DestroyInstance() {
 /// @addr{0x8051276C}
 CourseMap::CourseMap()
     : m_course(nullptr), m_startPoint(nullptr), m_stageInfo(nullptr), m_startTmpAngle(0.0f),
-      m_startTmp0(0.0f), m_startTmp1(0.0f), m_startTmp2(0.0f), m_startTmp3(0.0f) {}
+      m_startTmp0(0.0f), m_startTmp1(0.0f), m_startTmp2(0.0f), m_startTmp3(0.0f),
+      m_sectorCandidates(nullptr) {}
 
 /// @addr{0x805127AC}
 CourseMap::~CourseMap() {
@@ -482,6 +489,22 @@ s16 CourseMap::searchPrevCheckpoint(const EGG::Vector3f &pos, s16 depth,
     return id;
 }
 
+/// @brief Tests whether the player is within a checkpoint's sector, unless the sector index rules
+/// the checkpoint out.
+/// @details Checkpoints are ruled out when the position can't be between their sides, so the test
+/// could only return OutsideSector, which never sets the distance ratio.
+MapdataCheckPoint::SectorOccupancy CourseMap::testSector(const MapdataCheckPoint *checkpoint,
+        const EGG::Vector3f &pos, f32 &distanceRatio) const {
+    u16 id = checkpoint->id();
+    if (m_sectorCandidates && (m_sectorCandidates[id / 32] & (1u << (id % 32))) == 0) {
+        ++s_sectorSearchStats.skippedTests;
+        return MapdataCheckPoint::SectorOccupancy::OutsideSector;
+    }
+
+    ++s_sectorSearchStats.tests;
+    return checkpoint->checkSectorAndDistanceRatio(pos, distanceRatio);
+}
+
 /// @addr{0x80511E00}
 void CourseMap::clearSectorChecked() {
     for (size_t i = 0; i < m_checkPoint->size(); ++i) {
@@ -494,6 +517,8 @@ void *CourseMap::LoadFile(const char *filename) {
     return ResourceManager::Instance()->getFile(filename, nullptr, ArchiveId::Course);
 }
 
-CourseMap *CourseMap::s_instance = nullptr; ///< @addr{0x809BD6E8}
+THREAD_LOCAL CourseMap *CourseMap::s_instance = nullptr; ///< @addr{0x809BD6E8}
+
+THREAD_LOCAL CourseMap::SectorSearchStats CourseMap::s_sectorSearchStats = {0, 0, 0};
 
 } // namespace Kinoko::System
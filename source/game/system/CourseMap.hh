@@ -36,6 +36,13 @@ class CourseMap : EGG::Disposer {
     friend class Host::Context;
 
 public:
+    /// @brief Counts the checkpoint sector tests made by findSector since the last reset.
+    struct SectorSearchStats {
+        u32 searches;     ///< Calls to findSector.
+        u32 tests;        ///< Checkpoints tested.
+        u32 skippedTests; ///< Checkpoints the sector index ruled out without testing.
+    };
+
     void init();
 
     template <MapdataDerived T>
@@ -180,6 +187,14 @@ public:
     static CourseMap *CreateInstance();
     static void DestroyInstance();
 
+    [[nodiscard]] static const SectorSearchStats &GetSectorSearchStats() {
+        return s_sectorSearchStats;
+    }
+
+    static void ResetSectorSearchStats() {
+        s_sectorSearchStats = {0, 0, 0};
+    }
+
     [[nodiscard]] static CourseMap *Instance() {
         return s_instance;
     }
@@ -202,6 +217,9 @@ private:
     [[nodiscard]] s16 searchPrevCheckpoint(const EGG::Vector3f &pos, s16 depth,
             const MapdataCheckPoint *checkpoint, f32 &completion, bool playerIsForwards,
             bool useCache) const;
+    [[nodiscard]] MapdataCheckPoint::SectorOccupancy testSector(
+            const MapdataCheckPoint *checkpoint, const EGG::Vector3f &pos,
+            f32 &distanceRatio) const;
     void clearSectorChecked();
 
     MapdataFileAccessor *m_course;
@@ -222,9 +240,14 @@ private:
     f32 m_startTmp2;
     f32 m_startTmp3;
 
+    /// During findSector, the checkpoints the position may be between the sides of.
+    /// @see MapdataCheckPointAccessor::sectorCandidates.
+    const u32 *m_sectorCandidates;
+
     static void *LoadFile(const char *filename); ///< @addr{0x809BD6E8}
 
-    static CourseMap *s_instance;
+    static THREAD_LOCAL CourseMap *s_instance;
+    static THREAD_LOCAL SectorSearchStats s_sectorSearchStats;
 };
 
 } // namespace System
@@ -1,15 +1,18 @@
 #include "DvdArchive.hh"
 
+#include <abstract/ArchiveCache.hh>
 #include <abstract/File.hh>
 
 #include <egg/core/Decomp.hh>
 
+#include <cstring>
+
 namespace Kinoko::System {
 
 /// @addr{0x80518CC0}
 DvdArchive::DvdArchive()
     : m_archive(nullptr), m_archiveStart(nullptr), m_archiveSize(0), m_fileStart(nullptr),
-      m_fileSize(0), m_state(State::Cleared) {}
+      m_fileSize(0), m_state(State::Cleared), m_archiveRetained(false) {}
 
 /// @addr{0x80518CF4}
 DvdArchive::~DvdArchive() {
@@ -25,6 +28,36 @@ void DvdArchive::decompress() {
     m_state = State::Decompressed;
 }
 
+/// @brief Decompresses the ripped file, or reuses its decompression from a previous launch.
+/// @details Not in the base game. Decompressing is a large part of startup, and is repeated for
+/// every process. If the archive cache is enabled, the decompressed archive is looked up there
+/// first, and stored there otherwise. Cache hits are copied into the heap rather than used in
+/// place, so that a Host::Context saves them like any other archive, and restoring one never refers
+/// to an entry released since.
+/// @param path The path the file was ripped from.
+void DvdArchive::decompressCached(const char *path) {
+    if (!Abstract::ArchiveCache::IsEnabled()) {
+        decompress();
+        return;
+    }
+
+    auto key = Abstract::ArchiveCache::CreateKey(path, m_fileStart, m_fileSize);
+
+    size_t size = 0;
+    void *archive = Abstract::ArchiveCache::Load(key, size);
+    if (archive) {
+        m_archiveStart = EGG::egg_alloc(size);
+        m_archiveSize = size;
+        memcpy(m_archiveStart, archive, size);
+        Abstract::ArchiveCache::Release(archive);
+        m_state = State::Decompressed;
+        return;
+    }
+
+    decompress();
+    Abstract::ArchiveCache::Store(key, m_archiveStart, m_archiveSize);
+}
+
 /// @addr{0x80519420}
 void *DvdArchive::getFile(const char *filename, size_t *size) const {
     if (m_state != State::Mounted) {
@@ -61,7 +94,7 @@ void DvdArchive::load(const char *path, bool decompress_) {
 
     if (m_state == State::Ripped) {
         if (decompress_) {
-            decompress();
+            decompressCached(path);
             clearFile();
         } else {
             move();
@@ -102,6 +135,20 @@ void DvdArchive::mount() {
     m_state = State::Mounted;
 }
 
+/// @brief Mounts an archive that was decompressed outside of the heap.
+/// @details Not in the base game. The archive is owned by ResourceManager, which keeps it across
+/// scenes, so it is left alone when this archive is cleared. @see ResourceManager::SetRetainBudget.
+/// @param archiveStart The decompressed archive.
+/// @param archiveSize The size of the decompressed archive.
+void DvdArchive::mountRetained(void *archiveStart, size_t archiveSize) {
+    ASSERT(m_state == State::Cleared);
+
+    m_archiveStart = archiveStart;
+    m_archiveSize = archiveSize;
+    m_archiveRetained = true;
+    mount();
+}
+
 /// @addr{0x805195A4}
 void DvdArchive::move() {
     m_archiveStart = m_fileStart;
@@ -131,7 +178,12 @@ void DvdArchive::clearArchive() {
         return;
     }
 
-    EGG::egg_free(static_cast<u8 *>(m_archiveStart));
+    if (m_archiveRetained) {
+        m_archiveRetained = false;
+    } else {
+        EGG::egg_free(static_cast<u8 *>(m_archiveStart));
+    }
+
     m_archiveStart = nullptr;
     m_archiveSize = 0;
 }
@@ -22,6 +22,7 @@ public:
     void load(const DvdArchive *other);
     void load(void *fileStart, size_t fileSize, bool decompress_);
     void mount();
+    void mountRetained(void *archiveStart, size_t archiveSize);
     void move();
     void rip(const char *path);
 
@@ -39,12 +40,15 @@ public:
     }
 
 private:
+    void decompressCached(const char *path);
+
     EGG::Archive *m_archive;
     void *m_archiveStart;
     size_t m_archiveSize;
     void *m_fileStart;
     size_t m_fileSize;
     State m_state;
+    bool m_archiveRetained; ///< Whether m_archiveStart is owned by ResourceManager.
 };
 
 } // namespace Kinoko::System
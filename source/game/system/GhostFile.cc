@@ -155,4 +155,77 @@ bool RawGhostFile::isValid(const u8 *rkg) const {
     return true;
 }
 
+/// @brief Checks whether a ghost file can be replayed, without panicking.
+/// @details This covers what isValid() checks, along with the file size, the course and, for
+/// compressed ghosts, the input stream. Files which pass can be handed to init().
+/// @param rkg The ghost file, which must be at least size bytes long.
+/// @param size The size of the ghost file.
+/// @return nullptr if the ghost is valid, or else the reason why it isn't.
+const char *RawGhostFile::FindError(const u8 *rkg, size_t size) {
+    if (size < RKG_HEADER_SIZE || size > sizeof(RawGhostFile)) {
+        return "Invalid file size";
+    }
+
+    if (strncmp(reinterpret_cast<const char *>(rkg), "RKGD", 4) != 0) {
+        return "RKG header malformed";
+    }
+
+    u32 course = (parse<u32>(*reinterpret_cast<const u32 *>(rkg + 0x4)) >> 0x2) & 0x3f;
+    if (course >= std::size(COURSE_NAMES)) {
+        return "Invalid course";
+    }
+
+    u32 ids = parse<u32>(*reinterpret_cast<const u32 *>(rkg + 0x8));
+    Vehicle vehicle = static_cast<Vehicle>(ids >> 0x1a);
+    Character character = static_cast<Character>((ids >> 0x14) & 0x3f);
+    u8 year = (ids >> 0xd) & 0x7f;
+    u8 day = (ids >> 0x4) & 0x1f;
+    u8 month = (ids >> 0x9) & 0xf;
+
+    if (vehicle >= Vehicle::Max || character >= Character::Max) {
+        return "Invalid character or vehicle";
+    }
+
+    if (year >= 100 || day >= 32 || month > 12) {
+        return "Invalid date";
+    }
+
+    WeightClass charWeight = CharacterToWeight(character);
+    WeightClass vehicleWeight = VehicleToWeight(vehicle);
+    if (charWeight == WeightClass::Invalid || vehicleWeight == WeightClass::Invalid) {
+        return "Invalid weight class";
+    }
+
+    if (charWeight != vehicleWeight) {
+        return "Character/Bike weight class mismatch";
+    }
+
+    if (((rkg[0xC] >> 3) & 1) == 0) {
+        return nullptr;
+    }
+
+    // The compressed input data is preceded by its size
+    constexpr size_t STREAM_OFFSET = RKG_HEADER_SIZE + 0x4;
+    if (size < STREAM_OFFSET) {
+        return "Missing compressed input data";
+    }
+
+    u32 streamSize = parse<u32>(*reinterpret_cast<const u32 *>(rkg + RKG_HEADER_SIZE));
+    if (streamSize > size - STREAM_OFFSET) {
+        return "Truncated compressed input data";
+    }
+
+    const u8 *stream = rkg + STREAM_OFFSET;
+    if (!EGG::Decomp::IsValidSZS(stream, streamSize)) {
+        return "Malformed compressed input data";
+    }
+
+    if (static_cast<u32>(EGG::Decomp::GetExpandSize(stream)) >
+            RKG_UNCOMPRESSED_INPUT_DATA_SECTION_SIZE) {
+        return "Invalid compressed input data size";
+    }
+
+    return nullptr;
+}
+
 } // namespace Kinoko::System
@@ -54,6 +54,8 @@ public:
     [[nodiscard]] bool decompress(const u8 *rkg);
     [[nodiscard]] bool isValid(const u8 *rkg) const;
 
+    [[nodiscard]] static const char *FindError(const u8 *rkg, size_t size);
+
     [[nodiscard]] const u8 *buffer() const {
         return m_buffer;
     }
@@ -0,0 +1,267 @@
+#include "GhostTimeline.hh"
+
+#include <abstract/CRC32.hh>
+
+#include <egg/core/Heap.hh>
+
+#include <algorithm>
+#include <cstring>
+
+namespace Kinoko::System {
+
+typedef std::array<KPadGhostButtonsStream *, 3> GhostStreams;
+
+/// @brief Sets the inputs of a frame from the values read from each stream.
+/// @addr{0x80520B9C}
+static void SetFrame(RaceInputState &state, u8 buttons, u8 sticks, u8 trickRaw) {
+    state.buttons = buttons;
+    state.stickXRaw = sticks >> 4 & 0xF;
+    state.stickYRaw = sticks & 0xF;
+    state.stick = EGG::Vector2f(RawStickToState(state.stickXRaw), RawStickToState(state.stickYRaw));
+    state.trickRaw = trickRaw;
+
+    switch (state.trickRaw >> 4) {
+    case 1:
+        state.trick = Trick::Up;
+        break;
+    case 2:
+        state.trick = Trick::Down;
+        break;
+    case 3:
+        state.trick = Trick::Left;
+        break;
+    case 4:
+        state.trick = Trick::Right;
+        break;
+    default:
+        state.trick = Trick::None;
+        break;
+    }
+}
+
+/// @brief Reads the next frame from each stream, as the ghost controller does in the base game.
+static void ReadFrame(const GhostStreams &streams, RaceInputState &state) {
+    u8 buttons = streams[0]->readFrame();
+    u8 sticks = streams[1]->readFrame();
+    u8 trickRaw = streams[2]->readFrame();
+    SetFrame(state, buttons, sticks, trickRaw);
+}
+
+/// @brief Splits the input data section into a stream for each kind of input.
+/// @addr{Inlined in 0x80521844}
+/// @details The buffer is split into three sections: face buttons, analog stick, and the D-Pad.
+/// Each section is an array of tuples, where each tuple contains the input state and the duration
+/// of that input state. This is used to minimize data consumption given that the user is not
+/// changing inputs every frame. We first read in the header of the RKG input data section as
+/// follows:
+/// Offset  | Size | Description
+///------------- | ------------- | -------------
+/// 0x00  | 2 bytes | Count of face button input tuples
+/// 0x02  | 2 bytes | Count of analog stick input tuples
+/// 0x04  | 2 bytes | Count of D-Pad input tuples
+/// 0x06  | 2 bytes | Unknown. Probably padding.
+/// 0x08  | | End of header, beginning of face button input data.
+static void OpenStreams(const u8 *inputs, const GhostStreams &streams) {
+    constexpr u32 SEQUENCE_SIZE = 0x2;
+
+    EGG::RamStream stream = EGG::RamStream(inputs, RKG_UNCOMPRESSED_INPUT_DATA_SECTION_SIZE);
+
+    u16 faceCount = stream.read_u16();
+    u16 directionCount = stream.read_u16();
+    u16 trickCount = stream.read_u16();
+
+    stream.skip(2);
+
+    streams[0]->buffer = stream.split(faceCount * SEQUENCE_SIZE);
+    streams[1]->buffer = stream.split(directionCount * SEQUENCE_SIZE);
+    streams[2]->buffer = stream.split(trickCount * SEQUENCE_SIZE);
+}
+
+/// @brief Moves each stream back to its first tuple, as if the ghost controller was just reset.
+static void RewindStreams(const GhostStreams &streams) {
+    for (auto *stream : streams) {
+        stream->buffer.jump(0);
+        stream->currentSequence = 0;
+        stream->readSequenceFrames = 0;
+        stream->state = 1;
+    }
+}
+
+/// @brief Gets the value a stream holds on a frame.
+static u8 StreamValue(const RaceInputState &state, size_t stream) {
+    switch (stream) {
+    case 0:
+        return static_cast<u8>(state.buttons);
+    case 1:
+        return static_cast<u8>((state.stickXRaw & 0xF) << 4 | (state.stickYRaw & 0xF));
+    default:
+        return static_cast<u8>(state.trick) & 0x7;
+    }
+}
+
+GhostTimeline::GhostTimeline() {
+    allocate(0);
+    SetFrame(m_frames[0], 0, 0, 0);
+}
+
+GhostTimeline::GhostTimeline(const u8 *inputs) {
+    decode(inputs);
+}
+
+GhostTimeline::~GhostTimeline() = default;
+
+/// @brief Expands an input data section into a state for every frame.
+/// @details The streams are read until every one of them runs out, and then once more for the
+/// state that is played back afterwards.
+/// @param inputs The uncompressed input data section. See GhostFile::inputs.
+void GhostTimeline::decode(const u8 *inputs) {
+    KPadGhostFaceButtonsStream face;
+    KPadGhostDirectionButtonsStream direction;
+    KPadGhostTrickButtonsStream trick;
+    GhostStreams streams = {&face, &direction, &trick};
+    OpenStreams(inputs, streams);
+
+    auto isReading = [&streams] {
+        return std::any_of(streams.begin(), streams.end(),
+                [](const auto *stream) { return stream->state == 1; });
+    };
+
+    // The streams are read twice, first to find how many frames the longest one lasts
+    RaceInputState state;
+    size_t frameCount = 0;
+    for (RewindStreams(streams); isReading(); ++frameCount) {
+        ReadFrame(streams, state);
+    }
+
+    allocate(frameCount);
+    RewindStreams(streams);
+    for (auto &frame : m_frames) {
+        ReadFrame(streams, frame);
+    }
+}
+
+/// @brief Encodes the timeline into an input data section.
+/// @details As the game saves ghosts, every stream lasts until the end of the timeline, and each
+/// tuple lasts as long as its value doesn't change, up to the longest duration the stream can hold.
+/// @param inputs Where to write the section, which must hold
+/// RKG_UNCOMPRESSED_INPUT_DATA_SECTION_SIZE bytes. Bytes past the end of the section are zeroed.
+/// @return The size of the section, or 0 if the inputs change too often to fit.
+size_t GhostTimeline::encode(u8 *inputs) const {
+    constexpr std::array<u16, 3> MAX_DURATIONS = {0xFF, 0xFF, 0xFFF};
+
+    memset(inputs, 0, RKG_UNCOMPRESSED_INPUT_DATA_SECTION_SIZE);
+    size_t offset = 0x8;
+
+    // The game can't read an empty stream
+    size_t end = std::max<size_t>(m_frameCount, 1);
+
+    for (size_t i = 0; i < MAX_DURATIONS.size(); ++i) {
+        u16 count = 0;
+        for (size_t frame = 0; frame < end;) {
+            u8 value = StreamValue(playback(frame), i);
+            u16 duration = 1;
+            while (frame + duration < end && duration < MAX_DURATIONS[i] &&
+                    StreamValue(playback(frame + duration), i) == value) {
+                ++duration;
+            }
+
+            if (offset + 2 > RKG_UNCOMPRESSED_INPUT_DATA_SECTION_SIZE) {
+                return 0;
+            }
+
+            // The upper bits of trick durations share a byte with the trick
+            if (i == 2) {
+                inputs[offset] = static_cast<u8>(value << 4 | duration >> 8);
+            } else {
+                inputs[offset] = value;
+            }
+            inputs[offset + 1] = static_cast<u8>(duration);
+
+            offset += 2;
+            ++count;
+            frame += duration;
+        }
+
+        inputs[2 * i] = static_cast<u8>(count >> 8);
+        inputs[2 * i + 1] = static_cast<u8>(count);
+    }
+
+    return offset;
+}
+
+/// @brief Writes a ghost file with the timeline's inputs.
+/// @details Compressed inputs are written as the game saves ghosts, with a Yaz1 stream padded to a
+/// multiple of four bytes. Data some ghosts have past the CRC, such as extension footers, is not
+/// written.
+/// @param ghost The ghost to take the header from.
+/// @param rkg Where to write the file, which must hold RKG_MAX_WRITE_SIZE bytes.
+/// @param compress Whether to compress the input data section.
+/// @return The size of the file, or 0 if the inputs change too often to fit.
+size_t GhostTimeline::writeRKG(const RawGhostFile &ghost, u8 *rkg, bool compress) const {
+    std::array<u8, RKG_UNCOMPRESSED_INPUT_DATA_SECTION_SIZE> inputs;
+    size_t inputSize = encode(inputs.data());
+    if (inputSize == 0) {
+        return 0;
+    }
+
+    memcpy(rkg, ghost.buffer(), RKG_HEADER_SIZE);
+    rkg[0xE] = static_cast<u8>(inputSize >> 8);
+    rkg[0xF] = static_cast<u8>(inputSize);
+
+    size_t size = RKG_HEADER_SIZE;
+    if (compress) {
+        rkg[0xC] |= 0x8;
+
+        u8 *stream = rkg + RKG_HEADER_SIZE + 0x4;
+        size_t streamSize = EGG::Decomp::EncodeSZS(inputs.data(), inputSize, stream);
+        stream[3] = '1';
+        for (; streamSize % 4 != 0; ++streamSize) {
+            stream[streamSize] = 0;
+        }
+
+        *reinterpret_cast<u32 *>(rkg + size) = parse<u32>(static_cast<u32>(streamSize));
+        size += 0x4 + streamSize;
+    } else {
+        rkg[0xC] &= 0xF7;
+
+        memcpy(rkg + size, inputs.data(), inputs.size());
+        size += inputs.size();
+    }
+
+    u32 crc = Abstract::CalcCRC32(rkg, size);
+    *reinterpret_cast<u32 *>(rkg + size) = parse<u32>(crc);
+    return size + 0x4;
+}
+
+/// @brief Replaces a range of frames with any number of others.
+/// @param frame The first frame to replace.
+/// @param eraseCount The number of frames to remove.
+/// @param frames The frames to insert in their place, which may be from this timeline.
+void GhostTimeline::splice(size_t frame, size_t eraseCount,
+        std::span<const RaceInputState> frames) {
+    ASSERT(frame + eraseCount <= m_frameCount);
+
+    owning_span<RaceInputState> previous = std::move(m_frames);
+    allocate(m_frameCount - eraseCount + frames.size());
+
+    auto *out = std::copy(previous.begin(), previous.begin() + frame, m_frames.begin());
+    out = std::copy(frames.begin(), frames.end(), out);
+    std::copy(previous.begin() + frame + eraseCount, previous.end(), out);
+}
+
+/// @brief Allocates the frames, and the state after the end, in the heap the timeline is in.
+/// @details The ghost controller outlives the race scene, whose heap is current when the ghost is
+/// read, so its frames must not be allocated in that heap.
+void GhostTimeline::allocate(size_t frameCount) {
+    EGG::Heap *heap = EGG::Heap::findContainHeap(this);
+    EGG::Heap *previous = heap ? heap->becomeCurrentHeap() : nullptr;
+
+    m_frames = owning_span<RaceInputState>(frameCount + 1);
+    m_frameCount = frameCount;
+
+    if (previous) {
+        previous->becomeCurrentHeap();
+    }
+}
+
+} // namespace Kinoko::System
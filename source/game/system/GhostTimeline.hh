@@ -0,0 +1,60 @@
+#pragma once
+
+#include "game/system/KPadController.hh"
+
+#include <egg/core/Decomp.hh>
+
+#include <span>
+
+namespace Kinoko::System {
+
+/// @brief The most bytes GhostTimeline::writeRKG writes, when nothing can be compressed.
+static constexpr size_t RKG_MAX_WRITE_SIZE = RKG_HEADER_SIZE + 0x4 +
+        EGG::Decomp::GetEncodeBound(RKG_UNCOMPRESSED_INPUT_DATA_SECTION_SIZE) + 0x3 + 0x4;
+
+/// @brief A ghost's inputs, expanded to one input state per frame.
+/// @details The base game reads a ghost's input streams one frame at a time, and can only move
+/// forward through them. The timeline decodes them once, so that any frame can be read, edited or
+/// replaced directly, and encodes them back into an input data section afterwards.
+///
+/// Streams which run out before the others read as zero, which is also how frames past the end of
+/// the timeline are played back. Only the buttons, raw stick and trick of each frame are encoded.
+class GhostTimeline {
+public:
+    GhostTimeline();
+    GhostTimeline(const u8 *inputs);
+    ~GhostTimeline();
+
+    void decode(const u8 *inputs);
+    [[nodiscard]] size_t encode(u8 *inputs) const;
+    [[nodiscard]] size_t writeRKG(const RawGhostFile &ghost, u8 *rkg, bool compress) const;
+
+    void splice(size_t frame, size_t eraseCount, std::span<const RaceInputState> frames);
+
+    /// @brief Gets the inputs the ghost controller reads on a frame, including past the end.
+    [[nodiscard]] const RaceInputState &playback(size_t frame) const {
+        return m_frames[std::min(frame, m_frameCount)];
+    }
+
+    [[nodiscard]] RaceInputState &operator[](size_t frame) {
+        ASSERT(frame < m_frameCount);
+        return m_frames[frame];
+    }
+
+    [[nodiscard]] const RaceInputState &operator[](size_t frame) const {
+        ASSERT(frame < m_frameCount);
+        return m_frames[frame];
+    }
+
+    [[nodiscard]] size_t size() const {
+        return m_frameCount;
+    }
+
+private:
+    void allocate(size_t frameCount);
+
+    owning_span<RaceInputState> m_frames; ///< Every frame, followed by the state after the end.
+    size_t m_frameCount;
+};
+
+} // namespace Kinoko::System
@@ -1,5 +1,7 @@
 #include "KPadController.hh"
 
+#include "game/system/GhostTimeline.hh"
+
 #include <cstring>
 
 namespace Kinoko::System {
@@ -13,61 +15,32 @@ void KPadController::calc() {
 }
 
 /// @addr{0x80520730}
-KPadGhostController::KPadGhostController() : m_acceptingInputs(false) {
-    m_buttonsStreams[0] = EGG::egg_new<KPadGhostFaceButtonsStream>();
-    m_buttonsStreams[1] = EGG::egg_new<KPadGhostDirectionButtonsStream>();
-    m_buttonsStreams[2] = EGG::egg_new<KPadGhostTrickButtonsStream>();
+KPadGhostController::KPadGhostController()
+    : m_ghostBuffer(nullptr), m_frame(0), m_acceptingInputs(false) {
+    m_timeline = EGG::egg_new<GhostTimeline>();
 }
 
 /// @addr{0x80520924}
 KPadGhostController::~KPadGhostController() = default;
 
 /// @addr{0x80520998}
+/// @details Unlike the base game, which continues reading its streams from wherever they are, the
+/// timeline is played back from the start.
 void KPadGhostController::reset(bool driftIsAuto) {
     m_driftIsAuto = driftIsAuto;
     m_raceInputState.reset();
-
-    for (auto &stream : m_buttonsStreams) {
-        stream->currentSequence = 0;
-        stream->readSequenceFrames = 0;
-        stream->state = 1;
-    }
-
+    m_frame = 0;
     m_acceptingInputs = false;
     m_connected = true;
 }
 
 /// @brief Reads in the raw input data section from the ghost RKG file.
 /// @addr{Inlined in 0x80521844}
-/// @details The buffer is split into three sections: face buttons, analog stick, and the D-Pad.
-/// Each section is an array of tuples, where each tuple contains the input state and the duration
-/// of that input state. This is used to minimize data consumption given that the user is not
-/// changing inputs every frame. We first read in the header of the RKG input data section as
-/// follows:
-/// Offset  | Size | Description
-///------------- | ------------- | -------------
-/// 0x00  | 2 bytes | Count of face button input tuples
-/// 0x02  | 2 bytes | Count of analog stick input tuples
-/// 0x04  | 2 bytes | Count of D-Pad input tuples
-/// 0x06  | 2 bytes | Unknown. Probably padding.
-/// 0x08  | | End of header, beginning of face button input data.
+/// @details The whole ghost is decoded up front, rather than a frame at a time. See GhostTimeline.
 void KPadGhostController::readGhostBuffer(const u8 *buffer, bool driftIsAuto) {
-    constexpr u32 SEQUENCE_SIZE = 0x2;
-
     m_ghostBuffer = buffer;
     m_driftIsAuto = driftIsAuto;
-
-    EGG::RamStream stream = EGG::RamStream(buffer, RKG_UNCOMPRESSED_INPUT_DATA_SECTION_SIZE);
-
-    u16 faceCount = stream.read_u16();
-    u16 directionCount = stream.read_u16();
-    u16 trickCount = stream.read_u16();
-
-    stream.skip(2);
-
-    m_buttonsStreams[0]->buffer = stream.split(faceCount * SEQUENCE_SIZE);
-    m_buttonsStreams[1]->buffer = stream.split(directionCount * SEQUENCE_SIZE);
-    m_buttonsStreams[2]->buffer = stream.split(trickCount * SEQUENCE_SIZE);
+    m_timeline->decode(buffer);
 }
 
 /// @addr{0x80520B9C}
@@ -76,31 +49,7 @@ void KPadGhostController::calcImpl() {
         return;
     }
 
-    m_raceInputState.buttons = m_buttonsStreams[0]->readFrame();
-    u8 sticks = m_buttonsStreams[1]->readFrame();
-    m_raceInputState.stickXRaw = sticks >> 4 & 0xF;
-    m_raceInputState.stickYRaw = sticks & 0xF;
-    m_raceInputState.stick = EGG::Vector2f(RawStickToState(m_raceInputState.stickXRaw),
-            RawStickToState(m_raceInputState.stickYRaw));
-    m_raceInputState.trickRaw = m_buttonsStreams[2]->readFrame();
-
-    switch (m_raceInputState.trickRaw >> 4) {
-    case 1:
-        m_raceInputState.trick = Trick::Up;
-        break;
-    case 2:
-        m_raceInputState.trick = Trick::Down;
-        break;
-    case 3:
-        m_raceInputState.trick = Trick::Left;
-        break;
-    case 4:
-        m_raceInputState.trick = Trick::Right;
-        break;
-    default:
-        m_raceInputState.trick = Trick::None;
-        break;
-    }
+    m_raceInputState = m_timeline->playback(m_frame++);
 }
 
 RaceInputState::RaceInputState() {
@@ -6,6 +6,8 @@
 
 namespace Kinoko::System {
 
+class GhostTimeline;
+
 /// @brief Converts a raw stick input into an input usable by the state.
 /// @param rawStick The raw stick input to convert.
 /// @return The converted input.
@@ -230,9 +232,15 @@ public:
         m_acceptingInputs = set;
     }
 
+    /// @brief The ghost's inputs, which may be edited before or during playback.
+    [[nodiscard]] GhostTimeline *timeline() const {
+        return m_timeline;
+    }
+
 private:
     const u8 *m_ghostBuffer;
-    std::array<KPadGhostButtonsStream *, 3> m_buttonsStreams;
+    GhostTimeline *m_timeline; ///< Replaces the base game's streams, which are read frame by frame.
+    u32 m_frame;               ///< The next frame of the timeline to play back.
     bool m_acceptingInputs;
 };
 
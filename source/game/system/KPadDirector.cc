@@ -66,6 +66,6 @@ KPadDirector::~KPadDirector() {
     }
 }
 
-KPadDirector *KPadDirector::s_instance = nullptr; ///< @addr{0x809BD70C}
+THREAD_LOCAL KPadDirector *KPadDirector::s_instance = nullptr; ///< @addr{0x809BD70C}
 
 } // namespace Kinoko::System
@@ -56,7 +56,7 @@ private:
     KPadGhostController *m_ghostController;
     KPadHostController *m_hostController;
 
-    static KPadDirector *s_instance; ///< @addr{0x809BD70C}
+    static THREAD_LOCAL KPadDirector *s_instance; ///< @addr{0x809BD70C}
 };
 
 } // namespace System
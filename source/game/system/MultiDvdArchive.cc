@@ -87,6 +87,13 @@ void MultiDvdArchive::load(const MultiDvdArchive *other) {
     }
 }
 
+/// @brief Mounts an archive that ResourceManager keeps across scenes.
+/// @details Not in the base game. Only single archives are retained.
+void MultiDvdArchive::mountRetained(void *archiveStart, size_t archiveSize) {
+    ASSERT(m_archiveCount == 1);
+    m_archives[0].mountRetained(archiveStart, archiveSize);
+}
+
 /// @addr{0x8052AB6C}
 void MultiDvdArchive::rip(const char *filename) {
     char buffer[256];
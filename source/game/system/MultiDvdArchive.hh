@@ -20,6 +20,7 @@ public:
     void *getFile(const char *filename, size_t *size) const;
     void load(const char *filename);
     void load(const MultiDvdArchive *other);
+    void mountRetained(void *archiveStart, size_t archiveSize);
     void rip(const char *filename);
 
     void clear();
@@ -95,7 +95,7 @@ void RaceConfig::Scenario::init() {
     }
 }
 
-RaceConfig *RaceConfig::s_instance = nullptr; ///< @addr{0x809BD728}
+THREAD_LOCAL RaceConfig *RaceConfig::s_instance = nullptr; ///< @addr{0x809BD728}
 
 /** @brief Host-agnostic way of initializing RaceConfig.
     The type of the first player *must* be set to either Local or Ghost.
@@ -105,9 +105,9 @@ RaceConfig *RaceConfig::s_instance = nullptr; ///< @addr{0x809BD728}
     - If the type is Local, the race scenario's course and the first player's character, vehicle,
     and driftIsAuto must be set.
 */
-RaceConfig::InitCallback RaceConfig::s_onInitCallback = nullptr;
+THREAD_LOCAL RaceConfig::InitCallback RaceConfig::s_onInitCallback = nullptr;
 
 /// @brief The argument sent into the callback. This is expected to be reinterpret_casted.
-void *RaceConfig::s_onInitCallbackArg = nullptr;
+THREAD_LOCAL void *RaceConfig::s_onInitCallbackArg = nullptr;
 
 } // namespace Kinoko::System
@@ -92,9 +92,9 @@ private:
     Scenario m_raceScenario;
     RawGhostFile m_ghost;
 
-    static RaceConfig *s_instance; ///< @addr{0x809BD728}
-    static InitCallback s_onInitCallback;
-    static void *s_onInitCallbackArg;
+    static THREAD_LOCAL RaceConfig *s_instance; ///< @addr{0x809BD728}
+    static THREAD_LOCAL InitCallback s_onInitCallback;
+    static THREAD_LOCAL void *s_onInitCallbackArg;
 };
 
 } // namespace System
@@ -299,6 +299,6 @@ void RaceManager::Player::endRace(const Timer &finishTime) {
     RaceManager::Instance()->endPlayerRace(0);
 }
 
-RaceManager *RaceManager::s_instance = nullptr; ///< @addr{0x809BD730}
+THREAD_LOCAL RaceManager *RaceManager::s_instance = nullptr; ///< @addr{0x809BD730}
 
 } // namespace Kinoko::System
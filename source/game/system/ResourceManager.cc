@@ -2,6 +2,15 @@
 
 #include "game/system/RaceConfig.hh"
 
+#include <abstract/ArchiveCache.hh>
+#include <abstract/File.hh>
+
+#include <egg/core/Decomp.hh>
+
+#include <cstring>
+#include <mutex>
+#include <new>
+
 namespace Kinoko::System {
 
 #define ARCHIVE_COUNT 2
@@ -11,6 +20,9 @@ static const char *const RESOURCE_PATHS[] = {
         nullptr,
 };
 
+/// @brief Guards the retained archives, which races on every thread share.
+static std::mutex s_retainMutex;
+
 /// @addr{0x805411FC}
 void *ResourceManager::getFile(const char *filename, size_t *size, ArchiveId id) {
     s32 idx = static_cast<s32>(id);
@@ -37,7 +49,10 @@ MultiDvdArchive *ResourceManager::load(s32 idx, const char *filename) {
     }
 
     if (!m_archives[idx]->isLoaded() && filename) {
-        m_archives[idx]->load(filename);
+        // Only the default archives are retained. The core archives don't depend on the course.
+        if (filename != RESOURCE_PATHS[idx] || !mountRetained(idx, Course{}, filename)) {
+            m_archives[idx]->load(filename);
+        }
     }
 
     return m_archives[idx];
@@ -47,13 +62,26 @@ MultiDvdArchive *ResourceManager::load(s32 idx, const char *filename) {
 MultiDvdArchive *ResourceManager::load(Course courseId) {
     char buffer[256];
     snprintf(buffer, sizeof(buffer), "Race/Course/%s", COURSE_NAMES[static_cast<s32>(courseId)]);
-    m_archives[1]->load(buffer);
+    if (m_archives[1]->isLoaded() || !mountRetained(1, courseId, buffer)) {
+        m_archives[1]->load(buffer);
+    }
     return m_archives[1];
 }
 
 /// @addr{0x805411E4}
 void ResourceManager::unmount(MultiDvdArchive *archive) {
     archive->unmount();
+
+    std::lock_guard lock(s_retainMutex);
+    for (u8 i = 0; i < ARCHIVE_COUNT; i++) {
+        if (m_archives[i] == archive && m_retained[i]) {
+            --m_retained[i]->mountCount;
+            m_retained[i] = nullptr;
+        }
+    }
+
+    // Archives that were mounted when the budget was lowered can only be freed now
+    TrimRetained(s_retainBudget, 0);
 }
 
 /// @addr{0x8053FC4C}
@@ -71,8 +99,34 @@ void ResourceManager::DestroyInstance() {
     EGG::egg_delete(instance);
 }
 
+/// @brief Sets the memory that decompressed archives may keep using across scenes.
+/// @details Not in the base game. Every scene otherwise reads and decompresses Common and the
+/// course archive again. Retained archives are kept outside of the heap, keyed by archive index and
+/// course, and the least recently mounted are freed to stay within the budget. As they are shared
+/// between scenes, this is only safe while nothing writes to archive files in place. An archive is
+/// never freed while it is mounted, including by a Host::Context which could restore it.
+/// @param budget The budget in bytes, or 0 to disable retention and free every unmounted archive.
+void ResourceManager::SetRetainBudget(size_t budget) {
+    std::lock_guard lock(s_retainMutex);
+    s_retainBudget = budget;
+    TrimRetained(budget, 0);
+}
+
+size_t ResourceManager::RetainBudget() {
+    return s_retainBudget;
+}
+
+/// @brief The memory currently used by retained archives, including those still mounted.
+size_t ResourceManager::RetainedSize() {
+    return s_retainedSize;
+}
+
+const ResourceManager::RetainStats &ResourceManager::GetRetainStats() {
+    return s_retainStats;
+}
+
 /// @addr{0x8053FCEC}
-ResourceManager::ResourceManager() {
+ResourceManager::ResourceManager() : m_retained{} {
     m_archives = static_cast<MultiDvdArchive **>(
             EGG::egg_alloc(ARCHIVE_COUNT * sizeof(MultiDvdArchive *)));
     for (u8 i = 0; i < ARCHIVE_COUNT; i++) {
@@ -96,6 +150,189 @@ MultiDvdArchive *ResourceManager::Create(u8 i) {
     }
 }
 
-ResourceManager *ResourceManager::s_instance = nullptr;
+/// @brief Mounts a retained archive, decompressing and retaining it first if needed.
+/// @param idx The index of the archive to mount into.
+/// @param course The course the archive belongs to, for the course archive.
+/// @param path The path to load the archive from, without the extension.
+/// @return Whether the archive was mounted. Otherwise, it should be loaded into the heap as usual.
+bool ResourceManager::mountRetained(s32 idx, Course course, const char *path) {
+    // Held while decompressing, so that races loading the same course on other threads wait for it
+    // rather than decompressing it again
+    std::lock_guard lock(s_retainMutex);
+    if (s_retainBudget == 0) {
+        return false;
+    }
+
+    RetainedArchive *retained = nullptr;
+    for (auto &entry : s_retained) {
+        if (entry.data && entry.idx == idx && (idx != 1 || entry.course == course)) {
+            retained = &entry;
+            break;
+        }
+    }
+
+    if (retained) {
+        ++s_retainStats.hits;
+    } else {
+        ++s_retainStats.misses;
+        retained = RetainArchive(idx, course, path);
+        if (!retained) {
+            return false;
+        }
+    }
+
+    retained->lastUse = ++s_retainClock;
+    ++retained->mountCount;
+    m_retained[idx] = retained;
+    m_archives[idx]->mountRetained(retained->data, retained->size);
+    return true;
+}
+
+/// @brief Decompresses an archive outside of the heap, to be kept across scenes.
+/// @details The compressed file is still ripped into the current heap, but only briefly. As in
+/// DvdArchive, the decompressed archive is looked up in, or stored to, the archive cache.
+/// @return The retained archive, or nullptr if it doesn't exist or doesn't fit in the budget.
+RetainedArchive *ResourceManager::RetainArchive(s32 idx, Course course,
+        const char *path) {
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "%s%s", path, SZS_EXTENSION);
+
+    // Loading a missing file panics, whereas the caller should fall back to loading it as usual
+    if (!Abstract::File::Exists(buffer)) {
+        return nullptr;
+    }
+
+    size_t fileSize = 0;
+    u8 *file = Abstract::File::Load(buffer, fileSize);
+    if (fileSize == 0) {
+        EGG::egg_free(file);
+        return nullptr;
+    }
+
+    auto key = Abstract::ArchiveCache::CreateKey(buffer, file, fileSize);
+    size_t size = 0;
+    void *cached = Abstract::ArchiveCache::Load(key, size);
+    if (!cached) {
+        size = EGG::Decomp::GetExpandSize(file);
+    }
+
+    TrimRetained(s_retainBudget, size);
+
+    auto *entry = std::find_if(s_retained.begin(), s_retained.end(),
+            [](const RetainedArchive &entry) { return !entry.data; });
+    if (entry == s_retained.end() || s_retainedSize + size > s_retainBudget) {
+        if (cached) {
+            Abstract::ArchiveCache::Release(cached);
+        }
+        EGG::egg_free(file);
+        return nullptr;
+    }
+
+    void *data = operator new(size, std::align_val_t{32});
+    if (cached) {
+        memcpy(data, cached, size);
+        Abstract::ArchiveCache::Release(cached);
+    } else {
+        EGG::Decomp::DecodeSZS(file, static_cast<u8 *>(data));
+        Abstract::ArchiveCache::Store(key, data, size);
+    }
+
+    EGG::egg_free(file);
+
+    entry->data = data;
+    entry->size = size;
+    entry->idx = idx;
+    entry->course = course;
+    entry->lastUse = 0;
+    entry->mountCount = 0;
+    s_retainedSize += size;
+
+    return entry;
+}
+
+/// @brief Gets the retained archives mounted by the instance, for Host::Context to hold on to.
+ResourceManager::RetainedMounts ResourceManager::GetRetainedMounts() {
+    return s_instance ? s_instance->m_retained : RetainedMounts{};
+}
+
+/// @brief Counts another mount of each retained archive, so that it isn't evicted.
+void ResourceManager::AcquireRetained(const RetainedMounts &mounts) {
+    // Contexts are copied often, usually with retention disabled
+    if (mounts == RetainedMounts{}) {
+        return;
+    }
+
+    std::lock_guard lock(s_retainMutex);
+    for (RetainedArchive *retained : mounts) {
+        if (retained) {
+            ++retained->mountCount;
+        }
+    }
+}
+
+/// @brief Counts one less mount of each retained archive, freeing any that are now over budget.
+void ResourceManager::ReleaseRetained(const RetainedMounts &mounts) {
+    if (mounts == RetainedMounts{}) {
+        return;
+    }
+
+    std::lock_guard lock(s_retainMutex);
+    for (RetainedArchive *retained : mounts) {
+        if (retained) {
+            ASSERT(retained->mountCount > 0);
+            --retained->mountCount;
+        }
+    }
+
+    TrimRetained(s_retainBudget, 0);
+}
+
+/// @brief Frees the least recently mounted archives that aren't mounted, until the incoming one
+/// fits in the budget and a slot is free for it.
+/// @param budget The budget to fit in.
+/// @param incomingSize The size of the archive about to be retained, or 0 if none.
+void ResourceManager::TrimRetained(size_t budget, size_t incomingSize) {
+    auto isFull = [incomingSize] {
+        return incomingSize > 0 &&
+                std::none_of(s_retained.begin(), s_retained.end(),
+                        [](const RetainedArchive &entry) { return !entry.data; });
+    };
+
+    while (s_retainedSize + incomingSize > budget || isFull()) {
+        RetainedArchive *victim = nullptr;
+        for (auto &entry : s_retained) {
+            if (!entry.data || entry.mountCount > 0) {
+                continue;
+            }
+
+            if (!victim || entry.lastUse < victim->lastUse) {
+                victim = &entry;
+            }
+        }
+
+        if (!victim) {
+            break;
+        }
+
+        FreeRetained(*victim);
+        ++s_retainStats.evictions;
+    }
+}
+
+void ResourceManager::FreeRetained(RetainedArchive &entry) {
+    operator delete(entry.data, std::align_val_t{32});
+    s_retainedSize -= entry.size;
+    entry.data = nullptr;
+    entry.size = 0;
+}
+
+THREAD_LOCAL ResourceManager *ResourceManager::s_instance = nullptr;
+
+std::array<RetainedArchive, ResourceManager::MAX_RETAINED_ARCHIVES>
+        ResourceManager::s_retained = {};
+size_t ResourceManager::s_retainBudget = 0;
+size_t ResourceManager::s_retainedSize = 0;
+u32 ResourceManager::s_retainClock = 0;
+ResourceManager::RetainStats ResourceManager::s_retainStats = {0, 0, 0};
 
 } // namespace Kinoko::System
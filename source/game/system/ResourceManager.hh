@@ -17,6 +17,21 @@ enum class ArchiveId {
     Course = 1,
 };
 
+/// @brief A decompressed archive kept outside of the heap, so that it outlives scenes.
+/// @see ResourceManager::SetRetainBudget.
+struct RetainedArchive {
+    void *data; ///< nullptr if the slot is free.
+    size_t size;
+    s32 idx;
+    Course course; ///< Only compared for the course archive.
+    u32 lastUse;   ///< Used to evict the least recently mounted archive.
+
+    /// The number of ResourceManagers it is mounted by, one per Host::Arena, plus the number of
+    /// Host::Contexts holding a copy of a ResourceManager it is mounted by. Contexts count too, as
+    /// restoring one mounts the archive again without going through ResourceManager.
+    u32 mountCount;
+};
+
 /// @addr{0x809BD738}
 /// @brief Highest level abstraction for archive management and subsequent file retrieval.
 /// @details ResourceManager is responsible for loading and unloading archives. For example, it is
@@ -25,6 +40,13 @@ class ResourceManager : EGG::Disposer {
     friend class Host::Context;
 
 public:
+    /// @brief Counts how retained archives were used since launch. @see SetRetainBudget.
+    struct RetainStats {
+        u32 hits;
+        u32 misses;
+        u32 evictions;
+    };
+
     void *getFile(const char *filename, size_t *size, ArchiveId id);
     void *getBsp(Vehicle vehicle, size_t *size);
     [[nodiscard]] MultiDvdArchive *load(Course courseId);
@@ -39,6 +61,11 @@ public:
     static ResourceManager *CreateInstance();
     static void DestroyInstance();
 
+    static void SetRetainBudget(size_t budget);
+    [[nodiscard]] static size_t RetainBudget();
+    [[nodiscard]] static size_t RetainedSize();
+    [[nodiscard]] static const RetainStats &GetRetainStats();
+
     [[nodiscard]] static ResourceManager *Instance() {
         return s_instance;
     }
@@ -46,15 +73,38 @@ public:
 private:
     EGG_NEW_DELETE_FRIEND
 
+    /// @brief The retained archive mounted at each index, if any.
+    typedef std::array<RetainedArchive *, 2> RetainedMounts;
+
     ResourceManager();
     ~ResourceManager() override;
 
+    [[nodiscard]] bool mountRetained(s32 idx, Course course, const char *path);
+
     // 0: Core archive
     // 1: Course archive
     MultiDvdArchive **m_archives;
+    RetainedMounts m_retained;
 
     [[nodiscard]] static MultiDvdArchive *Create(u8 i);
-    static ResourceManager *s_instance; ///< @addr{0x809BD738}
+    [[nodiscard]] static RetainedArchive *RetainArchive(s32 idx, Course course, const char *path);
+    [[nodiscard]] static RetainedMounts GetRetainedMounts();
+    static void AcquireRetained(const RetainedMounts &mounts);
+    static void ReleaseRetained(const RetainedMounts &mounts);
+    static void TrimRetained(size_t budget, size_t incomingSize);
+    static void FreeRetained(RetainedArchive &entry);
+
+    static THREAD_LOCAL ResourceManager *s_instance; ///< @addr{0x809BD738}
+
+    static constexpr size_t MAX_RETAINED_ARCHIVES = 16;
+
+    /// @brief Decompressed archives kept across scenes, which Host::Context never restores. Unlike
+    /// the instance, they are shared by every thread.
+    static std::array<RetainedArchive, MAX_RETAINED_ARCHIVES> s_retained;
+    static size_t s_retainBudget; ///< The most memory retained archives may use. 0 disables them.
+    static size_t s_retainedSize;
+    static u32 s_retainClock;
+    static RetainStats s_retainStats;
 };
 
 } // namespace System
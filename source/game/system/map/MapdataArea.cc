@@ -2,6 +2,8 @@
 
 #include "game/system/CourseMap.hh"
 
+#include <cmath>
+
 namespace Kinoko::System {
 
 /// @addr{0x80516050}
@@ -179,4 +181,200 @@ void MapdataAreaAccessor::sort() {
     }
 }
 
+/// @brief Computes the XZ bounds of an area's bounding sphere.
+/// @details The sphere is padded, so that rounding in MapdataAreaBase::test can never accept a
+/// position outside of the bounds.
+/// @return Whether the bounds are finite.
+static bool GetAreaBounds(const MapdataAreaBase *area, EGG::Vector2f &min, EGG::Vector2f &max) {
+    const EGG::Vector3f &pos = area->position();
+    f32 radius = std::sqrt(area->sqBoundingSphereRadius()) * 1.001f + 1.0f;
+
+    min = EGG::Vector2f(pos.x - radius, pos.z - radius);
+    max = EGG::Vector2f(pos.x + radius, pos.z + radius);
+    // Infinite heights cancel out to NaN distances, which pass the bounding sphere test
+    return std::isfinite(pos.y) && std::isfinite(min.x) && std::isfinite(min.y) &&
+            std::isfinite(max.x) && std::isfinite(max.y);
+}
+
+/// @brief Maps a coordinate within a grid's bounds to a column or row.
+/// @details This never decreases as the coordinate increases, so any position within an area's
+/// bounds falls within the cells the area is listed in.
+static u32 GridCell(f32 coord, f32 min, f32 invCellSize, u32 dim) {
+    f32 cell = std::min((coord - min) * invCellSize, static_cast<f32>(dim - 1));
+    return static_cast<u32>(std::max(cell, 0.0f));
+}
+
+/// @brief Builds a grid for each area type, so that findSorted only tests nearby areas.
+void MapdataAreaAccessor::buildIndex() {
+    // Types are read as signed bytes, so they're counted by their unsigned representation
+    std::array<bool, 256> present = {};
+    size_t typeCount = 0;
+    for (u16 i = 0; i < m_entryCount; ++i) {
+        u8 type = static_cast<u8>(m_entries[i]->type());
+        if (!present[type]) {
+            present[type] = true;
+            ++typeCount;
+        }
+    }
+
+    m_grids = owning_span<AreaGrid>(typeCount);
+
+    size_t gridIdx = 0;
+    for (size_t type = 0; type < present.size(); ++type) {
+        if (present[type]) {
+            buildGrid(m_grids[gridIdx++],
+                    static_cast<MapdataAreaBase::Type>(static_cast<s8>(static_cast<u8>(type))));
+        }
+    }
+}
+
+/// @brief Finds the first area of a type that contains a position, in order of priority.
+/// @details This always returns the same area as testing every sorted area in turn.
+/// @return The area, or nullptr if no area of the type contains the position.
+MapdataAreaBase *MapdataAreaAccessor::findSorted(const EGG::Vector3f &pos,
+        MapdataAreaBase::Type type) const {
+    // NaN positions slip past every comparison in the area tests, so they aren't bounded at all
+    if (!s_indexEnabled || std::isnan(pos.x) || std::isnan(pos.y) || std::isnan(pos.z)) {
+        return scanSorted(pos, type);
+    }
+
+    for (const auto &grid : m_grids) {
+        if (grid.type != type) {
+            continue;
+        }
+
+        u32 cell = grid.width * grid.height;
+        if (pos.x >= grid.min.x && pos.x <= grid.max.x && pos.z >= grid.min.y &&
+                pos.z <= grid.max.y) {
+            u32 x = GridCell(pos.x, grid.min.x, grid.invCellSize.x, grid.width);
+            u32 z = GridCell(pos.z, grid.min.y, grid.invCellSize.y, grid.height);
+            cell = z * grid.width + x;
+        }
+
+        for (u32 i = grid.cellStarts[cell]; i < grid.cellStarts[cell + 1]; ++i) {
+            MapdataAreaBase *area = m_sortedEntries[grid.sortedIndices[i]];
+            if (area->test(pos)) {
+                return area;
+            }
+        }
+
+        return nullptr;
+    }
+
+    // No area has this type
+    return nullptr;
+}
+
+/// @brief Fills in the grid of an area type.
+/// @details Areas only ever contain positions within their bounding sphere (see
+/// MapdataAreaBase::test), so each area is listed in every cell its padded sphere overlaps. Cells
+/// are filled in sorted order, which keeps the priority order of findSorted's candidates intact.
+void MapdataAreaAccessor::buildGrid(AreaGrid &grid, MapdataAreaBase::Type type) {
+    constexpr u32 MAX_GRID_DIM = 32;
+
+    grid.type = type;
+    grid.min = EGG::Vector2f(std::numeric_limits<f32>::max(), std::numeric_limits<f32>::max());
+    grid.max = EGG::Vector2f(std::numeric_limits<f32>::lowest(),
+            std::numeric_limits<f32>::lowest());
+
+    u32 boundedCount = 0;
+    for (u16 i = 0; i < m_entryCount; ++i) {
+        EGG::Vector2f min;
+        EGG::Vector2f max;
+        if (m_sortedEntries[i]->type() == type && GetAreaBounds(m_sortedEntries[i], min, max)) {
+            grid.min = EGG::Vector2f(std::min(grid.min.x, min.x), std::min(grid.min.y, min.y));
+            grid.max = EGG::Vector2f(std::max(grid.max.x, max.x), std::max(grid.max.y, max.y));
+            ++boundedCount;
+        }
+    }
+
+    // Roughly four cells per area, assuming areas are spread evenly over the course
+    u32 dim = static_cast<u32>(std::ceil(std::sqrt(static_cast<f32>(boundedCount)))) * 2;
+    dim = std::min(dim, MAX_GRID_DIM);
+    grid.width = dim;
+    grid.height = dim;
+
+    if (boundedCount > 0) {
+        grid.invCellSize = EGG::Vector2f(static_cast<f32>(dim) / (grid.max.x - grid.min.x),
+                static_cast<f32>(dim) / (grid.max.y - grid.min.y));
+    } else {
+        grid.invCellSize = EGG::Vector2f(0.0f, 0.0f);
+    }
+
+    // The first pass counts each cell's areas, and the second lists them
+    u32 cellCount = grid.width * grid.height;
+    grid.cellStarts = owning_span<u32>(cellCount + 2);
+    std::fill(grid.cellStarts.begin(), grid.cellStarts.end(), 0);
+
+    u32 listCount = 0;
+    for (bool fill : {false, true}) {
+        for (u16 i = 0; i < m_entryCount; ++i) {
+            const MapdataAreaBase *area = m_sortedEntries[i];
+            if (area->type() != type) {
+                continue;
+            }
+
+            EGG::Vector2f min;
+            EGG::Vector2f max;
+            bool bounded = GetAreaBounds(area, min, max);
+
+            u32 x0 = 0;
+            u32 x1 = grid.width - 1;
+            u32 z0 = 0;
+            u32 z1 = grid.height - 1;
+            if (bounded) {
+                x0 = GridCell(min.x, grid.min.x, grid.invCellSize.x, grid.width);
+                x1 = GridCell(max.x, grid.min.x, grid.invCellSize.x, grid.width);
+                z0 = GridCell(min.y, grid.min.y, grid.invCellSize.y, grid.height);
+                z1 = GridCell(max.y, grid.min.y, grid.invCellSize.y, grid.height);
+            }
+
+            for (u32 z = z0; z < z1 + 1 && z < grid.height; ++z) {
+                for (u32 x = x0; x < x1 + 1 && x < grid.width; ++x) {
+                    u32 cell = z * grid.width + x;
+                    if (fill) {
+                        grid.sortedIndices[grid.cellStarts[cell + 1]++] = i;
+                    } else {
+                        ++grid.cellStarts[cell + 1];
+                    }
+                }
+            }
+
+            if (!bounded) {
+                if (fill) {
+                    grid.sortedIndices[grid.cellStarts[cellCount + 1]++] = i;
+                } else {
+                    ++grid.cellStarts[cellCount + 1];
+                }
+            }
+        }
+
+        if (!fill) {
+            // Turn the counts into the offset each cell's list starts at
+            for (u32 cell = 0; cell < cellCount + 1; ++cell) {
+                u32 count = grid.cellStarts[cell + 1];
+                grid.cellStarts[cell + 1] = listCount;
+                listCount += count;
+            }
+
+            grid.sortedIndices = owning_span<u16>(listCount);
+        }
+    }
+}
+
+/// @brief Tests every area of a type in sorted order, as the game does.
+MapdataAreaBase *MapdataAreaAccessor::scanSorted(const EGG::Vector3f &pos,
+        MapdataAreaBase::Type type) const {
+    for (u16 i = 0; i < m_entryCount; ++i) {
+        MapdataAreaBase *area = m_sortedEntries[i];
+        if (area->type() == type && area->test(pos)) {
+            return area;
+        }
+    }
+
+    return nullptr;
+}
+
+bool MapdataAreaAccessor::s_indexEnabled = true;
+
 } // namespace Kinoko::System
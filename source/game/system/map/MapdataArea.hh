@@ -64,6 +64,14 @@ public:
         return m_index;
     }
 
+    [[nodiscard]] const EGG::Vector3f &position() const {
+        return m_position;
+    }
+
+    [[nodiscard]] f32 sqBoundingSphereRadius() const {
+        return m_sqBoundingSphereRadius;
+    }
+
 protected:
     const SData *m_rawData;
     Type m_type;
@@ -107,14 +115,46 @@ public:
 
     void init(const MapdataAreaBase::SData *start, u16 count);
     void sort();
+    void buildIndex();
+
+    [[nodiscard]] MapdataAreaBase *findSorted(const EGG::Vector3f &pos,
+            MapdataAreaBase::Type type) const;
 
     [[nodiscard]] MapdataAreaBase *getSorted(u16 i) const {
         ASSERT(!m_sortedEntries.empty());
         return i < m_entryCount ? m_sortedEntries[i] : nullptr;
     }
 
+    /// @brief Sets whether findSorted uses the area index. Only useful to measure the index.
+    static void SetIndexEnabled(bool enabled) {
+        s_indexEnabled = enabled;
+    }
+
 private:
+    /// @brief A uniform grid over the XZ bounds of every area of one type.
+    /// @details Each cell lists the sorted indices of the areas that may contain positions within
+    /// it, in ascending order. Areas without finite bounds are listed in every cell, as well as in
+    /// the cell past the end, which is used for positions outside of the grid.
+    struct AreaGrid {
+        MapdataAreaBase::Type type;
+        EGG::Vector2f min;
+        EGG::Vector2f max;
+        EGG::Vector2f invCellSize;
+        u32 width;
+        u32 height;
+        owning_span<u32> cellStarts; ///< Offsets into sortedIndices, plus one past the end.
+        owning_span<u16> sortedIndices;
+    };
+
+    void buildGrid(AreaGrid &grid, MapdataAreaBase::Type type);
+
+    [[nodiscard]] MapdataAreaBase *scanSorted(const EGG::Vector3f &pos,
+            MapdataAreaBase::Type type) const;
+
     owning_span<MapdataAreaBase *> m_sortedEntries;
+    owning_span<AreaGrid> m_grids; ///< One per area type present in the course.
+
+    static bool s_indexEnabled;
 };
 
 } // namespace Kinoko::System
@@ -3,6 +3,7 @@
 #include "game/system/CourseMap.hh"
 #include "game/system/map/MapdataCheckPath.hh"
 
+#include <cmath>
 #include <ranges>
 
 namespace Kinoko::System {
@@ -170,6 +171,81 @@ f32 MapdataCheckPoint::getEntryOffsetExact(const EGG::Vector2f &prevPos,
     return y != 0.0f ? x / y : 0.0f;
 }
 
+/// @brief Checks whether any position within a box may be between the sides of one of this
+/// checkpoint's quads, in which case checkSectorAndDistanceRatio may not return OutsideSector.
+/// @details This is exact, so callers must pad the box to cover rounding in checkSector. Quads
+/// with sides that aren't finite may compare unordered, so they always overlap the box.
+bool MapdataCheckPoint::mayBeBetweenSides(const EGG::Vector2f &min,
+        const EGG::Vector2f &max) const {
+    typedef std::array<f64, 2> Point;
+
+    for (size_t i = 0; i < m_nextCount; ++i) {
+        const LinkedCheckpoint &next = m_nextPoints[i];
+        const EGG::Vector2f &left = next.checkpoint->m_left;
+
+        // The half-planes checkSector tests, as a * x + b * z + c >= 0
+        f64 a0 = -static_cast<f64>(next.p0diff.y);
+        f64 b0 = static_cast<f64>(next.p0diff.x);
+        f64 a1 = static_cast<f64>(next.p1diff.y);
+        f64 b1 = -static_cast<f64>(next.p1diff.x);
+        std::array<std::array<f64, 3>, 2> planes = {{
+                {a0, b0, -a0 * static_cast<f64>(left.x) - b0 * static_cast<f64>(left.y)},
+                {a1, b1, -a1 * static_cast<f64>(m_right.x) - b1 * static_cast<f64>(m_right.y)},
+        }};
+
+        bool finite = true;
+        for (const auto &plane : planes) {
+            for (f64 coefficient : plane) {
+                finite = finite && std::isfinite(coefficient);
+            }
+        }
+
+        if (!finite) {
+            return true;
+        }
+
+        // Clip the box to each half-plane in turn, which adds at most one corner each time
+        std::array<Point, 8> polygon = {{
+                {min.x, min.y},
+                {max.x, min.y},
+                {max.x, max.y},
+                {min.x, max.y},
+        }};
+        size_t count = 4;
+
+        for (const auto &plane : planes) {
+            std::array<Point, 8> clipped;
+            size_t clippedCount = 0;
+
+            for (size_t j = 0; j < count; ++j) {
+                const Point &curr = polygon[j];
+                const Point &succ = polygon[(j + 1) % count];
+                f64 currDist = plane[0] * curr[0] + plane[1] * curr[1] + plane[2];
+                f64 succDist = plane[0] * succ[0] + plane[1] * succ[1] + plane[2];
+
+                if (currDist >= 0.0) {
+                    clipped[clippedCount++] = curr;
+                }
+
+                if ((currDist >= 0.0) != (succDist >= 0.0)) {
+                    f64 t = currDist / (currDist - succDist);
+                    clipped[clippedCount++] = {curr[0] + t * (succ[0] - curr[0]),
+                            curr[1] + t * (succ[1] - curr[1])};
+                }
+            }
+
+            polygon = clipped;
+            count = clippedCount;
+        }
+
+        if (count > 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 /// @addr{0x80510C74}
 MapdataCheckPoint::SectorOccupancy MapdataCheckPoint::checkSectorAndDistanceRatio(
         const LinkedCheckpoint &next, const EGG::Vector2f &p0, const EGG::Vector2f &p1,
@@ -240,4 +316,90 @@ void MapdataCheckPointAccessor::init() {
     m_finishLineCheckpointId = finishLineCheckpointId;
 }
 
+/// @brief Finds which checkpoints positions within each cell of a grid may be between the sides
+/// of, so that CourseMap can skip testing the others.
+void MapdataCheckPointAccessor::buildSectorIndex() {
+    constexpr u32 MAX_GRID_DIM = 32;
+
+    m_sectorGridDim = 0;
+    m_sectorMaskWords = (m_entryCount + 31) / 32;
+
+    EGG::Vector2f min(std::numeric_limits<f32>::max(), std::numeric_limits<f32>::max());
+    EGG::Vector2f max(std::numeric_limits<f32>::lowest(), std::numeric_limits<f32>::lowest());
+    for (u16 i = 0; i < m_entryCount; ++i) {
+        for (const auto &point : {m_entries[i]->left(), m_entries[i]->right()}) {
+            if (std::isfinite(point.x) && std::isfinite(point.y)) {
+                min = EGG::Vector2f(std::min(min.x, point.x), std::min(min.y, point.y));
+                max = EGG::Vector2f(std::max(max.x, point.x), std::max(max.y, point.y));
+            }
+        }
+    }
+
+    if (min.x > max.x) {
+        return;
+    }
+
+    // Karts mostly leave the checkpoints' bounds by a short way, if at all
+    f32 pad = 0.25f * std::max(max.x - min.x, max.y - min.y) + 1.0f;
+    m_sectorGridMin = EGG::Vector2f(min.x - pad, min.y - pad);
+    m_sectorGridMax = EGG::Vector2f(max.x + pad, max.y + pad);
+
+    u32 dim = static_cast<u32>(std::ceil(std::sqrt(static_cast<f32>(m_entryCount)))) * 2;
+    m_sectorGridDim = std::min(dim, MAX_GRID_DIM);
+
+    EGG::Vector2f extent = m_sectorGridMax - m_sectorGridMin;
+    f32 gridDim = static_cast<f32>(m_sectorGridDim);
+    m_sectorGridInvCellSize = EGG::Vector2f(gridDim / extent.x, gridDim / extent.y);
+
+    // Covers rounding in checkSector and in finding the cell, which grows with the coordinates
+    f32 maxCoord = std::max({std::abs(m_sectorGridMin.x), std::abs(m_sectorGridMin.y),
+            std::abs(m_sectorGridMax.x), std::abs(m_sectorGridMax.y)});
+    f32 margin = 16.0f + 1e-4f * maxCoord;
+
+    m_sectorMasks = owning_span<u32>(m_sectorGridDim * m_sectorGridDim * m_sectorMaskWords);
+    std::fill(m_sectorMasks.begin(), m_sectorMasks.end(), 0);
+
+    for (u32 z = 0; z < m_sectorGridDim; ++z) {
+        for (u32 x = 0; x < m_sectorGridDim; ++x) {
+            EGG::Vector2f cellMin(m_sectorGridMin.x + extent.x * static_cast<f32>(x) / gridDim,
+                    m_sectorGridMin.y + extent.y * static_cast<f32>(z) / gridDim);
+            EGG::Vector2f cellMax(m_sectorGridMin.x + extent.x * static_cast<f32>(x + 1) / gridDim,
+                    m_sectorGridMin.y + extent.y * static_cast<f32>(z + 1) / gridDim);
+            cellMin = cellMin - EGG::Vector2f(margin, margin);
+            cellMax += EGG::Vector2f(margin, margin);
+
+            u32 *mask = &m_sectorMasks[(z * m_sectorGridDim + x) * m_sectorMaskWords];
+            for (u16 i = 0; i < m_entryCount; ++i) {
+                if (m_entries[i]->mayBeBetweenSides(cellMin, cellMax)) {
+                    mask[i / 32] |= 1u << (i % 32);
+                }
+            }
+        }
+    }
+}
+
+/// @brief Finds the checkpoints that a position may be between the sides of.
+/// @return A bitmask indexed by checkpoint ID, or nullptr if every checkpoint must be tested.
+const u32 *MapdataCheckPointAccessor::sectorCandidates(const EGG::Vector3f &pos) const {
+    if (!s_sectorIndexEnabled || m_sectorGridDim == 0) {
+        return nullptr;
+    }
+
+    // This also rejects NaNs
+    if (!(pos.x >= m_sectorGridMin.x && pos.x <= m_sectorGridMax.x &&
+                pos.z >= m_sectorGridMin.y && pos.z <= m_sectorGridMax.y)) {
+        return nullptr;
+    }
+
+    f32 maxCell = static_cast<f32>(m_sectorGridDim - 1);
+    u32 x = static_cast<u32>(std::min((pos.x - m_sectorGridMin.x) * m_sectorGridInvCellSize.x,
+            maxCell));
+    u32 z = static_cast<u32>(std::min((pos.z - m_sectorGridMin.y) * m_sectorGridInvCellSize.y,
+            maxCell));
+
+    return &m_sectorMasks[(z * m_sectorGridDim + x) * m_sectorMaskWords];
+}
+
+bool MapdataCheckPointAccessor::s_sectorIndexEnabled = true;
+
 } // namespace Kinoko::System
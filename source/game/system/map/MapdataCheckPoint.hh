@@ -45,6 +45,7 @@ public:
             const EGG::Vector2f &pos) const;
     [[nodiscard]] f32 getEntryOffsetExact(const EGG::Vector2f &prevPos,
             const EGG::Vector2f &pos) const;
+    [[nodiscard]] bool mayBeBetweenSides(const EGG::Vector2f &min, const EGG::Vector2f &max) const;
 
     [[nodiscard]] bool isNormalCheckpoint() const {
         return static_cast<CheckArea>(m_checkArea) == CheckArea::NormalCheckpoint;
@@ -85,6 +86,14 @@ public:
         return m_prevCount;
     }
 
+    [[nodiscard]] const EGG::Vector2f &left() const {
+        return m_left;
+    }
+
+    [[nodiscard]] const EGG::Vector2f &right() const {
+        return m_right;
+    }
+
     [[nodiscard]] const EGG::Vector2f &dir() const {
         return m_dir;
     }
@@ -149,15 +158,35 @@ public:
     MapdataCheckPointAccessor(const MapSectionHeader *header);
     ~MapdataCheckPointAccessor() override;
 
+    void buildSectorIndex();
+    [[nodiscard]] const u32 *sectorCandidates(const EGG::Vector3f &pos) const;
+
     [[nodiscard]] s8 lastKcpType() const {
         return m_lastKcpType;
     }
 
+    /// @brief Sets whether sectorCandidates uses the index. Only useful to measure the index.
+    static void SetSectorIndexEnabled(bool enabled) {
+        s_sectorIndexEnabled = enabled;
+    }
+
 private:
     void init();
 
     s8 m_lastKcpType;
     u16 m_finishLineCheckpointId;
+
+    /// @brief A uniform grid over the XZ bounds of the checkpoints, padded on every side.
+    /// @details Each cell holds a bitmask of the checkpoints that positions within it may be
+    /// between the sides of. Every other checkpoint's sector test can only return OutsideSector.
+    EGG::Vector2f m_sectorGridMin;
+    EGG::Vector2f m_sectorGridMax;
+    EGG::Vector2f m_sectorGridInvCellSize;
+    u32 m_sectorGridDim;
+    u32 m_sectorMaskWords; ///< The number of 32-bit words in each cell's bitmask.
+    owning_span<u32> m_sectorMasks;
+
+    static bool s_sectorIndexEnabled;
 };
 
 } // namespace Kinoko::System
@@ -9,7 +9,7 @@ namespace Kinoko::System {
 class MapdataStageInfo {
 public:
     struct SData {
-        u8 _0[0x1 - 0x0];
+        u8 lapCount;
         u8 polePosition;
         u8 translationMode;
         u8 _3[0xc - 0x3];
@@ -20,6 +20,10 @@ public:
 
     void read(EGG::Stream &stream);
 
+    [[nodiscard]] u8 lapCount() const {
+        return m_rawData->lapCount;
+    }
+
     [[nodiscard]] u8 polePosition() const {
         return m_rawData->polePosition;
     }
@@ -0,0 +1,83 @@
+#include "Arena.hh"
+
+#include "host/DirtyPageTracker.hh"
+
+#include <egg/core/ExpHeap.hh>
+#include <egg/core/SceneManager.hh>
+
+namespace Kinoko::Host {
+
+/// @brief Allocates the arena's memory space and creates its root heap.
+/// @details The arena starts with the current statics, so that options such as the heap flags and
+/// the race configuration callback carry over, but without any heaps, archives or singletons. The
+/// static caches of the engine are reset to the values they have when the process starts.
+/// @see Context::Statics.
+Arena::Arena() {
+    ASSERT(!DirtyPageTracker::IsEnabled());
+
+    size_t size = Context::MemorySpaceSize();
+    m_memorySpace = DirtyPageTracker::AllocPages(size);
+    ASSERT(m_memorySpace);
+
+    // Options carry over from the current statics, and everything else starts out as it does on a
+    // new thread
+    Context::Statics current;
+    Context::SaveStatics(current);
+
+    m_statics.m_heapOptionFlg = current.m_heapOptionFlg;
+    m_statics.m_onInitCallback = current.m_onInitCallback;
+    m_statics.m_onInitCallbackArg = current.m_onInitCallbackArg;
+
+    Arena *previous = s_active;
+    activate();
+
+    EGG::Heap *rootHeap = EGG::ExpHeap::create(m_memorySpace, size, m_statics.m_heapOptionFlg);
+    ASSERT(rootHeap);
+    rootHeap->setName("EGGRoot");
+    rootHeap->becomeCurrentHeap();
+    EGG::SceneManager::SetRootHeap(rootHeap);
+
+    if (previous) {
+        previous->activate();
+    } else {
+        Deactivate();
+    }
+}
+
+/// @brief Frees the arena's memory space.
+/// @details Nothing in the arena is destroyed, so any scene should be destroyed beforehand to
+/// release the archives it retains. @see System::ResourceManager::SetRetainBudget.
+Arena::~Arena() {
+    if (isActive()) {
+        Deactivate();
+    }
+
+    DirtyPageTracker::FreePages(m_memorySpace, Context::MemorySpaceSize());
+}
+
+/// @brief Switches to the arena's statics on this thread, saving those of the active memory space.
+void Arena::activate() {
+    if (s_active == this) {
+        return;
+    }
+
+    Context::SaveStatics(s_active ? s_active->m_statics : s_hostStatics);
+    Context::LoadStatics(m_statics);
+    s_active = this;
+}
+
+/// @brief Switches back to the statics the thread had before activating an arena.
+void Arena::Deactivate() {
+    if (!s_active) {
+        return;
+    }
+
+    Context::SaveStatics(s_active->m_statics);
+    Context::LoadStatics(s_hostStatics);
+    s_active = nullptr;
+}
+
+THREAD_LOCAL Arena *Arena::s_active = nullptr;
+THREAD_LOCAL Context::Statics Arena::s_hostStatics = {};
+
+} // namespace Kinoko::Host
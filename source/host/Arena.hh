@@ -0,0 +1,50 @@
+#pragma once
+
+#include "host/Context.hh"
+
+namespace Kinoko::Host {
+
+/// @brief A memory space with its own root heap, in which an independent race can be created.
+/// @details Context::SetActiveContext runs several races in one memory space by copying the entire
+/// heap in and out of it. Instead, each arena owns a memory space, so that switching between races
+/// only swaps the statics that Context saves, such as the singletons and the current heaps.
+///
+/// The memory space the process started with isn't an arena, and is active whenever no arena is.
+/// Every arena is the size of Context::MemorySpaceSize, so contexts can be saved and restored
+/// within the active arena as usual. Incremental contexts only track one memory space, so arenas
+/// can't be created while they are enabled.
+///
+/// The engine's statics are thread-local, so each thread has its own active arena, and threads can
+/// simulate races in separate arenas at the same time. An arena must only be used by one thread at
+/// a time. A new thread starts with the statics the process started with, so it should set the
+/// heap options and register the race's init callback before creating its first arena.
+class Arena {
+public:
+    Arena();
+    ~Arena();
+
+    Arena(const Arena &) = delete;
+    Arena(Arena &&) = delete;
+
+    void activate();
+    static void Deactivate();
+
+    [[nodiscard]] bool isActive() const {
+        return s_active == this;
+    }
+
+    /// @brief The thread's active arena, or nullptr if no arena is active on it.
+    [[nodiscard]] static Arena *Active() {
+        return s_active;
+    }
+
+private:
+    void *m_memorySpace;
+    Context::Statics m_statics; ///< The arena's statics, while another memory space is active.
+
+    static THREAD_LOCAL Arena *s_active;
+    /// The thread's own statics, while an arena is active.
+    static THREAD_LOCAL Context::Statics s_hostStatics;
+};
+
+} // namespace Kinoko::Host
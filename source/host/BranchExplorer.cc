@@ -0,0 +1,196 @@
+#include "BranchExplorer.hh"
+
+#include "host/Context.hh"
+
+#include <algorithm>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define BRANCH_FORK_SUPPORTED
+
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace Kinoko::Host {
+
+#ifdef BRANCH_FORK_SUPPORTED
+/// @brief Writes an entire buffer to a file descriptor, retrying on partial writes.
+static bool WriteAll(int fd, const void *data, size_t size) {
+    const u8 *cursor = static_cast<const u8 *>(data);
+    while (size > 0) {
+        ssize_t written = write(fd, cursor, size);
+        if (written <= 0) {
+            return false;
+        }
+
+        cursor += written;
+        size -= static_cast<size_t>(written);
+    }
+
+    return true;
+}
+
+/// @brief Reads an entire buffer from a file descriptor, retrying on partial reads.
+static bool ReadAll(int fd, void *data, size_t size) {
+    u8 *cursor = static_cast<u8 *>(data);
+    while (size > 0) {
+        ssize_t bytesRead = read(fd, cursor, size);
+        if (bytesRead <= 0) {
+            return false;
+        }
+
+        cursor += bytesRead;
+        size -= static_cast<size_t>(bytesRead);
+    }
+
+    return true;
+}
+#endif // BRANCH_FORK_SUPPORTED
+
+/// @param onResult Called in the parent for every finished branch, in order of completion.
+/// @param maxConcurrent The maximum number of branches alive at once. Spawning beyond this waits
+/// for a running branch to finish first.
+BranchExplorer::BranchExplorer(const ResultFunc &onResult, u32 maxConcurrent)
+    : m_onResult(onResult), m_maxConcurrent(std::max<u32>(maxConcurrent, 1)) {}
+
+BranchExplorer::~BranchExplorer() {
+    wait();
+}
+
+/// @brief Starts a new branch from the current race state.
+/// @param id An identifier passed back to the result callback.
+/// @param func The work to perform in the branch. Any state it modifies is discarded afterwards.
+/// @param output If set, the branch's standard output is redirected to this file.
+void BranchExplorer::spawn(u32 id, const BranchFunc &func, FILE *output) {
+#ifdef BRANCH_FORK_SUPPORTED
+    while (m_branches.size() >= m_maxConcurrent) {
+        collectOne();
+    }
+
+    int fds[2];
+    if (pipe(fds) != 0) {
+        PANIC("Failed to create pipe for branch %u", id);
+    }
+
+    // Flush before forking, so that buffered output isn't duplicated by the child
+    fflush(stdout);
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        PANIC("Failed to fork branch %u", id);
+    }
+
+    if (pid == 0) {
+        close(fds[0]);
+        for (const auto &branch : m_branches) {
+            close(branch.fd);
+        }
+
+        if (output) {
+            if (dup2(fileno(output), STDOUT_FILENO) < 0) {
+                _exit(1);
+            }
+
+            // Line buffered, so that a branch which panics still leaves its last message
+            setvbuf(stdout, nullptr, _IOLBF, BUFSIZ);
+        }
+
+        Payload payload;
+        func(id, payload);
+
+        BranchHeader header;
+        header.signature = BRANCH_SIGNATURE;
+        header.id = id;
+        header.size = static_cast<u32>(payload.size());
+
+        bool success = WriteAll(fds[1], &header, sizeof(header)) &&
+                WriteAll(fds[1], payload.data(), payload.size());
+
+        // Skip static destructors, which belong to the parent
+        fflush(stdout);
+        _exit(success ? 0 : 1);
+    }
+
+    close(fds[1]);
+    m_branches.push_back({id, static_cast<int>(pid), fds[0]});
+#else
+    (void)output;
+
+    Context parent;
+    Payload payload;
+    func(id, payload);
+    Context::SetActiveContext(parent);
+    m_onResult(id, true, payload);
+#endif // BRANCH_FORK_SUPPORTED
+}
+
+/// @brief Blocks until all running branches have finished and reported their results.
+void BranchExplorer::wait() {
+    while (!m_branches.empty()) {
+        collectOne();
+    }
+}
+
+/// @brief Whether branches run in forked processes, as opposed to sequentially in-process.
+bool BranchExplorer::IsSupported() {
+#ifdef BRANCH_FORK_SUPPORTED
+    return true;
+#else
+    return false;
+#endif // BRANCH_FORK_SUPPORTED
+}
+
+/// @brief Waits for any running branch to report, then reaps it.
+/// @details Results are read while the child is still alive, as payloads larger than the pipe
+/// buffer would otherwise block the child forever.
+void BranchExplorer::collectOne() {
+#ifdef BRANCH_FORK_SUPPORTED
+    ASSERT(!m_branches.empty());
+
+    std::vector<pollfd> fds(m_branches.size());
+    for (size_t i = 0; i < m_branches.size(); ++i) {
+        fds[i].fd = m_branches[i].fd;
+        fds[i].events = POLLIN;
+        fds[i].revents = 0;
+    }
+
+    if (poll(fds.data(), fds.size(), -1) < 0) {
+        PANIC("Failed to poll branches");
+    }
+
+    size_t idx = 0;
+    while (idx < fds.size() && fds[idx].revents == 0) {
+        ++idx;
+    }
+    ASSERT(idx < fds.size());
+
+    Branch branch = m_branches[idx];
+    m_branches.erase(m_branches.begin() + idx);
+
+    BranchHeader header;
+    Payload payload;
+    bool success = ReadAll(branch.fd, &header, sizeof(header)) &&
+            header.signature == BRANCH_SIGNATURE && header.id == branch.id;
+
+    if (success) {
+        payload.resize(header.size);
+        success = ReadAll(branch.fd, payload.data(), payload.size());
+    }
+
+    close(branch.fd);
+
+    int status = 0;
+    waitpid(static_cast<pid_t>(branch.pid), &status, 0);
+    success = success && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+
+    if (!success) {
+        WARN("Branch %u failed to report a result", branch.id);
+        payload.clear();
+    }
+
+    m_onResult(branch.id, success, payload);
+#endif // BRANCH_FORK_SUPPORTED
+}
+
+} // namespace Kinoko::Host
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <Common.hh>
+
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+namespace Kinoko::Host {
+
+/// @brief Explores continuations of the current race state in forked child processes.
+/// @details Forking shares the entire memory space with the parent copy-on-write, so a branch only
+/// pays for the pages it actually modifies, rather than a full Context copy. Each branch runs the
+/// provided function in its own process and reports a byte payload back to the parent over a pipe.
+/// The pipe protocol is a single BranchHeader followed by `size` bytes of payload.
+///
+/// On hosts without fork, branches run sequentially in-process instead, and the parent state is
+/// restored from a Context after each of them.
+class BranchExplorer {
+public:
+    typedef std::vector<u8> Payload;
+
+    /// @brief Runs inside the branch. Appends the branch's result to the payload.
+    typedef std::function<void(u32 id, Payload &payload)> BranchFunc;
+
+    /// @brief Runs in the parent once a branch finishes. Failed branches have an empty payload.
+    typedef std::function<void(u32 id, bool success, const Payload &payload)> ResultFunc;
+
+    BranchExplorer(const ResultFunc &onResult, u32 maxConcurrent);
+    ~BranchExplorer();
+
+    BranchExplorer(const BranchExplorer &) = delete;
+    BranchExplorer(BranchExplorer &&) = delete;
+
+    void spawn(u32 id, const BranchFunc &func, FILE *output = nullptr);
+    void wait();
+
+    [[nodiscard]] size_t activeCount() const {
+        return m_branches.size();
+    }
+
+    [[nodiscard]] static bool IsSupported();
+
+private:
+    struct BranchHeader {
+        u32 signature;
+        u32 id;
+        u32 size;
+    };
+
+    struct Branch {
+        u32 id;
+        int pid;
+        int fd; ///< Read end of the branch's result pipe.
+    };
+
+    void collectOne();
+
+    ResultFunc m_onResult;
+    u32 m_maxConcurrent;
+    std::vector<Branch> m_branches;
+
+    static constexpr u32 BRANCH_SIGNATURE = 0x42524348; // BRCH
+};
+
+} // namespace Kinoko::Host
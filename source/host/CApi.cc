@@ -0,0 +1,344 @@
+// Implements the C interface declared in kinoko.h. See the README for how to build and link it.
+
+#define KINOKO_BUILD
+#include <kinoko.h>
+
+#include "host/Context.hh"
+#include "host/DirtyPageTracker.hh"
+#include "host/KartState.hh"
+#include "host/SceneCreatorDynamic.hh"
+#include "host/SceneId.hh"
+
+#include <abstract/ArchiveCache.hh>
+
+#include <egg/core/ExpHeap.hh>
+#include <egg/core/SceneManager.hh>
+
+#include <game/scene/GameScene.hh>
+
+#include <game/system/KPadDirector.hh>
+#include <game/system/RaceConfig.hh>
+#include <game/system/ResourceManager.hh>
+
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+using namespace Kinoko;
+
+struct KinokoContext {
+    Host::Context context;
+    u32 raceId;
+    u32 frame;
+};
+
+namespace {
+
+/// @brief Flushes denormals to zero while the engine runs, as main() does for the executables.
+/// @details The host's floating-point environment is restored afterwards, so that embedding the
+/// engine doesn't change the results of the host's own code.
+class FloatEnvScope {
+public:
+#if defined(__arm64__) || defined(__aarch64__)
+    FloatEnvScope() {
+        asm volatile("mrs %0, fpcr" : "=r"(m_fpcr));
+        asm volatile("msr fpcr, %0" ::"r"(m_fpcr | (1 << 24)));
+    }
+
+    ~FloatEnvScope() {
+        asm volatile("msr fpcr, %0" ::"r"(m_fpcr));
+    }
+
+private:
+    uint64_t m_fpcr;
+#elif defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    FloatEnvScope() : m_csr(_mm_getcsr()) {
+        _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
+    }
+
+    ~FloatEnvScope() {
+        _mm_setcsr(m_csr);
+    }
+
+private:
+    u32 m_csr;
+#endif
+};
+
+} // namespace
+
+static EGG::SceneManager *s_sceneMgr = nullptr;
+
+/// @brief The race to create, read by OnInit when the race scene is created.
+static System::RaceConfig::Player::Type s_playerType = System::RaceConfig::Player::Type::None;
+static KinokoRaceParams s_raceParams = {};
+static std::vector<u8> s_ghost; ///< The ghost file, if the player is a ghost.
+
+static u32 s_raceId = 0; ///< Incremented per race, to tell which race a context was saved in.
+static u32 s_frame = 0;  ///< Frames stepped in the current race.
+
+/// @brief Configures the race the same way KReplaySystem does for ghosts, or from s_raceParams.
+static void OnInit(System::RaceConfig *config, void * /* arg */) {
+    auto &player = config->raceScenario().players[0];
+    player.type = s_playerType;
+
+    if (s_playerType == System::RaceConfig::Player::Type::Ghost) {
+        config->setGhost(s_ghost.data());
+        return;
+    }
+
+    config->raceScenario().course = static_cast<Course>(s_raceParams.course);
+    player.character = static_cast<Character>(s_raceParams.character);
+    player.vehicle = static_cast<Vehicle>(s_raceParams.vehicle);
+    player.driftIsAuto = s_raceParams.driftIsAuto != 0;
+}
+
+/// @brief Creates the race scene, or recreates it like KTestSystem moves to its next test case.
+static void CreateRace() {
+    FloatEnvScope floatEnv;
+
+    if (!s_sceneMgr->currentScene()) {
+        s_sceneMgr->changeScene(0);
+    } else {
+        s_sceneMgr->destroyScene(s_sceneMgr->currentScene());
+        s_sceneMgr->createScene(static_cast<int>(Host::SceneId::Race),
+                s_sceneMgr->currentScene());
+    }
+
+    if (s_playerType == System::RaceConfig::Player::Type::Local) {
+        System::KPadDirector::Instance()->hostController()->reset(s_raceParams.driftIsAuto != 0);
+    }
+
+    ++s_raceId;
+    s_frame = 0;
+}
+
+[[nodiscard]] static bool IsRaceCreated() {
+    return s_raceId != 0;
+}
+
+uint32_t kinoko_api_version(void) {
+    return KINOKO_API_VERSION;
+}
+
+/// @brief Initializes memory and the scene manager, the same way main() does.
+/// @param config The engine options, or NULL for the defaults.
+int32_t kinoko_init(const KinokoConfig *config) {
+    if (s_sceneMgr) {
+        return KINOKO_ERROR_ALREADY_INITIALIZED;
+    }
+
+    KinokoConfig defaults = {};
+    if (!config) {
+        config = &defaults;
+    }
+
+    // Rounded up as with --arena-size
+    constexpr size_t ARENA_GRANULE = 0x10000;
+    size_t arenaSize = config->arenaSize != 0 ? RoundUp(config->arenaSize, ARENA_GRANULE) :
+                                                MEMORY_SPACE_SIZE;
+    u16 heapOpt = DEFAULT_OPT;
+    if (config->sizeClasses) {
+        heapOpt = Abstract::Memory::MEMiHeapHead::OptFlag(heapOpt).setBit(
+                Abstract::Memory::MEMiHeapHead::eOptFlag::SizeClasses);
+    }
+
+    Abstract::ArchiveCache::SetDirectory(config->archiveCache);
+    System::ResourceManager::SetRetainBudget(config->retainBudget);
+    Scene::GameScene::SetHeadless(config->headless != 0);
+
+    void *memorySpace = Host::DirtyPageTracker::AllocPages(arenaSize);
+    EGG::Heap *rootHeap = EGG::ExpHeap::create(memorySpace, arenaSize, heapOpt);
+    ASSERT(rootHeap);
+    rootHeap->setName("EGGRoot");
+    rootHeap->becomeCurrentHeap();
+
+    EGG::SceneManager::SetRootHeap(rootHeap);
+    EGG::SceneManager::SetHeapOptionFlg(heapOpt);
+    Host::Context::SetMemorySpaceSize(arenaSize);
+
+    if (config->incremental && !Host::Context::EnableIncremental()) {
+        WARN("Incremental contexts are not supported on this host. Copying the whole arena");
+    }
+
+    auto *sceneCreator = EGG::egg_new<Host::SceneCreatorDynamic>();
+    s_sceneMgr = EGG::egg_new<EGG::SceneManager>(sceneCreator);
+    System::RaceConfig::RegisterInitCallback(OnInit, nullptr);
+
+    return KINOKO_OK;
+}
+
+/// @brief Creates a race driven by kinoko_set_inputs, replacing the current race if any.
+int32_t kinoko_race_create(const KinokoRaceParams *params) {
+    if (!s_sceneMgr) {
+        return KINOKO_ERROR_NOT_INITIALIZED;
+    }
+
+    if (!params || params->course < 0 ||
+            static_cast<size_t>(params->course) >= std::size(COURSE_NAMES) ||
+            params->character < 0 ||
+            params->character >= static_cast<s32>(Character::Max) || params->vehicle < 0 ||
+            params->vehicle >= static_cast<s32>(Vehicle::Max)) {
+        return KINOKO_ERROR_INVALID_ARGUMENT;
+    }
+
+    s_playerType = System::RaceConfig::Player::Type::Local;
+    s_raceParams = *params;
+    CreateRace();
+
+    return KINOKO_OK;
+}
+
+/// @brief Creates a race that replays a ghost, replacing the current race if any.
+/// @details The ghost is validated beforehand, so that a malformed file is reported rather than
+/// stopping the process. @see System::RawGhostFile::FindError.
+/// @param rkg The ghost file, which is copied.
+/// @param size The size of the ghost file.
+int32_t kinoko_race_create_ghost(const void *rkg, size_t size) {
+    if (!s_sceneMgr) {
+        return KINOKO_ERROR_NOT_INITIALIZED;
+    }
+
+    if (!rkg) {
+        return KINOKO_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (size < System::RKG_HEADER_SIZE || size > sizeof(System::RawGhostFile)) {
+        return KINOKO_ERROR_INVALID_GHOST;
+    }
+
+    // Uncompressed ghosts are copied whole, so pad the file before validating it
+    const u8 *bytes = static_cast<const u8 *>(rkg);
+    std::vector<u8> ghost(bytes, bytes + size);
+    ghost.resize(sizeof(System::RawGhostFile));
+
+    if (const char *error = System::RawGhostFile::FindError(ghost.data(), size)) {
+        WARN("Invalid ghost: %s", error);
+        return KINOKO_ERROR_INVALID_GHOST;
+    }
+
+    s_ghost = std::move(ghost);
+
+    s_playerType = System::RaceConfig::Player::Type::Ghost;
+    CreateRace();
+
+    return KINOKO_OK;
+}
+
+/// @brief Sets the inputs read on the next frame. @see System::KPadHostController::setInputs.
+/// @param trick A KinokoTrick.
+int32_t kinoko_set_inputs(uint16_t buttons, float stickX, float stickY, int32_t trick) {
+    if (!IsRaceCreated()) {
+        return s_sceneMgr ? KINOKO_ERROR_NO_RACE : KINOKO_ERROR_NOT_INITIALIZED;
+    }
+
+    if (s_playerType != System::RaceConfig::Player::Type::Local) {
+        return KINOKO_ERROR_NOT_HOST;
+    }
+
+    auto *controller = System::KPadDirector::Instance()->hostController();
+    bool valid = controller->setInputs(buttons, stickX, stickY, static_cast<System::Trick>(trick));
+    return valid ? KINOKO_OK : KINOKO_ERROR_INVALID_INPUTS;
+}
+
+/// @brief Sets the inputs read on the next frame, with sticks in the range [0, 14].
+/// @see System::KPadHostController::setInputsRawStick.
+int32_t kinoko_set_inputs_raw(uint16_t buttons, uint8_t stickXRaw, uint8_t stickYRaw,
+        int32_t trick) {
+    if (!IsRaceCreated()) {
+        return s_sceneMgr ? KINOKO_ERROR_NO_RACE : KINOKO_ERROR_NOT_INITIALIZED;
+    }
+
+    if (s_playerType != System::RaceConfig::Player::Type::Local) {
+        return KINOKO_ERROR_NOT_HOST;
+    }
+
+    auto *controller = System::KPadDirector::Instance()->hostController();
+    bool valid = controller->setInputsRawStick(buttons, stickXRaw, stickYRaw,
+            static_cast<System::Trick>(trick));
+    return valid ? KINOKO_OK : KINOKO_ERROR_INVALID_INPUTS;
+}
+
+/// @brief Simulates frames with the current inputs.
+int32_t kinoko_step(uint32_t frameCount) {
+    if (!IsRaceCreated()) {
+        return s_sceneMgr ? KINOKO_ERROR_NO_RACE : KINOKO_ERROR_NOT_INITIALIZED;
+    }
+
+    FloatEnvScope floatEnv;
+    for (u32 i = 0; i < frameCount; ++i) {
+        s_sceneMgr->calc();
+    }
+
+    s_frame += frameCount;
+    return KINOKO_OK;
+}
+
+int32_t kinoko_get_kart_state(KinokoKartState *state) {
+    if (!IsRaceCreated()) {
+        return s_sceneMgr ? KINOKO_ERROR_NO_RACE : KINOKO_ERROR_NOT_INITIALIZED;
+    }
+
+    if (!state) {
+        return KINOKO_ERROR_INVALID_ARGUMENT;
+    }
+
+    Host::CaptureKartState(*state, s_frame);
+    return KINOKO_OK;
+}
+
+/// @brief Saves the current race into a new context.
+/// @return The context, which must be freed with kinoko_context_destroy, or NULL if there is no
+/// race.
+KinokoContext *kinoko_context_create(void) {
+    if (!IsRaceCreated()) {
+        return nullptr;
+    }
+
+    return new KinokoContext{Host::Context(), s_raceId, s_frame};
+}
+
+/// @brief Saves the current race into an existing context.
+int32_t kinoko_context_save(KinokoContext *context) {
+    if (!IsRaceCreated()) {
+        return s_sceneMgr ? KINOKO_ERROR_NO_RACE : KINOKO_ERROR_NOT_INITIALIZED;
+    }
+
+    if (!context) {
+        return KINOKO_ERROR_INVALID_ARGUMENT;
+    }
+
+    context->context.save();
+    context->raceId = s_raceId;
+    context->frame = s_frame;
+    return KINOKO_OK;
+}
+
+/// @brief Restores the race saved in a context.
+/// @details Contexts can only be restored in the race they were saved in. Archives that were
+/// decompressed or loaded from the archive cache are in the heap, which the context copies, but
+/// creating a race may free retained archives that the context refers to.
+int32_t kinoko_context_restore(const KinokoContext *context) {
+    if (!IsRaceCreated()) {
+        return s_sceneMgr ? KINOKO_ERROR_NO_RACE : KINOKO_ERROR_NOT_INITIALIZED;
+    }
+
+    if (!context) {
+        return KINOKO_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (context->raceId != s_raceId) {
+        return KINOKO_ERROR_STALE_CONTEXT;
+    }
+
+    Host::Context::SetActiveContext(context->context);
+    s_frame = context->frame;
+    return KINOKO_OK;
+}
+
+void kinoko_context_destroy(KinokoContext *context) {
+    delete context;
+}
@@ -1,5 +1,7 @@
 #include "Context.hh"
 
+#include "host/DirtyPageTracker.hh"
+
 #include <egg/core/SceneManager.hh>
 
 #include <game/field/CollisionDirector.hh>
@@ -21,66 +23,46 @@
 #include <game/system/KPadDirector.hh>
 #include <game/system/RaceConfig.hh>
 #include <game/system/RaceManager.hh>
+#include <game/system/ResourceManager.hh>
 
 namespace Kinoko::Host {
 
-Context::Context() {
-    m_contextMemory = malloc(MEMORY_SPACE_SIZE);
+Context::Context() : m_retainedArchives{} {
+    m_contextMemory = malloc(s_memorySpaceSize);
     ASSERT(m_contextMemory && EGG::SceneManager::s_rootHeap);
-    memcpy(m_contextMemory, static_cast<void *>(EGG::SceneManager::s_rootHeap), MEMORY_SPACE_SIZE);
-
-    m_statics.m_rootList = Abstract::Memory::MEMiHeapHead::s_rootList;
-    m_statics.m_archiveList = EGG::Archive::s_archiveList;
-    m_statics.m_heapList = EGG::Heap::s_heapList;
-    m_statics.m_currentHeap = EGG::Heap::s_currentHeap;
-    m_statics.m_allocatableHeap = EGG::Heap::s_allocatableHeap;
-    m_statics.m_heapForCreateScene = EGG::SceneManager::s_heapForCreateScene;
-    m_statics.m_boxColMgr = Field::BoxColManager::s_instance;
-    m_statics.m_colDir = Field::CollisionDirector::s_instance;
-    m_statics.m_courseColMgr = Field::CourseColMgr::s_instance;
-    m_statics.m_jugemDir = Field::JugemDirector::s_instance;
-    m_statics.m_objDir = Field::ObjectDirector::s_instance;
-    m_statics.m_objDrivableDir = Field::ObjectDrivableDirector::s_instance;
-    m_statics.m_railMgr = Field::RailManager::s_instance;
-    m_statics.m_itemDir = Item::ItemDirector::s_instance;
-    m_statics.m_kartObjMgr = Kart::KartObjectManager::s_instance;
-    m_statics.m_paramFileMgr = Kart::KartParamFileManager::s_instance;
-    m_statics.m_courseMap = System::CourseMap::s_instance;
-    m_statics.m_padDir = System::KPadDirector::s_instance;
-    m_statics.m_raceConfig = System::RaceConfig::s_instance;
-    m_statics.m_onInitCallback = System::RaceConfig::s_onInitCallback;
-    m_statics.m_onInitCallbackArg = System::RaceConfig::s_onInitCallbackArg;
-    m_statics.m_raceMgr = System::RaceManager::s_instance;
-    m_statics.m_resMgr = System::ResourceManager::s_instance;
-    m_statics.m_kartCamera = Render::KartCamera::s_instance;
-    m_statics.m_thunderScaleUpAnmChr = Kart::KartObjectManager::s_thunderScaleUpAnmChr;
-    m_statics.m_thunderScaleDownAnmChr = Kart::KartObjectManager::s_thunderScaleDownAnmChr;
-    m_statics.m_pressScaleUpAnmChr = Kart::KartObjectManager::s_pressScaleUpAnmChr;
-    m_statics.m_frameCtrlBaseUpdateRate = Abstract::g3d::FrameCtrl::s_baseUpdateRate;
-    m_statics.m_dotProductCache = Field::ObjectCollisionBase::s_dotProductCache;
-    m_statics.m_wanwanMaxPitch = Field::ObjectDirector::s_wanwanMaxPitch;
-    m_statics.m_basabasaInitialXRange = Field::ObjectBasabasa::s_initialXRange;
-    m_statics.m_basabasaInitialYRange = Field::ObjectBasabasa::s_initialYRange;
-    m_statics.m_flamePoleCount = Field::ObjectFlamePoleFoot::s_flamePoleCount;
+    memcpy(m_contextMemory, static_cast<void *>(EGG::SceneManager::s_rootHeap),
+            s_memorySpaceSize);
+    m_syncEpoch = DirtyPageTracker::IsEnabled() ? DirtyPageTracker::Sync() : 0;
+
+    saveStatics();
+    retainArchives();
 }
 
 Context::Context(const Context &c) {
-    m_contextMemory = malloc(MEMORY_SPACE_SIZE);
+    m_contextMemory = malloc(s_memorySpaceSize);
     ASSERT(m_contextMemory && c.m_contextMemory);
-    memcpy(m_contextMemory, c.m_contextMemory, MEMORY_SPACE_SIZE);
+    memcpy(m_contextMemory, c.m_contextMemory, s_memorySpaceSize);
+    m_syncEpoch = c.m_syncEpoch;
     m_statics = c.m_statics;
+    m_retainedArchives = c.m_retainedArchives;
+    System::ResourceManager::AcquireRetained(m_retainedArchives);
 }
 
 /// @brief Move constructs Context by stealing the memory block and ptrs from the provided context.
 Context::Context(Context &&c) {
     m_contextMemory = c.m_contextMemory;
     c.m_contextMemory = nullptr;
+    m_syncEpoch = c.m_syncEpoch;
+    c.m_syncEpoch = 0;
     m_statics = c.m_statics;
     c.m_statics = {};
+    m_retainedArchives = c.m_retainedArchives;
+    c.m_retainedArchives = {};
 }
 
 Context::~Context() {
     free(m_contextMemory);
+    System::ResourceManager::ReleaseRetained(m_retainedArchives);
 }
 
 Context &Context::operator=(const Context &rhs) {
@@ -89,9 +71,22 @@ Context &Context::operator=(const Context &rhs) {
     }
 
     ASSERT(m_contextMemory && rhs.m_contextMemory && m_contextMemory != rhs.m_contextMemory);
-    memcpy(m_contextMemory, rhs.m_contextMemory, MEMORY_SPACE_SIZE);
+
+    // Pages last written before both contexts were synced are identical in both of them
+    u64 epoch = std::min(m_syncEpoch, rhs.m_syncEpoch);
+    if (epoch != 0 && DirtyPageTracker::IsEnabled()) {
+        CopyPagesSince(epoch, m_contextMemory, rhs.m_contextMemory);
+    } else {
+        memcpy(m_contextMemory, rhs.m_contextMemory, s_memorySpaceSize);
+    }
+
+    m_syncEpoch = rhs.m_syncEpoch;
     m_statics = rhs.m_statics;
 
+    System::ResourceManager::AcquireRetained(rhs.m_retainedArchives);
+    System::ResourceManager::ReleaseRetained(m_retainedArchives);
+    m_retainedArchives = rhs.m_retainedArchives;
+
     return *this;
 }
 
@@ -99,9 +94,15 @@ Context &Context::operator=(Context &&rhs) {
     free(m_contextMemory);
     m_contextMemory = rhs.m_contextMemory;
     rhs.m_contextMemory = nullptr;
+    m_syncEpoch = rhs.m_syncEpoch;
+    rhs.m_syncEpoch = 0;
     m_statics = rhs.m_statics;
     rhs.m_statics = {};
 
+    System::ResourceManager::ReleaseRetained(m_retainedArchives);
+    m_retainedArchives = rhs.m_retainedArchives;
+    rhs.m_retainedArchives = {};
+
     return *this;
 }
 
@@ -145,46 +146,198 @@ bool Context::operator==(const Context &rhs) const {
     return ret;
 }
 
+/// @brief Restores the memory space and statics to the state captured by the provided context.
+/// @details If dirty page tracking is enabled and the context has been synced with the memory space
+/// before, only the pages written to since then are copied. The memory space's ResourceManager
+/// then mounts the context's retained archives in place of its own.
 void Context::SetActiveContext(const Context &rhs) {
     ASSERT(EGG::SceneManager::s_rootHeap && rhs.m_contextMemory);
-    memcpy(reinterpret_cast<void *>(EGG::SceneManager::s_rootHeap), rhs.m_contextMemory,
-            MEMORY_SPACE_SIZE);
-
-    Abstract::Memory::MEMiHeapHead::s_rootList = rhs.m_statics.m_rootList;
-    EGG::Archive::s_archiveList = rhs.m_statics.m_archiveList;
-    EGG::Heap::s_heapList = rhs.m_statics.m_heapList;
-    EGG::Heap::s_currentHeap = rhs.m_statics.m_currentHeap;
-    EGG::Heap::s_allocatableHeap = rhs.m_statics.m_allocatableHeap;
-    EGG::SceneManager::s_heapForCreateScene = rhs.m_statics.m_heapForCreateScene;
-    EGG::SceneManager::s_heapOptionFlg = rhs.m_statics.m_heapOptionFlg;
-    EGG::SceneManager::s_rootHeap = rhs.m_statics.m_rootHeap;
-    Field::BoxColManager::s_instance = rhs.m_statics.m_boxColMgr;
-    Field::CollisionDirector::s_instance = rhs.m_statics.m_colDir;
-    Field::CourseColMgr::s_instance = rhs.m_statics.m_courseColMgr;
-    Field::JugemDirector::s_instance = rhs.m_statics.m_jugemDir;
-    Field::ObjectDirector::s_instance = rhs.m_statics.m_objDir;
-    Field::ObjectDrivableDirector::s_instance = rhs.m_statics.m_objDrivableDir;
-    Field::RailManager::s_instance = rhs.m_statics.m_railMgr;
-    Item::ItemDirector::s_instance = rhs.m_statics.m_itemDir;
-    Kart::KartObjectManager::s_instance = rhs.m_statics.m_kartObjMgr;
-    Kart::KartParamFileManager::s_instance = rhs.m_statics.m_paramFileMgr;
-    System::CourseMap::s_instance = rhs.m_statics.m_courseMap;
-    System::KPadDirector::s_instance = rhs.m_statics.m_padDir;
-    System::RaceConfig::s_instance = rhs.m_statics.m_raceConfig;
-    System::RaceConfig::s_onInitCallback = rhs.m_statics.m_onInitCallback;
-    System::RaceConfig::s_onInitCallbackArg = rhs.m_statics.m_onInitCallbackArg;
-    System::RaceManager::s_instance = rhs.m_statics.m_raceMgr;
-    System::ResourceManager::s_instance = rhs.m_statics.m_resMgr;
-    Render::KartCamera::s_instance = rhs.m_statics.m_kartCamera;
-    Kart::KartObjectManager::s_thunderScaleUpAnmChr = rhs.m_statics.m_thunderScaleUpAnmChr;
-    Kart::KartObjectManager::s_thunderScaleDownAnmChr = rhs.m_statics.m_thunderScaleDownAnmChr;
-    Kart::KartObjectManager::s_pressScaleUpAnmChr = rhs.m_statics.m_pressScaleUpAnmChr;
-    Abstract::g3d::FrameCtrl::s_baseUpdateRate = rhs.m_statics.m_frameCtrlBaseUpdateRate;
-    Field::ObjectCollisionBase::s_dotProductCache = rhs.m_statics.m_dotProductCache;
-    Field::ObjectDirector::s_wanwanMaxPitch = rhs.m_statics.m_wanwanMaxPitch;
-    Field::ObjectBasabasa::s_initialXRange = rhs.m_statics.m_basabasaInitialXRange;
-    Field::ObjectBasabasa::s_initialYRange = rhs.m_statics.m_basabasaInitialYRange;
-    Field::ObjectFlamePoleFoot::s_flamePoleCount = rhs.m_statics.m_flamePoleCount;
+    void *memorySpace = reinterpret_cast<void *>(EGG::SceneManager::s_rootHeap);
+    auto retained = System::ResourceManager::GetRetainedMounts();
+
+    if (DirtyPageTracker::IsEnabled()) {
+        if (rhs.m_syncEpoch != 0) {
+            // Lift the protection up front rather than faulting on each page during the copy
+            size_t pageSize = DirtyPageTracker::PageSize();
+            DirtyPageTracker::ForEachRunSince(rhs.m_syncEpoch, [&](size_t page, size_t count) {
+                size_t offset = page * pageSize;
+                DirtyPageTracker::MarkDirty(page, count);
+                memcpy(AddOffset(memorySpace, offset), AddOffset(rhs.m_contextMemory, offset),
+                        count * pageSize);
+            });
+        } else {
+            DirtyPageTracker::MarkAllDirty();
+            memcpy(memorySpace, rhs.m_contextMemory, s_memorySpaceSize);
+        }
+
+        rhs.m_syncEpoch = DirtyPageTracker::Sync();
+    } else {
+        memcpy(memorySpace, rhs.m_contextMemory, s_memorySpaceSize);
+    }
+
+    rhs.loadStatics();
+
+    System::ResourceManager::AcquireRetained(System::ResourceManager::GetRetainedMounts());
+    System::ResourceManager::ReleaseRetained(retained);
+}
+
+/// @brief Captures the current memory space and statics into this context, reusing its buffer.
+/// @details Unlike constructing a new context, this only copies the pages written to since this
+/// context was last synced with the memory space, if dirty page tracking is enabled.
+void Context::save() {
+    ASSERT(EGG::SceneManager::s_rootHeap && m_contextMemory);
+    void *memorySpace = reinterpret_cast<void *>(EGG::SceneManager::s_rootHeap);
+
+    if (DirtyPageTracker::IsEnabled()) {
+        if (m_syncEpoch != 0) {
+            CopyPagesSince(m_syncEpoch, m_contextMemory, memorySpace);
+        } else {
+            memcpy(m_contextMemory, memorySpace, s_memorySpaceSize);
+        }
+
+        m_syncEpoch = DirtyPageTracker::Sync();
+    } else {
+        memcpy(m_contextMemory, memorySpace, s_memorySpaceSize);
+    }
+
+    saveStatics();
+    retainArchives();
 }
 
+/// @brief Switches all contexts to incremental mode, where only modified heap pages are copied.
+/// @details The memory space must be page-aligned (see DirtyPageTracker::AllocPages).
+/// @return Whether incremental mode is supported. If not, contexts keep copying the entire heap.
+bool Context::EnableIncremental() {
+    ASSERT(EGG::SceneManager::s_rootHeap);
+    return DirtyPageTracker::Enable(EGG::SceneManager::s_rootHeap, s_memorySpaceSize);
+}
+
+/// @brief Switches all contexts back to copying the entire heap.
+void Context::DisableIncremental() {
+    DirtyPageTracker::Disable();
+}
+
+/// @brief Copies all pages written to after the given epoch from one memory block to another.
+void Context::CopyPagesSince(u64 epoch, void *dst, const void *src) {
+    size_t pageSize = DirtyPageTracker::PageSize();
+    DirtyPageTracker::ForEachRunSince(epoch, [=](size_t page, size_t count) {
+        size_t offset = page * pageSize;
+        memcpy(AddOffset(dst, offset), AddOffset(src, offset), count * pageSize);
+    });
+}
+
+/// @brief Sets the size of the memory space, which must be done before any context is created.
+void Context::SetMemorySpaceSize(size_t size) {
+    s_memorySpaceSize = size;
+}
+
+size_t Context::MemorySpaceSize() {
+    return s_memorySpaceSize;
+}
+
+/// @brief Gets the start of the live memory space.
+void *Context::MemorySpace() {
+    ASSERT(EGG::SceneManager::s_rootHeap);
+    return reinterpret_cast<void *>(EGG::SceneManager::s_rootHeap);
+}
+
+/// @brief Holds on to the retained archives mounted in the memory space, in place of those this
+/// context held before.
+void Context::retainArchives() {
+    auto retained = System::ResourceManager::GetRetainedMounts();
+    System::ResourceManager::AcquireRetained(retained);
+    System::ResourceManager::ReleaseRetained(m_retainedArchives);
+    m_retainedArchives = retained;
+}
+
+void Context::saveStatics() {
+    SaveStatics(m_statics);
+}
+
+void Context::loadStatics() const {
+    LoadStatics(m_statics);
+}
+
+/// @brief Copies every static that Context saves, such as singletons and heap lists.
+void Context::SaveStatics(Statics &statics) {
+    statics.m_rootList = Abstract::Memory::MEMiHeapHead::s_rootList;
+    statics.m_archiveList = EGG::Archive::s_archiveList;
+    statics.m_heapList = EGG::Heap::s_heapList;
+    statics.m_currentHeap = EGG::Heap::s_currentHeap;
+    statics.m_allocatableHeap = EGG::Heap::s_allocatableHeap;
+    statics.m_heapForCreateScene = EGG::SceneManager::s_heapForCreateScene;
+    statics.m_heapOptionFlg = EGG::SceneManager::s_heapOptionFlg;
+    statics.m_rootHeap = EGG::SceneManager::s_rootHeap;
+    statics.m_boxColMgr = Field::BoxColManager::s_instance;
+    statics.m_colDir = Field::CollisionDirector::s_instance;
+    statics.m_courseColMgr = Field::CourseColMgr::s_instance;
+    statics.m_jugemDir = Field::JugemDirector::s_instance;
+    statics.m_objDir = Field::ObjectDirector::s_instance;
+    statics.m_objDrivableDir = Field::ObjectDrivableDirector::s_instance;
+    statics.m_railMgr = Field::RailManager::s_instance;
+    statics.m_itemDir = Item::ItemDirector::s_instance;
+    statics.m_kartObjMgr = Kart::KartObjectManager::s_instance;
+    statics.m_proxyList = Kart::KartObjectProxy::s_proxyList;
+    statics.m_paramFileMgr = Kart::KartParamFileManager::s_instance;
+    statics.m_courseMap = System::CourseMap::s_instance;
+    statics.m_padDir = System::KPadDirector::s_instance;
+    statics.m_raceConfig = System::RaceConfig::s_instance;
+    statics.m_onInitCallback = System::RaceConfig::s_onInitCallback;
+    statics.m_onInitCallbackArg = System::RaceConfig::s_onInitCallbackArg;
+    statics.m_raceMgr = System::RaceManager::s_instance;
+    statics.m_resMgr = System::ResourceManager::s_instance;
+    statics.m_kartCamera = Render::KartCamera::s_instance;
+    statics.m_thunderScaleUpAnmChr = Kart::KartObjectManager::s_thunderScaleUpAnmChr;
+    statics.m_thunderScaleDownAnmChr = Kart::KartObjectManager::s_thunderScaleDownAnmChr;
+    statics.m_pressScaleUpAnmChr = Kart::KartObjectManager::s_pressScaleUpAnmChr;
+    statics.m_frameCtrlBaseUpdateRate = Abstract::g3d::FrameCtrl::s_baseUpdateRate;
+    statics.m_dotProductCache = Field::ObjectCollisionBase::s_dotProductCache;
+    statics.m_wanwanMaxPitch = Field::ObjectDirector::s_wanwanMaxPitch;
+    statics.m_basabasaInitialXRange = Field::ObjectBasabasa::s_initialXRange;
+    statics.m_basabasaInitialYRange = Field::ObjectBasabasa::s_initialYRange;
+    statics.m_flamePoleCount = Field::ObjectFlamePoleFoot::s_flamePoleCount;
+}
+
+/// @brief Replaces every static that Context saves, such as singletons and heap lists.
+void Context::LoadStatics(const Statics &statics) {
+    Abstract::Memory::MEMiHeapHead::s_rootList = statics.m_rootList;
+    EGG::Archive::s_archiveList = statics.m_archiveList;
+    EGG::Heap::s_heapList = statics.m_heapList;
+    EGG::Heap::s_currentHeap = statics.m_currentHeap;
+    EGG::Heap::s_allocatableHeap = statics.m_allocatableHeap;
+    EGG::SceneManager::s_heapForCreateScene = statics.m_heapForCreateScene;
+    EGG::SceneManager::s_heapOptionFlg = statics.m_heapOptionFlg;
+    EGG::SceneManager::s_rootHeap = statics.m_rootHeap;
+    Field::BoxColManager::s_instance = statics.m_boxColMgr;
+    Field::CollisionDirector::s_instance = statics.m_colDir;
+    Field::CourseColMgr::s_instance = statics.m_courseColMgr;
+    Field::JugemDirector::s_instance = statics.m_jugemDir;
+    Field::ObjectDirector::s_instance = statics.m_objDir;
+    Field::ObjectDrivableDirector::s_instance = statics.m_objDrivableDir;
+    Field::RailManager::s_instance = statics.m_railMgr;
+    Item::ItemDirector::s_instance = statics.m_itemDir;
+    Kart::KartObjectManager::s_instance = statics.m_kartObjMgr;
+    Kart::KartObjectProxy::s_proxyList = statics.m_proxyList;
+    Kart::KartParamFileManager::s_instance = statics.m_paramFileMgr;
+    System::CourseMap::s_instance = statics.m_courseMap;
+    System::KPadDirector::s_instance = statics.m_padDir;
+    System::RaceConfig::s_instance = statics.m_raceConfig;
+    System::RaceConfig::s_onInitCallback = statics.m_onInitCallback;
+    System::RaceConfig::s_onInitCallbackArg = statics.m_onInitCallbackArg;
+    System::RaceManager::s_instance = statics.m_raceMgr;
+    System::ResourceManager::s_instance = statics.m_resMgr;
+    Render::KartCamera::s_instance = statics.m_kartCamera;
+    Kart::KartObjectManager::s_thunderScaleUpAnmChr = statics.m_thunderScaleUpAnmChr;
+    Kart::KartObjectManager::s_thunderScaleDownAnmChr = statics.m_thunderScaleDownAnmChr;
+    Kart::KartObjectManager::s_pressScaleUpAnmChr = statics.m_pressScaleUpAnmChr;
+    Abstract::g3d::FrameCtrl::s_baseUpdateRate = statics.m_frameCtrlBaseUpdateRate;
+    Field::ObjectCollisionBase::s_dotProductCache = statics.m_dotProductCache;
+    Field::ObjectDirector::s_wanwanMaxPitch = statics.m_wanwanMaxPitch;
+    Field::ObjectBasabasa::s_initialXRange = statics.m_basabasaInitialXRange;
+    Field::ObjectBasabasa::s_initialYRange = statics.m_basabasaInitialYRange;
+    Field::ObjectFlamePoleFoot::s_flamePoleCount = statics.m_flamePoleCount;
+}
+
+size_t Context::s_memorySpaceSize = MEMORY_SPACE_SIZE;
+
 } // namespace Kinoko::Host
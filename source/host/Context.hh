@@ -2,8 +2,12 @@
 
 #include "Common.hh"
 
+#include <egg/core/Allocator.hh>
+#include <egg/core/Archive.hh>
+
 #include <filesystem>
 #include <functional>
+#include <list>
 #include <optional>
 
 namespace Kinoko {
@@ -42,6 +46,7 @@ class ItemDirector;
 
 namespace Kart {
 class KartObjectManager;
+class KartObjectProxy;
 class KartParamFileManager;
 } // namespace Kart
 
@@ -58,6 +63,7 @@ typedef std::function<void(RaceConfig *, void *)> InitCallback;
 class RaceInputState;
 class RaceManager;
 class ResourceManager;
+struct RetainedArchive;
 class KSystem;
 } // namespace System
 
@@ -68,6 +74,10 @@ namespace Host {
 /// checkpoint. Contexts work by performing a memcpy of the entire game heap, which is reliable
 /// since we override operator new with an EGG::Heap implementation. For variables with static
 /// storage duration, they may exist out of the heap. Thus, we need to manually copy those.
+///
+/// In incremental mode, DirtyPageTracker records which heap pages are written to. A context then
+/// remembers the epoch at which its copy last matched the heap, and save() and SetActiveContext()
+/// only copy the pages written to since that epoch.
 class Context {
 public:
     Context();
@@ -80,49 +90,87 @@ public:
 
     bool operator==(const Context &rhs) const;
 
+    void save();
+
     static void SetActiveContext(const Context &rhs);
 
+    static bool EnableIncremental();
+    static void DisableIncremental();
+
+    static void SetMemorySpaceSize(size_t size);
+    [[nodiscard]] static size_t MemorySpaceSize();
+
 private:
+    friend class Arena;
+    friend class RewindBuffer;
+
+    /// @brief Every static that Context saves.
+    /// @details Default-initialized statics hold the values the engine's statics have when a thread
+    /// starts, before any heap, archive or singleton exists.
     struct Statics {
-        Abstract::Memory::MEMList m_rootList;
-        Abstract::Memory::MEMList m_archiveList;
-        Abstract::Memory::MEMList m_heapList;
-        EGG::Heap *m_currentHeap;
-        EGG::Heap *m_allocatableHeap;
-        EGG::Heap *m_heapForCreateScene;
-        u16 m_heapOptionFlg;
-        EGG::Heap *m_rootHeap;
-        Field::BoxColManager *m_boxColMgr;
-        Field::CollisionDirector *m_colDir;
-        Field::CourseColMgr *m_courseColMgr;
-        Field::JugemDirector *m_jugemDir;
-        Field::ObjectDirector *m_objDir;
-        Field::ObjectDrivableDirector *m_objDrivableDir;
-        Field::RailManager *m_railMgr;
-        Item::ItemDirector *m_itemDir;
-        Kart::KartObjectManager *m_kartObjMgr;
-        Kart::KartParamFileManager *m_paramFileMgr;
-        System::CourseMap *m_courseMap;
-        System::KPadDirector *m_padDir;
-        System::RaceConfig *m_raceConfig;
-        System::InitCallback m_onInitCallback;
-        void *m_onInitCallbackArg;
-        System::RaceManager *m_raceMgr;
-        System::ResourceManager *m_resMgr;
-        Render::KartCamera *m_kartCamera;
-        Abstract::g3d::ResAnmChr *m_thunderScaleUpAnmChr;
-        Abstract::g3d::ResAnmChr *m_thunderScaleDownAnmChr;
-        Abstract::g3d::ResAnmChr *m_pressScaleUpAnmChr;
-        f32 m_frameCtrlBaseUpdateRate;
-        std::array<std::array<f32, 4>, 4> m_dotProductCache;
-        f32 m_wanwanMaxPitch;
-        f32 m_basabasaInitialXRange;
-        f32 m_basabasaInitialYRange;
-        u32 m_flamePoleCount;
+        Abstract::Memory::MEMList m_rootList =
+                Abstract::Memory::MEMList(Abstract::Memory::MEMiHeapHead::getLinkOffset());
+        Abstract::Memory::MEMList m_archiveList =
+                Abstract::Memory::MEMList(EGG::Archive::GetLinkOffset());
+        Abstract::Memory::MEMList m_heapList = Abstract::Memory::MEMList(EGG::Heap::getOffset());
+        EGG::Heap *m_currentHeap = nullptr;
+        EGG::Heap *m_allocatableHeap = nullptr;
+        EGG::Heap *m_heapForCreateScene = nullptr;
+        u16 m_heapOptionFlg = DEFAULT_OPT;
+        EGG::Heap *m_rootHeap = nullptr;
+        Field::BoxColManager *m_boxColMgr = nullptr;
+        Field::CollisionDirector *m_colDir = nullptr;
+        Field::CourseColMgr *m_courseColMgr = nullptr;
+        Field::JugemDirector *m_jugemDir = nullptr;
+        Field::ObjectDirector *m_objDir = nullptr;
+        Field::ObjectDrivableDirector *m_objDrivableDir = nullptr;
+        Field::RailManager *m_railMgr = nullptr;
+        Item::ItemDirector *m_itemDir = nullptr;
+        Kart::KartObjectManager *m_kartObjMgr = nullptr;
+        std::list<Kart::KartObjectProxy *, EGG::Allocator<Kart::KartObjectProxy *>> *m_proxyList =
+                nullptr;
+        Kart::KartParamFileManager *m_paramFileMgr = nullptr;
+        System::CourseMap *m_courseMap = nullptr;
+        System::KPadDirector *m_padDir = nullptr;
+        System::RaceConfig *m_raceConfig = nullptr;
+        System::InitCallback m_onInitCallback = nullptr;
+        void *m_onInitCallbackArg = nullptr;
+        System::RaceManager *m_raceMgr = nullptr;
+        System::ResourceManager *m_resMgr = nullptr;
+        Render::KartCamera *m_kartCamera = nullptr;
+        Abstract::g3d::ResAnmChr *m_thunderScaleUpAnmChr = nullptr;
+        Abstract::g3d::ResAnmChr *m_thunderScaleDownAnmChr = nullptr;
+        Abstract::g3d::ResAnmChr *m_pressScaleUpAnmChr = nullptr;
+        f32 m_frameCtrlBaseUpdateRate = 1.0f;
+        std::array<std::array<f32, 4>, 4> m_dotProductCache = {};
+        f32 m_wanwanMaxPitch = 0.0f;
+        f32 m_basabasaInitialXRange = 0.0f;
+        f32 m_basabasaInitialYRange = 0.0f;
+        u32 m_flamePoleCount = 0;
     };
 
+    void saveStatics();
+    void loadStatics() const;
+
+    static void SaveStatics(Statics &statics);
+    static void LoadStatics(const Statics &statics);
+
+    void retainArchives();
+
+    static void CopyPagesSince(u64 epoch, void *dst, const void *src);
+    [[nodiscard]] static void *MemorySpace();
+
     void *m_contextMemory;
+    /// Epoch at which m_contextMemory last matched the heap, or 0 if unknown. Restoring a context
+    /// syncs it with the heap, so this is updated through const references as well.
+    mutable u64 m_syncEpoch;
     Statics m_statics;
+
+    /// The retained archives mounted in m_contextMemory, which are kept from being evicted while
+    /// this context may restore them. @see System::ResourceManager::SetRetainBudget.
+    std::array<System::RetainedArchive *, 2> m_retainedArchives;
+
+    static size_t s_memorySpaceSize;
 };
 
 } // namespace Host
@@ -0,0 +1,253 @@
+#include "DirtyPageTracker.hh"
+
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define DIRTY_PAGE_TRACKING_SUPPORTED
+
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace Kinoko::Host {
+
+#ifdef DIRTY_PAGE_TRACKING_SUPPORTED
+static struct sigaction s_prevSegvAction;
+static struct sigaction s_prevBusAction;
+
+/// @brief Lifts the write protection of a tracked page on its first write of the epoch.
+/// @details Faults outside of the tracked region are forwarded to the previously installed
+/// handler. If that handler is the default one, we reinstate it and return, so that the faulting
+/// instruction is retried and the process terminates as it normally would.
+static void OnFault(int sig, siginfo_t *info, void *ucontext) {
+    u8 *base = DirtyPageTracker::Base();
+    uintptr_t addr = GetAddrNum(info->si_addr);
+
+    if (base) {
+        uintptr_t offset = addr - GetAddrNum(base);
+        size_t page = offset / DirtyPageTracker::PageSize();
+
+        // A fault on an already writable page is a genuine access violation
+        if (offset < DirtyPageTracker::PageCount() * DirtyPageTracker::PageSize() &&
+                DirtyPageTracker::MarkDirty(page)) {
+            return;
+        }
+    }
+
+    const struct sigaction &prev = sig == SIGBUS ? s_prevBusAction : s_prevSegvAction;
+    if (prev.sa_flags & SA_SIGINFO) {
+        prev.sa_sigaction(sig, info, ucontext);
+    } else if (prev.sa_handler != SIG_DFL && prev.sa_handler != SIG_IGN) {
+        prev.sa_handler(sig);
+    } else {
+        sigaction(sig, &prev, nullptr);
+    }
+}
+#endif // DIRTY_PAGE_TRACKING_SUPPORTED
+
+/// @brief Starts tracking writes to a page-aligned memory region.
+/// @details Every page starts out dirty, so savestates taken prior to enabling are fully copied.
+/// @param base The start of the region. Must be aligned to the page size.
+/// @param size The size of the region. Must be a multiple of the page size.
+/// @return Whether tracking is supported for the region. If false, the caller should fall back to
+/// copying the entire region.
+bool DirtyPageTracker::Enable(void *base, size_t size) {
+    ASSERT(!IsEnabled());
+
+#ifdef DIRTY_PAGE_TRACKING_SUPPORTED
+    size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    if (GetAddrNum(base) % pageSize != 0 || size % pageSize != 0) {
+        WARN("Memory space %p (0x%zx bytes) is not page-aligned, cannot track dirty pages", base,
+                size);
+        return false;
+    }
+
+    s_pageSize = pageSize;
+    s_pageCount = size / pageSize;
+    s_stamps = static_cast<u64 *>(malloc(s_pageCount * sizeof(u64)));
+    s_writable = static_cast<u8 *>(malloc(s_pageCount));
+    ASSERT(s_stamps && s_writable);
+
+    // Start at a fresh epoch, so that every previously synced savestate is considered stale
+    ++s_epoch;
+    for (size_t i = 0; i < s_pageCount; ++i) {
+        s_stamps[i] = s_epoch;
+    }
+
+    memset(s_writable, 0, s_pageCount);
+    s_writableCount = 0;
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = OnFault;
+    action.sa_flags = SA_SIGINFO;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGSEGV, &action, &s_prevSegvAction);
+    sigaction(SIGBUS, &action, &s_prevBusAction);
+
+    s_base = static_cast<u8 *>(base);
+    Protect(0, s_pageCount, false);
+
+    return true;
+#else
+    (void)base;
+    (void)size;
+    return false;
+#endif // DIRTY_PAGE_TRACKING_SUPPORTED
+}
+
+/// @brief Stops tracking writes and removes all write protection.
+void DirtyPageTracker::Disable() {
+    if (!IsEnabled()) {
+        return;
+    }
+
+#ifdef DIRTY_PAGE_TRACKING_SUPPORTED
+    Protect(0, s_pageCount, true);
+    s_base = nullptr;
+
+    sigaction(SIGSEGV, &s_prevSegvAction, nullptr);
+    sigaction(SIGBUS, &s_prevBusAction, nullptr);
+
+    free(s_stamps);
+    free(s_writable);
+    s_stamps = nullptr;
+    s_writable = nullptr;
+    s_writableCount = 0;
+    s_pageCount = 0;
+#endif // DIRTY_PAGE_TRACKING_SUPPORTED
+}
+
+/// @brief Ends the current epoch and write-protects all pages that were written to during it.
+/// @details Call this immediately after the memory space and a savestate have been made identical.
+/// @return The epoch that just ended. A savestate synced at this epoch differs from the memory
+/// space only in pages stamped after it.
+u64 DirtyPageTracker::Sync() {
+    ASSERT(IsEnabled());
+
+    for (size_t page = 0; s_writableCount > 0 && page < s_pageCount;) {
+        if (!s_writable[page]) {
+            ++page;
+            continue;
+        }
+
+        size_t first = page;
+        while (page < s_pageCount && s_writable[page]) {
+            s_writable[page++] = false;
+            --s_writableCount;
+        }
+
+        Protect(first, page - first, false);
+    }
+
+    return s_epoch++;
+}
+
+/// @brief Stamps a page with the current epoch and lifts its write protection.
+/// @details This is also called from the fault handler, so it must remain async-signal-safe.
+/// @return Whether the page was write-protected prior to this call.
+bool DirtyPageTracker::MarkDirty(size_t page) {
+    s_stamps[page] = s_epoch;
+
+    if (s_writable[page]) {
+        return false;
+    }
+
+    s_writable[page] = true;
+    ++s_writableCount;
+    if (!TryProtect(page, 1, true)) {
+#ifdef DIRTY_PAGE_TRACKING_SUPPORTED
+        // PANIC formats its message and aborts, neither of which is async-signal-safe
+        constexpr char MESSAGE[] = "Failed to lift write protection of a tracked page\n";
+        (void)!write(STDERR_FILENO, MESSAGE, sizeof(MESSAGE) - 1);
+        _exit(EXIT_FAILURE);
+#endif // DIRTY_PAGE_TRACKING_SUPPORTED
+    }
+
+    return true;
+}
+
+/// @brief Stamps a run of pages with the current epoch and lifts their write protection.
+/// @details Used prior to overwriting pages, to avoid faulting on each of them individually.
+void DirtyPageTracker::MarkDirty(size_t page, size_t count) {
+    ASSERT(IsEnabled() && page + count <= s_pageCount);
+
+    for (size_t i = page; i < page + count; ++i) {
+        s_stamps[i] = s_epoch;
+
+        if (!s_writable[i]) {
+            s_writable[i] = true;
+            ++s_writableCount;
+        }
+    }
+
+    Protect(page, count, true);
+}
+
+/// @brief Stamps every page with the current epoch and lifts all write protection.
+void DirtyPageTracker::MarkAllDirty() {
+    MarkDirty(0, s_pageCount);
+}
+
+/// @brief Allocates a zeroed, page-aligned memory block suitable for tracking.
+/// @details Falls back to malloc on hosts that do not support tracking.
+void *DirtyPageTracker::AllocPages(size_t size) {
+#ifdef DIRTY_PAGE_TRACKING_SUPPORTED
+    void *block = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return block == MAP_FAILED ? nullptr : block;
+#else
+    return malloc(size);
+#endif // DIRTY_PAGE_TRACKING_SUPPORTED
+}
+
+/// @brief Frees a memory block returned by AllocPages.
+void DirtyPageTracker::FreePages(void *block, size_t size) {
+#ifdef DIRTY_PAGE_TRACKING_SUPPORTED
+    munmap(block, size);
+#else
+    (void)size;
+    free(block);
+#endif // DIRTY_PAGE_TRACKING_SUPPORTED
+}
+
+/// @brief Whether the host supports write-protecting pages and catching the resulting faults.
+bool DirtyPageTracker::IsSupported() {
+#ifdef DIRTY_PAGE_TRACKING_SUPPORTED
+    return true;
+#else
+    return false;
+#endif // DIRTY_PAGE_TRACKING_SUPPORTED
+}
+
+void DirtyPageTracker::Protect(size_t page, size_t count, bool writable) {
+    if (!TryProtect(page, count, writable)) {
+        PANIC("Failed to change protection of %zu pages at %p", count, s_base + page * s_pageSize);
+    }
+}
+
+/// @brief Changes the protection of a run of pages without reporting failures.
+/// @details This is also called from the fault handler, so it must remain async-signal-safe.
+/// @return Whether the protection was changed.
+bool DirtyPageTracker::TryProtect(size_t page, size_t count, bool writable) {
+#ifdef DIRTY_PAGE_TRACKING_SUPPORTED
+    int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    return mprotect(s_base + page * s_pageSize, count * s_pageSize, prot) == 0;
+#else
+    (void)page;
+    (void)count;
+    (void)writable;
+    return true;
+#endif // DIRTY_PAGE_TRACKING_SUPPORTED
+}
+
+u8 *DirtyPageTracker::s_base = nullptr;
+size_t DirtyPageTracker::s_pageSize = 0;
+size_t DirtyPageTracker::s_pageCount = 0;
+u64 *DirtyPageTracker::s_stamps = nullptr;
+u8 *DirtyPageTracker::s_writable = nullptr;
+size_t DirtyPageTracker::s_writableCount = 0;
+u64 DirtyPageTracker::s_epoch = 0;
+
+} // namespace Kinoko::Host
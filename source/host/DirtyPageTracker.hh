@@ -0,0 +1,86 @@
+#pragma once
+
+#include <Common.hh>
+
+namespace Kinoko::Host {
+
+/// @brief Tracks which pages of the root memory space have been written to since a savestate.
+/// @details After every sync point, all pages of the tracked region are write-protected. The first
+/// write to a page afterwards faults, and the fault handler lifts the protection and stamps the
+/// page with the current epoch. Each page is therefore only faulted once per epoch, and a savestate
+/// taken at epoch `e` differs from the live memory space in exactly the pages stamped after `e`.
+/// This is what allows Context to copy a few hundred kilobytes instead of the entire heap.
+///
+/// The region must be page-aligned, which is why it should be allocated with AllocPages. Writes
+/// performed by the kernel (i.e. `read` into a heap buffer) do not fault and must target pages
+/// that were already written to in the current epoch. Heap allocations always satisfy this, since
+/// MEMiHeapHead fills allocated memory.
+///
+/// The tracker is process-global. It tracks a single region with one fault handler and one epoch,
+/// so it can't be combined with Arena, which asserts that it is disabled. Only the thread that
+/// enabled it may write to the tracked region, as the stamps are not synchronized.
+class DirtyPageTracker {
+public:
+    static bool Enable(void *base, size_t size);
+    static void Disable();
+
+    static u64 Sync();
+    static bool MarkDirty(size_t page);
+    static void MarkDirty(size_t page, size_t count);
+    static void MarkAllDirty();
+
+    [[nodiscard]] static void *AllocPages(size_t size);
+    static void FreePages(void *block, size_t size);
+
+    /// @brief Invokes a callback on each run of consecutive pages written to after a given epoch.
+    /// @param epoch The epoch the caller's copy of the memory space was synced at.
+    /// @param func Callable taking the first page index and the number of pages in the run.
+    template <typename F>
+    static void ForEachRunSince(u64 epoch, F &&func) {
+        for (size_t page = 0; page < s_pageCount;) {
+            if (s_stamps[page] <= epoch) {
+                ++page;
+                continue;
+            }
+
+            size_t first = page;
+            while (page < s_pageCount && s_stamps[page] > epoch) {
+                ++page;
+            }
+
+            func(first, page - first);
+        }
+    }
+
+    [[nodiscard]] static bool IsSupported();
+
+    [[nodiscard]] static bool IsEnabled() {
+        return s_base != nullptr;
+    }
+
+    [[nodiscard]] static u8 *Base() {
+        return s_base;
+    }
+
+    [[nodiscard]] static size_t PageSize() {
+        return s_pageSize;
+    }
+
+    [[nodiscard]] static size_t PageCount() {
+        return s_pageCount;
+    }
+
+private:
+    static void Protect(size_t page, size_t count, bool writable);
+    [[nodiscard]] static bool TryProtect(size_t page, size_t count, bool writable);
+
+    static u8 *s_base;             ///< Start of the tracked region, or nullptr if disabled.
+    static size_t s_pageSize;      ///< The host's page size.
+    static size_t s_pageCount;     ///< Number of pages in the tracked region.
+    static u64 *s_stamps;          ///< The epoch each page was last written in.
+    static u8 *s_writable;         ///< Whether each page is currently unprotected.
+    static size_t s_writableCount; ///< Number of currently unprotected pages.
+    static u64 s_epoch;            ///< Never reset, so stale savestates stay fully dirty.
+};
+
+} // namespace Kinoko::Host
@@ -0,0 +1,307 @@
+#include "HostChannel.hh"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstring>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define HOST_CHANNEL_SUPPORTED
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+namespace Kinoko::Host::Channel {
+
+STATIC_ASSERT((KINOKO_CHANNEL_RING_SIZE & (KINOKO_CHANNEL_RING_SIZE - 1)) == 0);
+STATIC_ASSERT(sizeof(KinokoChannelCursor) == KINOKO_CHANNEL_CACHE_LINE);
+STATIC_ASSERT(offsetof(KinokoChannel, inputs) == KINOKO_CHANNEL_CACHE_LINE);
+STATIC_ASSERT(KINOKO_CHANNEL_CHECK_INTERVAL_MS < 1000);
+
+/// @brief How many times to check a cursor before sleeping on it. Roughly tens of microseconds.
+static constexpr u32 SPIN_COUNT = 1 << 14;
+
+/// @brief With a single CPU, the other side can't move the cursor while we spin.
+static const u32 s_spinCount = std::thread::hardware_concurrency() > 1 ? SPIN_COUNT : 0;
+
+/// @brief How long to sleep on a cursor before checking that the other side is still running.
+static constexpr std::chrono::milliseconds CHECK_INTERVAL(KINOKO_CHANNEL_CHECK_INTERVAL_MS);
+
+/// @brief Checks whether the other side of the channel may still move its cursors.
+/// @details Checking whether the other side's process exited takes a system call, so it is only
+/// done every check interval.
+typedef bool (*IsPeerOpenFunc)(const KinokoChannel &channel, bool checkProcess);
+
+/// @brief Hints to the CPU that we are spinning, so that the other hardware thread can run.
+static void Pause() {
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(__arm64__) || defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+/// @brief Sleeps until the value changes or the check interval passes, or returns immediately if
+/// the value already has changed.
+/// @details The channel is shared between processes, so this isn't a private futex. Hosts without
+/// futexes yield instead.
+static void FutexWait(u32 &value, u32 expected) {
+#ifdef __linux__
+    constexpr auto INTERVAL_NS = std::chrono::nanoseconds(CHECK_INTERVAL).count();
+    constexpr timespec TIMEOUT = {0, static_cast<long>(INTERVAL_NS)};
+    syscall(SYS_futex, &value, FUTEX_WAIT, expected, &TIMEOUT, nullptr, 0);
+#else
+    (void)value;
+    (void)expected;
+    std::this_thread::yield();
+#endif
+}
+
+static void FutexWake(u32 &value, int count) {
+#ifdef __linux__
+    syscall(SYS_futex, &value, FUTEX_WAKE, count, nullptr, nullptr, 0);
+#else
+    (void)value;
+    (void)count;
+#endif
+}
+
+/// @brief Checks whether a process sharing the channel has exited. A PID of 0 is never checked.
+static bool HasExited(u32 pid) {
+#ifdef HOST_CHANNEL_SUPPORTED
+    return pid != 0 && kill(static_cast<pid_t>(pid), 0) != 0 && errno == ESRCH;
+#else
+    (void)pid;
+    return false;
+#endif
+}
+
+static u32 Load(const u32 &value) {
+    return std::atomic_ref<u32>(const_cast<u32 &>(value)).load(std::memory_order_acquire);
+}
+
+/// @brief Checks whether the agent may still push inputs or pop states.
+static bool IsAgentOpen(const KinokoChannel &channel, bool checkProcess) {
+    if (Load(channel.agentClosed) != 0) {
+        return false;
+    }
+
+    return !checkProcess || !HasExited(Load(channel.agentPid));
+}
+
+/// @brief Checks whether Kinoko may still pop inputs or push states.
+static bool IsKinokoOpen(const KinokoChannel &channel, bool checkProcess) {
+    KinokoChannelStatus status = GetStatus(channel);
+    if (status == KINOKO_CHANNEL_CLOSED || status == KINOKO_CHANNEL_ERROR) {
+        return false;
+    }
+
+    return !checkProcess || !HasExited(Load(channel.kinokoPid));
+}
+
+/// @brief Waits until the other side moves a cursor away from a value.
+/// @details The other side is checked before every sleep, so that a side which exits without
+/// closing the channel doesn't leave us waiting forever.
+/// @return The new value of the cursor, or std::nullopt if the other side has stopped.
+static std::optional<u32> WaitForChange(const KinokoChannel &channel, KinokoChannelCursor &cursor,
+        u32 value, IsPeerOpenFunc isPeerOpen) {
+    std::atomic_ref<u32> current(cursor.value);
+    for (u32 i = 0; i < s_spinCount; ++i) {
+        u32 observed = current.load(std::memory_order_acquire);
+        if (observed != value) {
+            return observed;
+        }
+
+        Pause();
+    }
+
+    // Either we see the new value after raising the flag, or the other side sees the flag after
+    // moving the cursor, and wakes us
+    std::atomic_ref<u32> waiting(cursor.waiting);
+    auto nextCheck = std::chrono::steady_clock::now() + CHECK_INTERVAL;
+    while (true) {
+        waiting.store(1, std::memory_order_seq_cst);
+        u32 observed = current.load(std::memory_order_seq_cst);
+        if (observed != value) {
+            waiting.store(0, std::memory_order_relaxed);
+            return observed;
+        }
+
+        // The cursor is checked first, as the other side may have moved it before stopping
+        auto now = std::chrono::steady_clock::now();
+        bool checkProcess = now >= nextCheck;
+        if (checkProcess) {
+            nextCheck = now + CHECK_INTERVAL;
+        }
+
+        if (!isPeerOpen(channel, checkProcess)) {
+            waiting.store(0, std::memory_order_relaxed);
+            return std::nullopt;
+        }
+
+        FutexWait(cursor.value, value);
+    }
+}
+
+/// @brief Moves a cursor, waking the other side if it may be sleeping on it.
+static void Publish(KinokoChannelCursor &cursor, u32 value) {
+    std::atomic_ref<u32>(cursor.value).store(value, std::memory_order_seq_cst);
+    if (std::atomic_ref<u32>(cursor.waiting).load(std::memory_order_seq_cst) != 0) {
+        FutexWake(cursor.value, 1);
+    }
+}
+
+template <typename Ring, typename T>
+static bool Push(const KinokoChannel &channel, Ring &ring, const T &entry,
+        IsPeerOpenFunc isPeerOpen) {
+    // Only this side moves the head
+    u32 head = std::atomic_ref<u32>(ring.head.value).load(std::memory_order_relaxed);
+    u32 tail = std::atomic_ref<u32>(ring.tail.value).load(std::memory_order_acquire);
+    while (head - tail >= KINOKO_CHANNEL_RING_SIZE) {
+        std::optional<u32> newTail = WaitForChange(channel, ring.tail, tail, isPeerOpen);
+        if (!newTail) {
+            return false;
+        }
+
+        tail = *newTail;
+    }
+
+    ring.entries[head % KINOKO_CHANNEL_RING_SIZE] = entry;
+    Publish(ring.head, head + 1);
+    return true;
+}
+
+template <typename Ring, typename T>
+static std::optional<T> Pop(const KinokoChannel &channel, Ring &ring, IsPeerOpenFunc isPeerOpen) {
+    // Only this side moves the tail
+    u32 tail = std::atomic_ref<u32>(ring.tail.value).load(std::memory_order_relaxed);
+    u32 head = std::atomic_ref<u32>(ring.head.value).load(std::memory_order_acquire);
+    while (head == tail) {
+        std::optional<u32> newHead = WaitForChange(channel, ring.head, head, isPeerOpen);
+        if (!newHead) {
+            return std::nullopt;
+        }
+
+        head = *newHead;
+    }
+
+    T entry = ring.entries[tail % KINOKO_CHANNEL_RING_SIZE];
+    Publish(ring.tail, tail + 1);
+    return entry;
+}
+
+bool IsSupported() {
+#ifdef HOST_CHANNEL_SUPPORTED
+    return true;
+#else
+    return false;
+#endif
+}
+
+/// @brief Maps the channel an agent created.
+/// @param name The name of the POSIX shared memory object, such as "/kinoko".
+/// @return The channel, which must be unmapped with Close.
+KinokoChannel *Open(const char *name) {
+#ifdef HOST_CHANNEL_SUPPORTED
+    int fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0) {
+        PANIC("Failed to open channel %s", name);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(KinokoChannel)) {
+        PANIC("Channel %s is smaller than %zu bytes", name, sizeof(KinokoChannel));
+    }
+
+    void *memory = mmap(nullptr, sizeof(KinokoChannel), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        PANIC("Failed to map channel %s", name);
+    }
+
+    auto *channel = static_cast<KinokoChannel *>(memory);
+    if (channel->magic != KINOKO_CHANNEL_MAGIC || channel->version != KINOKO_CHANNEL_VERSION) {
+        PANIC("Channel %s has version %u, but expected %u", name, channel->version,
+                KINOKO_CHANNEL_VERSION);
+    }
+
+    std::atomic_ref<u32>(channel->kinokoPid).store(static_cast<u32>(getpid()),
+            std::memory_order_release);
+    return channel;
+#else
+    PANIC("Channels require POSIX shared memory, which this host doesn't support (%s)", name);
+#endif
+}
+
+void Close(KinokoChannel *channel) {
+#ifdef HOST_CHANNEL_SUPPORTED
+    munmap(channel, sizeof(KinokoChannel));
+#else
+    (void)channel;
+#endif
+}
+
+/// @brief Initializes a channel as an agent does before running Kinoko.
+void Init(KinokoChannel &channel, const KinokoRaceParams &race) {
+    memset(&channel, 0, sizeof(channel));
+    channel.magic = KINOKO_CHANNEL_MAGIC;
+    channel.version = KINOKO_CHANNEL_VERSION;
+    channel.race = race;
+}
+
+/// @brief Sets Kinoko's status. Once Kinoko stops, the agent is woken from any cursor it waits on.
+void SetStatus(KinokoChannel &channel, KinokoChannelStatus status) {
+    std::atomic_ref<u32>(channel.status).store(status, std::memory_order_seq_cst);
+    if (status == KINOKO_CHANNEL_CLOSED || status == KINOKO_CHANNEL_ERROR) {
+        FutexWake(channel.inputs.tail.value, INT_MAX);
+        FutexWake(channel.states.head.value, INT_MAX);
+    }
+}
+
+KinokoChannelStatus GetStatus(const KinokoChannel &channel) {
+    u32 &status = const_cast<u32 &>(channel.status);
+    return static_cast<KinokoChannelStatus>(
+            std::atomic_ref<u32>(status).load(std::memory_order_acquire));
+}
+
+/// @brief Pushes an input as the agent.
+/// @return Whether the input was pushed, or Kinoko stopped while the ring was full.
+bool PushInput(KinokoChannel &channel, const KinokoChannelInput &input) {
+    return Push(channel, channel.inputs, input, IsKinokoOpen);
+}
+
+/// @brief Pops an input as Kinoko.
+/// @return The input, or std::nullopt if the agent stopped without pushing one.
+std::optional<KinokoChannelInput> PopInput(KinokoChannel &channel) {
+    return Pop<KinokoChannelInputRing, KinokoChannelInput>(channel, channel.inputs, IsAgentOpen);
+}
+
+/// @brief Pushes a state as Kinoko.
+/// @return Whether the state was pushed, or the agent stopped while the ring was full.
+bool PushState(KinokoChannel &channel, const KinokoKartState &state) {
+    return Push(channel, channel.states, state, IsAgentOpen);
+}
+
+/// @brief Pops a state as the agent.
+/// @return The state, or std::nullopt if Kinoko stopped without pushing one.
+std::optional<KinokoKartState> PopState(KinokoChannel &channel) {
+    return Pop<KinokoChannelStateRing, KinokoKartState>(channel, channel.states, IsKinokoOpen);
+}
+
+} // namespace Kinoko::Host::Channel
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <Common.hh>
+
+#include <kinoko_channel.h>
+
+#include <optional>
+
+/// @brief The Kinoko side of the shared-memory channel in kinoko_channel.h.
+/// @details Pushing and popping spin on the other side's cursor before falling back to a futex
+/// wait, so that no system call is made while both sides keep up with each other. The wait is
+/// timed, so that they fail rather than block forever once the other side stops. Each ring must
+/// only be pushed to by one thread and popped from by one thread.
+namespace Kinoko::Host::Channel {
+
+[[nodiscard]] bool IsSupported();
+[[nodiscard]] KinokoChannel *Open(const char *name);
+void Close(KinokoChannel *channel);
+
+void Init(KinokoChannel &channel, const KinokoRaceParams &race);
+void SetStatus(KinokoChannel &channel, KinokoChannelStatus status);
+[[nodiscard]] KinokoChannelStatus GetStatus(const KinokoChannel &channel);
+
+[[nodiscard]] bool PushInput(KinokoChannel &channel, const KinokoChannelInput &input);
+[[nodiscard]] std::optional<KinokoChannelInput> PopInput(KinokoChannel &channel);
+[[nodiscard]] bool PushState(KinokoChannel &channel, const KinokoKartState &state);
+[[nodiscard]] std::optional<KinokoKartState> PopState(KinokoChannel &channel);
+
+} // namespace Kinoko::Host::Channel
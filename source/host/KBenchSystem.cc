@@ -0,0 +1,501 @@
+#include "KBenchSystem.hh"
+
+#include "host/Context.hh"
+#include "host/Option.hh"
+#include "host/SceneCreatorDynamic.hh"
+
+#include <abstract/ArchiveCache.hh>
+#include <abstract/File.hh>
+
+#include <egg/util/Stream.hh>
+
+#include <game/kart/KartObjectManager.hh>
+
+#include <game/system/RaceManager.hh>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <string>
+#include <thread>
+
+namespace Kinoko {
+
+/// @brief The timings of every repetition of one measurement.
+struct Measurement {
+    std::string name;
+    std::string unit;              ///< What one operation is, such as a lookup or a frame.
+    f64 operations;                ///< The number of operations in each repetition.
+    std::vector<f64> repetitionUs; ///< The time taken by each timed repetition.
+};
+
+/// @brief Summarizes the repetitions of a measurement.
+struct MeasurementStats {
+    f64 meanUs;
+    f64 stddevUs; ///< The sample standard deviation, which is zero for a single repetition.
+    f64 minUs;
+    f64 maxUs;
+    f64 medianUs;
+};
+
+/// @brief Every measurement taken so far, in the order they were taken.
+/// @details This is kept outside of the heap, so that restoring a context doesn't revert it.
+static std::vector<Measurement> s_measurements;
+
+/// @brief Computes the mean, spread and median of a measurement's repetitions.
+static MeasurementStats GetMeasurementStats(const Measurement &measurement) {
+    std::vector<f64> sorted = measurement.repetitionUs;
+    std::sort(sorted.begin(), sorted.end());
+
+    f64 count = static_cast<f64>(sorted.size());
+    f64 mean = std::accumulate(sorted.begin(), sorted.end(), 0.0) / count;
+
+    f64 sqDeviations = 0.0;
+    for (f64 us : sorted) {
+        sqDeviations += (us - mean) * (us - mean);
+    }
+
+    size_t half = sorted.size() / 2;
+    f64 median = sorted.size() % 2 == 0 ? 0.5 * (sorted[half - 1] + sorted[half]) : sorted[half];
+    f64 stddev = sorted.size() > 1 ? std::sqrt(sqDeviations / (count - 1.0)) : 0.0;
+
+    return {mean, stddev, sorted.front(), sorted.back(), median};
+}
+
+/// @brief Writes a string as a JSON string literal, escaping it as needed.
+static void WriteJsonString(FILE *file, const char *str) {
+    fputc('"', file);
+    for (; *str != '\0'; ++str) {
+        unsigned char c = static_cast<unsigned char>(*str);
+        if (c == '"' || c == '\\') {
+            fprintf(file, "\\%c", c);
+        } else if (c < 0x20) {
+            fprintf(file, "\\u%04x", c);
+        } else {
+            fputc(c, file);
+        }
+    }
+    fputc('"', file);
+}
+
+/// @brief Records the timings of a measurement.
+/// @return The mean time taken by a repetition in microseconds.
+f64 KBenchSystem::addMeasurement(const char *name, const char *unit, f64 operations,
+        std::vector<f64> &&repetitionUs) {
+    s_measurements.push_back({name, unit, operations, std::move(repetitionUs)});
+    return GetMeasurementStats(s_measurements.back()).meanUs;
+}
+
+/// @brief Initializes the system.
+void KBenchSystem::init() {
+    ASSERT(m_rawGhost);
+
+    auto t0 = Clock::now();
+
+    auto *sceneCreator = EGG::egg_new<Host::SceneCreatorDynamic>();
+    m_sceneMgr = EGG::egg_new<EGG::SceneManager>(sceneCreator);
+
+    System::RaceConfig::RegisterInitCallback(OnInit, nullptr);
+    m_sceneMgr->changeScene(0);
+
+    m_startupUs = ElapsedUs(t0, Clock::now());
+}
+
+/// @brief Executes a frame.
+void KBenchSystem::calc() {
+    m_sceneMgr->calc();
+}
+
+/// @brief Executes a run.
+/// @details A run consists of advancing the race to the start frame and running each benchmark.
+/// Benchmarks also check that what they measure matches a reference, such as the code it replaced.
+/// @return Whether every check passed.
+bool KBenchSystem::run() {
+    for (u16 i = 0; i < m_startFrame; ++i) {
+        calc();
+    }
+
+    REPORT("Benchmarking %s from frame %d", m_ghostFileName, m_startFrame);
+
+    if (Abstract::ArchiveCache::IsEnabled()) {
+        const auto &stats = Abstract::ArchiveCache::GetStats();
+        REPORT("Startup: %.2f ms (archive cache: %u hits, %u misses)", m_startupUs / US_PER_MS,
+                stats.hits, stats.misses);
+    } else {
+        REPORT("Startup: %.2f ms (archive cache disabled)", m_startupUs / US_PER_MS);
+    }
+
+    /// @brief A group of benchmarks, and the name that --filter matches.
+    struct Bench {
+        const char *name;
+        void (*run)(KBenchSystem &system);
+    };
+
+    // The last ones replace the race scene, so they must come last
+    static constexpr std::array<Bench, 22> BENCHES = {{
+            {"context",
+                    [](KBenchSystem &system) {
+                        system.benchContext(false);
+                        system.benchContext(true);
+                    }},
+            {"branch",
+                    [](KBenchSystem &system) {
+                        system.benchBranch(1);
+                        system.benchBranch(std::max<u32>(std::thread::hardware_concurrency(), 1));
+                    }},
+            {"rewind", [](KBenchSystem &system) { system.benchRewind(); }},
+            {"searchBlock", [](KBenchSystem &system) { system.benchSearchBlock(); }},
+            {"courseCollision", [](KBenchSystem &system) { system.benchCourseCollision(); }},
+            {"narrowScope", [](KBenchSystem &system) { system.benchNarrowScope(); }},
+            {"archiveCache", [](KBenchSystem &system) { system.benchArchiveCache(); }},
+            {"decodeSZS", [](KBenchSystem &system) { system.benchDecodeSZS(); }},
+            {"pathLookup", [](KBenchSystem &system) { system.benchPathLookup(); }},
+            {"headless", [](KBenchSystem &system) { system.benchHeadless(); }},
+            {"convexHull", [](KBenchSystem &system) { system.benchConvexHull(); }},
+            {"objectCollision", [](KBenchSystem &system) { system.benchObjectCollision(); }},
+            {"areaLookup", [](KBenchSystem &system) { system.benchAreaLookup(); }},
+            {"sectorSearch", [](KBenchSystem &system) { system.benchSectorSearch(); }},
+            {"frsqrt", [](KBenchSystem &system) { system.benchFrsqrt(); }},
+            {"expHeap", [](KBenchSystem &system) { system.benchExpHeap(); }},
+            {"channel", [](KBenchSystem &system) { system.benchChannel(); }},
+            {"ghostTimeline", [](KBenchSystem &system) { system.benchGhostTimeline(); }},
+            {"allocationTrace", [](KBenchSystem &system) { system.benchAllocationTrace(); }},
+            {"sceneCreation", [](KBenchSystem &system) { system.benchSceneCreation(); }},
+            {"arenas", [](KBenchSystem &system) { system.benchArenas(); }},
+            {"threads", [](KBenchSystem &system) { system.benchThreads(); }},
+    }};
+
+    u32 benchCount = 0;
+    for (const auto &bench : BENCHES) {
+        if (m_filter && !strstr(bench.name, m_filter)) {
+            continue;
+        }
+
+        bench.run(*this);
+        ++benchCount;
+    }
+
+    if (benchCount == 0) {
+        WARN("No benchmark matches the filter %s", m_filter);
+        return false;
+    }
+
+    if (m_jsonPath) {
+        writeJson();
+    }
+
+    if (m_failedChecks > 0) {
+        WARN("%u checks failed", m_failedChecks);
+        return false;
+    }
+
+    return true;
+}
+
+/// @brief Parses non-generic command line options.
+/// @details Bench mode requires a ghost, and optionally accepts the frame to start measuring at,
+/// the number of warmup and timed repetitions of each measurement, a path to write them to, and
+/// part of the name of the benchmarks to run.
+/// @param argc The number of arguments.
+/// @param argv The arguments.
+void KBenchSystem::parseOptions(int argc, char **argv) {
+    if (argc < 2) {
+        PANIC("Expected ghost argument!");
+    }
+
+    for (int i = 0; i < argc; ++i) {
+        std::optional<Host::EOption> flag = Host::Option::CheckFlag(argv[i]);
+        if (!flag || *flag == Host::EOption::Invalid) {
+            WARN("Expected a flag! Got: %s", argv[i]);
+            continue;
+        }
+
+        switch (*flag) {
+        case Host::EOption::Ghost: {
+            ASSERT(i + 1 < argc);
+
+            size_t size;
+            m_ghostFileName = argv[++i];
+            m_rawGhost = Abstract::File::Load(m_ghostFileName, size);
+
+            if (size < System::RKG_HEADER_SIZE || size > sizeof(System::RawGhostFile)) {
+                PANIC("File cannot be a ghost! Check the file size.");
+            }
+
+            // Creating the raw ghost file validates it
+            [[maybe_unused]] System::RawGhostFile file = System::RawGhostFile(m_rawGhost);
+        } break;
+        case Host::EOption::TargetFrame: {
+            ASSERT(i + 1 < argc);
+
+            int frame = atoi(argv[++i]);
+            if (frame < 0 || frame > std::numeric_limits<u16>::max()) {
+                PANIC("Start frame is out of bounds (expected 0-65535), got %d", frame);
+            }
+
+            m_startFrame = static_cast<u16>(frame);
+        } break;
+        case Host::EOption::Json:
+            ASSERT(i + 1 < argc);
+            m_jsonPath = argv[++i];
+            break;
+        case Host::EOption::Warmup: {
+            ASSERT(i + 1 < argc);
+
+            int warmup = atoi(argv[++i]);
+            if (warmup < 0) {
+                PANIC("Warmup is out of bounds (expected 0 or more), got %d", warmup);
+            }
+
+            m_warmup = static_cast<u32>(warmup);
+        } break;
+        case Host::EOption::Repetitions: {
+            ASSERT(i + 1 < argc);
+
+            int repetitions = atoi(argv[++i]);
+            if (repetitions < 1) {
+                PANIC("Repetitions are out of bounds (expected 1 or more), got %d", repetitions);
+            }
+
+            m_repetitions = static_cast<u32>(repetitions);
+        } break;
+        case Host::EOption::Filter:
+            ASSERT(i + 1 < argc);
+            m_filter = argv[++i];
+            break;
+        case Host::EOption::Invalid:
+        default:
+            PANIC("Invalid flag!");
+            break;
+        }
+    }
+
+    if (!m_rawGhost) {
+        PANIC("Missing ghost argument!");
+    }
+}
+
+KBenchSystem *KBenchSystem::CreateInstance() {
+    ASSERT(!s_instance);
+    s_instance = EGG::egg_new<KBenchSystem>();
+    return static_cast<KBenchSystem *>(s_instance);
+}
+
+void KBenchSystem::DestroyInstance() {
+    ASSERT(s_instance);
+    auto *instance = s_instance;
+    s_instance = nullptr;
+    EGG::egg_delete(instance);
+}
+
+KBenchSystem::KBenchSystem()
+    : m_sceneMgr(nullptr), m_ghostFileName(nullptr), m_rawGhost(nullptr), m_startFrame(600),
+      m_startupUs(0.0), m_jsonPath(nullptr), m_warmup(1), m_repetitions(5), m_filter(nullptr),
+      m_failedChecks(0) {}
+
+KBenchSystem::~KBenchSystem() {
+    if (s_instance) {
+        s_instance = nullptr;
+        WARN("KBenchSystem instance not explicitly handled!");
+    }
+
+    EGG::egg_delete(m_sceneMgr);
+    EGG::egg_free(const_cast<u8 *>(m_rawGhost));
+}
+
+/// @brief Simulates frames and records the player's position after each of them.
+/// @details The race is restored to its current state afterwards.
+/// @param frameCount The number of frames to simulate.
+std::vector<EGG::Vector3f> KBenchSystem::recordKartPositions(u16 frameCount) {
+    Host::Context base;
+
+    std::vector<EGG::Vector3f> positions;
+    positions.reserve(frameCount);
+    for (u16 i = 0; i < frameCount; ++i) {
+        calc();
+        positions.push_back(Kart::KartObjectManager::Instance()->object(0)->pos());
+    }
+
+    Host::Context::SetActiveContext(base);
+    return positions;
+}
+
+/// @brief Writes every measurement to the JSON file passed with --json.
+/// @details Times are given in nanoseconds per operation, so that measurements of different sizes
+/// can be compared, along with the time taken by every timed repetition in microseconds.
+void KBenchSystem::writeJson() const {
+    FILE *file = fopen(m_jsonPath, "w");
+    if (!file) {
+        WARN("Failed to open %s to write the benchmark report", m_jsonPath);
+        return;
+    }
+
+    // JSON has no representation of infinities and NaNs
+    auto writeNumber = [file](f64 value) {
+        if (std::isfinite(value)) {
+            fprintf(file, "%.9g", value);
+        } else {
+            fputs("null", file);
+        }
+    };
+
+    auto course = System::RaceConfig::Instance()->raceScenario().course;
+
+    fputs("{\n  \"ghost\": ", file);
+    WriteJsonString(file, m_ghostFileName);
+    fputs(",\n  \"course\": ", file);
+    WriteJsonString(file, COURSE_NAMES[static_cast<s32>(course)]);
+    fprintf(file, ",\n  \"startFrame\": %u,\n  \"warmup\": %u,\n  \"repetitions\": %u,\n",
+            m_startFrame, m_warmup, m_repetitions);
+    fprintf(file, "  \"threadLocal\": %s,\n", THREAD_LOCAL_STATICS ? "true" : "false");
+    fputs("  \"measurements\": [", file);
+
+    for (size_t i = 0; i < s_measurements.size(); ++i) {
+        const Measurement &measurement = s_measurements[i];
+        MeasurementStats stats = GetMeasurementStats(measurement);
+        f64 nsPerUs = NS_PER_US / measurement.operations;
+
+        fputs(i == 0 ? "\n    {\"name\": " : ",\n    {\"name\": ", file);
+        WriteJsonString(file, measurement.name.c_str());
+        fputs(", \"unit\": ", file);
+        WriteJsonString(file, measurement.unit.c_str());
+        fputs(", \"operations\": ", file);
+        writeNumber(measurement.operations);
+        fputs(",\n     \"meanNs\": ", file);
+        writeNumber(stats.meanUs * nsPerUs);
+        fputs(", \"stddevNs\": ", file);
+        writeNumber(stats.stddevUs * nsPerUs);
+        fputs(", \"minNs\": ", file);
+        writeNumber(stats.minUs * nsPerUs);
+        fputs(", \"maxNs\": ", file);
+        writeNumber(stats.maxUs * nsPerUs);
+        fputs(", \"medianNs\": ", file);
+        writeNumber(stats.medianUs * nsPerUs);
+        fputs(", \"perSecond\": ", file);
+        writeNumber(US_PER_SECOND * measurement.operations / stats.meanUs);
+        fputs(",\n     \"repetitionUs\": [", file);
+        for (size_t j = 0; j < measurement.repetitionUs.size(); ++j) {
+            fputs(j == 0 ? "" : ", ", file);
+            writeNumber(measurement.repetitionUs[j]);
+        }
+        fputs("]}", file);
+    }
+
+    fputs("\n  ]\n}\n", file);
+
+    if (fclose(file) != 0) {
+        WARN("Failed to write the benchmark report to %s", m_jsonPath);
+        return;
+    }
+
+    REPORT("Wrote %zu measurements to %s", s_measurements.size(), m_jsonPath);
+}
+
+/// @brief Initializes the race configuration as needed for benchmarks.
+/// @param config The race configuration instance.
+/// @param arg Unused optional argument.
+void KBenchSystem::OnInit(System::RaceConfig *config, void * /* arg */) {
+    config->setGhost(Instance()->m_rawGhost);
+    config->raceScenario().players[0].type = System::RaceConfig::Player::Type::Ghost;
+}
+
+/// @brief Captures the player's state in the race that is active on the calling thread.
+KBenchSystem::KrkgFrame KBenchSystem::CaptureKrkgFrame() {
+    const auto *object = Kart::KartObjectManager::Instance()->object(0);
+    const auto &player = System::RaceManager::Instance()->player();
+
+    return {object->pos(), object->fullRot(), object->extVel(), object->intVel(), object->speed(),
+            object->acceleration(), object->softSpeedLimit(), object->mainRot(),
+            object->angVel2(), player.raceCompletion(), player.checkpointId(), player.jugemId()};
+}
+
+/// @brief Reads an entire file outside of the game heap.
+std::vector<u8> KBenchSystem::ReadFile(const char *path) {
+    std::ifstream stream(path, std::ios::binary | std::ios::ate);
+    if (!stream) {
+        PANIC("File with provided path %s was not loaded correctly!", path);
+    }
+
+    std::vector<u8> buffer(static_cast<size_t>(stream.tellg()));
+    stream.seekg(0, std::ios::beg);
+    stream.read(reinterpret_cast<char *>(buffer.data()), buffer.size());
+    return buffer;
+}
+
+/// @brief Reads every frame of a KRKG file, as KTestSystem checks them.
+/// @details The first entry is the state before the race is calculated. KRKG files older than the
+/// version that records checkpoints don't have every field of a KrkgFrame, so they are not read.
+/// @return The entries of the file, or nothing if it doesn't exist or isn't supported.
+std::vector<KBenchSystem::KrkgFrame> KBenchSystem::ReadKrkg(const char *path) {
+    constexpr u32 KRKG_SIGNATURE = 0x4b524b47; // KRKG
+    constexpr u16 ADDED_CHECKPOINTS_VERSION = 6;
+    constexpr size_t HEADER_SIZE = 0x10;
+
+    if (!std::filesystem::exists(path)) {
+        return {};
+    }
+
+    std::vector<u8> file = ReadFile(path);
+    if (file.size() < HEADER_SIZE) {
+        WARN("%s is too small to be a KRKG file", path);
+        return {};
+    }
+
+    EGG::RamStream stream(file.data(), static_cast<u32>(file.size()));
+    u16 mark = *reinterpret_cast<const u16 *>(file.data() + sizeof(u32));
+    stream.setEndian(parse<u16>(mark) == 0xfeff ? std::endian::big : std::endian::little);
+
+    if (stream.read_u32() != KRKG_SIGNATURE) {
+        WARN("%s is not a KRKG file", path);
+        return {};
+    }
+
+    stream.skip(2);
+    // The frame count doesn't include the state before the race is calculated
+    u32 entryCount = stream.read_u16() + 1u;
+    stream.skip(2);
+    u16 versionMinor = stream.read_u16();
+    u32 dataOffset = stream.read_u32();
+
+    if (versionMinor < ADDED_CHECKPOINTS_VERSION) {
+        WARN("%s is a KRKG file version that doesn't record checkpoints", path);
+        return {};
+    }
+
+    constexpr size_t FRAME_SIZE = sizeof(f32) * 24 + sizeof(u16) + sizeof(u8) * 2;
+    if (dataOffset > file.size() || (file.size() - dataOffset) / FRAME_SIZE < entryCount) {
+        WARN("%s is missing frames", path);
+        return {};
+    }
+
+    stream.jump(dataOffset);
+
+    std::vector<KrkgFrame> frames(entryCount);
+    for (auto &frame : frames) {
+        frame.pos.read(stream);
+        frame.fullRot.read(stream);
+        frame.extVel.read(stream);
+        frame.intVel.read(stream);
+        frame.speed = stream.read_f32();
+        frame.acceleration = stream.read_f32();
+        frame.softSpeedLimit = stream.read_f32();
+        frame.mainRot.read(stream);
+        frame.angVel2.read(stream);
+        frame.raceCompletion = stream.read_f32();
+        frame.checkpointId = stream.read_u16();
+        frame.jugemId = static_cast<s8>(stream.read_u8());
+        stream.skip(1);
+    }
+
+    return frames;
+}
+
+volatile uintptr_t KBenchSystem::s_sink;
+
+} // namespace Kinoko
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "host/KSystem.hh"
+
+#include <egg/core/SceneManager.hh>
+#include <egg/math/Quat.hh>
+#include <egg/math/Vector.hh>
+
+#include <game/system/RaceConfig.hh>
+
+#include <chrono>
+#include <vector>
+
+namespace Kinoko {
+
+/// @brief Kinoko system designed to benchmark engine hot paths on real course data.
+/// @details The race is configured from a ghost, which selects the course and drives the player.
+/// The ghost is replayed up to a start frame, so that measurements are taken mid-race. Each group
+/// of benchmarks is defined in its own file under host/bench.
+class KBenchSystem final : public KSystem {
+public:
+    void init() override;
+    void calc() override;
+    bool run() override;
+    void parseOptions(int argc, char **argv) override;
+
+    static KBenchSystem *CreateInstance();
+    static void DestroyInstance();
+
+    static KBenchSystem *Instance() {
+        return static_cast<KBenchSystem *>(s_instance);
+    }
+
+private:
+    EGG_NEW_DELETE_FRIEND
+
+    KBenchSystem();
+    ~KBenchSystem() override;
+
+    KBenchSystem(const KBenchSystem &) = delete;
+    KBenchSystem(KBenchSystem &&) = delete;
+
+    typedef std::chrono::steady_clock Clock;
+
+    /// @brief The player's state on a frame, with every field that a KRKG file records.
+    struct KrkgFrame {
+        EGG::Vector3f pos;
+        EGG::Quatf fullRot;
+        EGG::Vector3f extVel;
+        EGG::Vector3f intVel;
+        f32 speed;
+        f32 acceleration;
+        f32 softSpeedLimit;
+        EGG::Quatf mainRot;
+        EGG::Vector3f angVel2;
+        f32 raceCompletion;
+        u16 checkpointId;
+        s8 jugemId;
+
+        bool operator==(const KrkgFrame &rhs) const = default;
+    };
+
+    void benchContext(bool incremental);
+    void benchBranch(u32 maxConcurrent);
+    void benchRewind();
+    void benchSearchBlock();
+    void benchCourseCollision();
+    void benchNarrowScope();
+    void benchArchiveCache();
+    void benchDecodeSZS();
+    void benchPathLookup();
+    void benchHeadless();
+    void benchConvexHull();
+    void benchObjectCollision();
+    void benchAreaLookup();
+    void benchSectorSearch();
+    void benchFrsqrt();
+    void benchExpHeap();
+    void benchChannel();
+    void benchGhostTimeline();
+    void benchAllocationTrace();
+    void benchSceneCreation();
+    void benchArenas();
+    void benchThreads();
+
+    template <typename F>
+    f64 measure(const char *name, const char *unit, f64 operations, F &&repetition);
+    f64 addMeasurement(const char *name, const char *unit, f64 operations,
+            std::vector<f64> &&repetitionUs);
+    void writeJson() const;
+
+    [[nodiscard]] std::vector<EGG::Vector3f> recordKartPositions(u16 frameCount);
+
+    static void OnInit(System::RaceConfig *config, void *arg);
+    [[nodiscard]] static KrkgFrame CaptureKrkgFrame();
+    [[nodiscard]] static std::vector<u8> ReadFile(const char *path);
+    [[nodiscard]] static std::vector<KrkgFrame> ReadKrkg(const char *path);
+
+    /// @brief Gets the elapsed time between two time points in microseconds.
+    [[nodiscard]] static f64 ElapsedUs(Clock::time_point start, Clock::time_point end) {
+        return std::chrono::duration<f64, std::micro>(end - start).count();
+    }
+
+    static constexpr f64 NS_PER_US = 1000.0;
+    static constexpr f64 US_PER_MS = 1000.0;
+    static constexpr f64 US_PER_SECOND = 1000000.0;
+
+    EGG::SceneManager *m_sceneMgr;
+    const char *m_ghostFileName;
+    const u8 *m_rawGhost;
+    u16 m_startFrame;       ///< The number of frames to simulate before measuring.
+    f64 m_startupUs;        ///< The time taken to create the race scene, including archive loads.
+    const char *m_jsonPath; ///< Where to write every measurement, or nullptr to only report them.
+    u32 m_warmup;           ///< The number of untimed repetitions before each measurement.
+    u32 m_repetitions;      ///< The number of timed repetitions of each measurement.
+    const char *m_filter;   ///< Only benchmarks whose name contains this are run, if set.
+    u32 m_failedChecks;     ///< The number of differential, sync and round trip checks failed.
+
+    /// @brief Results of measured work are folded into this, so that the work isn't optimized away.
+    static volatile uintptr_t s_sink;
+};
+
+/// @brief Runs a benchmark a number of times to warm up, and then times every repetition of it.
+/// @details A repetition either returns the time it took in microseconds, for benchmarks that
+/// leave their setup out of the measurement, or is timed as a whole.
+/// @param name The name of the measurement in the JSON report.
+/// @param unit What one operation is, such as a lookup or a frame.
+/// @param operations The number of operations in each repetition.
+/// @param repetition The work to measure.
+/// @return The mean time taken by a repetition in microseconds.
+template <typename F>
+f64 KBenchSystem::measure(const char *name, const char *unit, f64 operations, F &&repetition) {
+    auto run = [&repetition]() -> f64 {
+        if constexpr (std::is_same_v<std::invoke_result_t<F>, f64>) {
+            return repetition();
+        } else {
+            auto t0 = Clock::now();
+            repetition();
+            return ElapsedUs(t0, Clock::now());
+        }
+    };
+
+    for (u32 i = 0; i < m_warmup; ++i) {
+        run();
+    }
+
+    std::vector<f64> repetitionUs;
+    repetitionUs.reserve(m_repetitions);
+    for (u32 i = 0; i < m_repetitions; ++i) {
+        repetitionUs.push_back(run());
+    }
+
+    return addMeasurement(name, unit, operations, std::move(repetitionUs));
+}
+
+} // namespace Kinoko
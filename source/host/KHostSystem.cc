@@ -0,0 +1,179 @@
+#include "KHostSystem.hh"
+
+#include "host/HostChannel.hh"
+#include "host/KartState.hh"
+#include "host/Option.hh"
+#include "host/SceneCreatorDynamic.hh"
+
+#include <game/system/KPadDirector.hh>
+
+namespace Kinoko {
+
+/// @brief Initializes the system.
+/// @details The race is created from the parameters the agent wrote to the channel, and its start
+/// is pushed as the first state.
+void KHostSystem::init() {
+    ASSERT(m_channelName);
+
+    m_channel = Host::Channel::Open(m_channelName);
+
+    const KinokoRaceParams &race = m_channel->race;
+    if (race.course < 0 || static_cast<size_t>(race.course) >= std::size(COURSE_NAMES) ||
+            race.character < 0 || race.character >= static_cast<s32>(Character::Max) ||
+            race.vehicle < 0 || race.vehicle >= static_cast<s32>(Vehicle::Max)) {
+        PANIC("Channel %s has an invalid race (course %d, character %d, vehicle %d)",
+                m_channelName, race.course, race.character, race.vehicle);
+    }
+
+    auto *sceneCreator = EGG::egg_new<Host::SceneCreatorDynamic>();
+    m_sceneMgr = EGG::egg_new<EGG::SceneManager>(sceneCreator);
+
+    System::RaceConfig::RegisterInitCallback(OnInit, nullptr);
+    m_sceneMgr->changeScene(0);
+    System::KPadDirector::Instance()->hostController()->reset(race.driftIsAuto != 0);
+
+    m_startContext = new Host::Context();
+    m_frame = 0;
+
+    Host::Channel::SetStatus(*m_channel, KINOKO_CHANNEL_READY);
+    if (!pushState()) {
+        PANIC("Agent stopped before the start of the race on channel %s", m_channelName);
+    }
+}
+
+/// @brief Executes a frame.
+void KHostSystem::calc() {
+    m_sceneMgr->calc();
+    ++m_frame;
+}
+
+/// @brief Executes a run.
+/// @details A run consists of answering every input from the agent with the resulting state, until
+/// the agent asks to quit. Invalid inputs are still simulated, as they may be intentional. An
+/// unknown command is answered with the unchanged state before the status is set to
+/// KINOKO_CHANNEL_ERROR, so that an agent waiting on it wakes up to the error.
+/// @return Whether the run was successful or not.
+bool KHostSystem::run() {
+    auto *controller = System::KPadDirector::Instance()->hostController();
+
+    while (true) {
+        std::optional<KinokoChannelInput> input = Host::Channel::PopInput(*m_channel);
+        if (!input) {
+            WARN("Agent stopped without closing channel %s", m_channelName);
+            Host::Channel::SetStatus(*m_channel, KINOKO_CHANNEL_CLOSED);
+            return false;
+        }
+
+        switch (input->command) {
+        case KINOKO_CHANNEL_STEP:
+            controller->setInputsRawStick(input->buttons, input->stickXRaw, input->stickYRaw,
+                    static_cast<System::Trick>(input->trick));
+            calc();
+            break;
+        case KINOKO_CHANNEL_RESET:
+            Host::Context::SetActiveContext(*m_startContext);
+            m_frame = 0;
+            break;
+        case KINOKO_CHANNEL_QUIT:
+            Host::Channel::SetStatus(*m_channel, KINOKO_CHANNEL_CLOSED);
+            return true;
+        default:
+            WARN("Unknown channel command %u", input->command);
+            (void)pushState();
+            Host::Channel::SetStatus(*m_channel, KINOKO_CHANNEL_ERROR);
+            return false;
+        }
+
+        if (!pushState()) {
+            WARN("Agent stopped without closing channel %s", m_channelName);
+            Host::Channel::SetStatus(*m_channel, KINOKO_CHANNEL_CLOSED);
+            return false;
+        }
+    }
+}
+
+/// @brief Parses non-generic command line options.
+/// @details Host mode requires the name of the channel the agent created.
+/// @param argc The number of arguments.
+/// @param argv The arguments.
+void KHostSystem::parseOptions(int argc, char **argv) {
+    if (argc < 2) {
+        PANIC("Expected channel argument!");
+    }
+
+    for (int i = 0; i < argc; ++i) {
+        std::optional<Host::EOption> flag = Host::Option::CheckFlag(argv[i]);
+        if (!flag || *flag == Host::EOption::Invalid) {
+            WARN("Expected a flag! Got: %s", argv[i]);
+            continue;
+        }
+
+        switch (*flag) {
+        case Host::EOption::Channel:
+            ASSERT(i + 1 < argc);
+            m_channelName = argv[++i];
+            break;
+        case Host::EOption::Invalid:
+        default:
+            PANIC("Invalid flag!");
+            break;
+        }
+    }
+
+    if (!Host::Channel::IsSupported()) {
+        PANIC("Host mode requires POSIX shared memory, which this host doesn't support");
+    }
+}
+
+KHostSystem *KHostSystem::CreateInstance() {
+    ASSERT(!s_instance);
+    s_instance = EGG::egg_new<KHostSystem>();
+    return static_cast<KHostSystem *>(s_instance);
+}
+
+void KHostSystem::DestroyInstance() {
+    ASSERT(s_instance);
+    auto *instance = s_instance;
+    s_instance = nullptr;
+    EGG::egg_delete(instance);
+}
+
+KHostSystem::KHostSystem()
+    : m_sceneMgr(nullptr), m_startContext(nullptr), m_channelName(nullptr),
+      m_channel(nullptr), m_frame(0) {}
+
+KHostSystem::~KHostSystem() {
+    if (s_instance) {
+        s_instance = nullptr;
+        WARN("KHostSystem instance not explicitly handled!");
+    }
+
+    delete m_startContext;
+    if (m_channel) {
+        Host::Channel::Close(m_channel);
+    }
+
+    EGG::egg_delete(m_sceneMgr);
+}
+
+/// @brief Pushes the player's kart state to the agent, waiting for room if the agent is behind.
+/// @return Whether the state was pushed, or the agent stopped while it was behind.
+bool KHostSystem::pushState() {
+    KinokoKartState state;
+    Host::CaptureKartState(state, m_frame);
+    return Host::Channel::PushState(*m_channel, state);
+}
+
+/// @brief Sets up the race the agent asked for, with the player driven by the host controller.
+void KHostSystem::OnInit(System::RaceConfig *config, void * /* arg */) {
+    const KinokoRaceParams &race = Instance()->m_channel->race;
+    auto &player = config->raceScenario().players[0];
+
+    config->raceScenario().course = static_cast<Course>(race.course);
+    player.type = System::RaceConfig::Player::Type::Local;
+    player.character = static_cast<Character>(race.character);
+    player.vehicle = static_cast<Vehicle>(race.vehicle);
+    player.driftIsAuto = race.driftIsAuto != 0;
+}
+
+} // namespace Kinoko
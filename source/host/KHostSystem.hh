@@ -0,0 +1,51 @@
+#pragma once
+
+#include "host/KSystem.hh"
+
+#include <egg/core/SceneManager.hh>
+
+#include <game/system/RaceConfig.hh>
+
+#include <kinoko_channel.h>
+
+namespace Kinoko {
+
+/// @brief Kinoko system designed to be driven by an agent in another process.
+/// @details The agent creates the shared-memory channel in kinoko_channel.h, and pushes the inputs
+/// of the player's kart, which is driven through System::KPadHostController. Every frame, the
+/// kart's state is pushed back to the agent.
+class KHostSystem : public KSystem {
+public:
+    void init() override;
+    void calc() override;
+    bool run() override;
+    void parseOptions(int argc, char **argv) override;
+
+    static KHostSystem *CreateInstance();
+    static void DestroyInstance();
+
+    static KHostSystem *Instance() {
+        return static_cast<KHostSystem *>(s_instance);
+    }
+
+private:
+    EGG_NEW_DELETE_FRIEND
+
+    KHostSystem();
+    ~KHostSystem() override;
+
+    KHostSystem(const KHostSystem &) = delete;
+    KHostSystem(KHostSystem &&) = delete;
+
+    [[nodiscard]] bool pushState();
+
+    static void OnInit(System::RaceConfig *config, void *arg);
+
+    EGG::SceneManager *m_sceneMgr;
+    Host::Context *m_startContext; ///< The start of the race, restored on reset.
+    const char *m_channelName;
+    KinokoChannel *m_channel;
+    u32 m_frame; ///< Frames stepped since the race was created or last reset.
+};
+
+} // namespace Kinoko
@@ -1,30 +1,125 @@
 #include "KReplaySystem.hh"
 
+#include "host/BranchExplorer.hh"
 #include "host/Option.hh"
 #include "host/SceneCreatorDynamic.hh"
+#include "host/SceneId.hh"
 
 #include <abstract/File.hh>
 #include <egg/core/Heap.hh>
 
+#include <game/system/CourseMap.hh>
 #include <game/system/RaceManager.hh>
+#include <game/system/map/MapdataStageInfo.hh>
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iomanip>
+#include <thread>
 
 namespace Kinoko {
 
+typedef std::chrono::steady_clock Clock;
+
+/// @brief Gets the elapsed time between two time points in microseconds.
+static f64 ElapsedUs(Clock::time_point start, Clock::time_point end) {
+    return std::chrono::duration<f64, std::micro>(end - start).count();
+}
+
+/// @brief Formats a timer as MM:SS.mmm.
+static std::string FormatTimer(const System::Timer &timer) {
+    std::ostringstream oss;
+    oss << std::setw(2) << std::setfill('0') << timer.min << ":" << std::setw(2)
+        << std::setfill('0') << timer.sec << "." << std::setw(3) << std::setfill('0')
+        << timer.mil;
+    return oss.str();
+}
+
+/// @brief Quotes a CSV field, doubling any quotes within it.
+static std::string QuoteCsvField(const std::string &field) {
+    std::string quoted = "\"";
+    for (char c : field) {
+        quoted += c == '"' ? "\"\"" : std::string(1, c);
+    }
+
+    return quoted + "\"";
+}
+
+/// @brief Reads a ghost file and checks whether it can be replayed.
+/// @details The path is used as given, so it may be absolute or relative to the working directory.
+/// The buffer is always the size of a RawGhostFile, and zero past the end of the file, since
+/// uncompressed ghosts are copied whole.
+/// @param path The path of the ghost file.
+/// @param size Set to the size of the file.
+/// @param error Set to why the ghost can't be replayed, or nullptr if it can.
+/// @return The ghost, to be freed with egg_free, or nullptr if it can't be replayed.
+static u8 *LoadGhostFile(const char *path, size_t &size, const char *&error) {
+    std::error_code ec;
+    uintmax_t fileSize = std::filesystem::file_size(std::filesystem::path(path), ec);
+    if (ec) {
+        size = 0;
+        error = "Failed to open file";
+        return nullptr;
+    }
+
+    size = static_cast<size_t>(fileSize);
+    if (fileSize < System::RKG_HEADER_SIZE || fileSize > sizeof(System::RawGhostFile)) {
+        error = "Invalid file size";
+        return nullptr;
+    }
+
+    u8 *rkg = static_cast<u8 *>(EGG::egg_alloc(sizeof(System::RawGhostFile), 4));
+    memset(rkg, 0, sizeof(System::RawGhostFile));
+
+    std::ifstream stream(std::filesystem::path(path), std::ios::binary);
+    if (!stream.read(reinterpret_cast<char *>(rkg), static_cast<std::streamsize>(size))) {
+        error = "Failed to read file";
+    } else {
+        error = System::RawGhostFile::FindError(rkg, size);
+    }
+
+    if (error) {
+        EGG::egg_free(rkg);
+        return nullptr;
+    }
+
+    return rkg;
+}
+
 /// @brief Initializes the system.
 void KReplaySystem::init() {
-    ASSERT(m_currentGhostFileName);
-    ASSERT(m_currentRawGhost);
-    ASSERT(m_currentGhost);
+    if (m_batch.empty()) {
+        ASSERT(m_currentGhostFileName);
+        ASSERT(m_currentRawGhost);
+        ASSERT(m_currentGhost);
+    }
 
     auto *sceneCreator = EGG::egg_new<Host::SceneCreatorDynamic>();
     m_sceneMgr = EGG::egg_new<EGG::SceneManager>(sceneCreator);
 
     System::RaceConfig::RegisterInitCallback(OnInit, nullptr);
-    Abstract::File::Remove("results.txt");
 
+    if (m_batch.empty()) {
+        Abstract::File::Remove("results.txt");
+    } else {
+        constexpr std::string_view CSV_HEADER =
+                "ghost,course,expected,observed,status,desync_lap,wall_ms\n";
+
+        Abstract::File::Remove(m_csvPath);
+        Abstract::File::Append(m_csvPath, CSV_HEADER.data(), CSV_HEADER.size());
+    }
+
+    // A batch without a ghost that can be replayed has no race to create
+    if (!m_currentGhost) {
+        return;
+    }
+
+    auto t0 = Clock::now();
     m_sceneMgr->changeScene(0);
+    m_sceneUs = ElapsedUs(t0, Clock::now());
 }
 
 /// @brief Executes a frame.
@@ -33,9 +128,21 @@ void KReplaySystem::calc() {
 }
 
 /// @brief Executes a run.
-/// @details A run consists of replaying a ghost.
+/// @details A run consists of replaying a ghost, or every ghost of a batch.
 /// @return Whether the run was successful or not.
 bool KReplaySystem::run() {
+    if (!m_batch.empty()) {
+        if (m_jobCount > 1 && m_currentGhost) {
+            if (Host::BranchExplorer::IsSupported()) {
+                return runBatchParallel();
+            }
+
+            WARN("Parallel replays are not supported on this host. Running sequentially");
+        }
+
+        return runBatch();
+    }
+
     while (!calcEnd()) {
         calc();
     }
@@ -44,12 +151,13 @@ bool KReplaySystem::run() {
 }
 
 /// @brief Parses non-generic command line options.
-/// @details The only currently accepted option is the ghost flag.
+/// @details Replay mode accepts either a single ghost, or a batch of ghosts along with the path of
+/// the CSV file to write and the number of worker processes.
 /// @param argc The number of arguments.
 /// @param argv The arguments.
 void KReplaySystem::parseOptions(int argc, char **argv) {
     if (argc < 2) {
-        PANIC("Expected ghost argument!");
+        PANIC("Expected ghost or batch argument!");
     }
 
     for (int i = 0; i < argc; ++i) {
@@ -60,22 +168,33 @@ void KReplaySystem::parseOptions(int argc, char **argv) {
         }
 
         switch (*flag) {
-        case Host::EOption::Ghost: {
+        case Host::EOption::Ghost:
             ASSERT(i + 1 < argc);
+            if (m_currentRawGhost) {
+                PANIC("Ghost was already set!");
+            }
 
-            m_currentGhostFileName = argv[++i];
-            m_currentRawGhost = Abstract::File::Load(m_currentGhostFileName, m_currentRawGhostSize);
+            loadGhost(argv[++i]);
+            break;
+        case Host::EOption::Batch:
+            ASSERT(i + 1 < argc);
+            parseBatch(argv[++i]);
+            break;
+        case Host::EOption::Csv:
+            ASSERT(i + 1 < argc);
+            m_csvPath = argv[++i];
+            break;
+        case Host::EOption::Jobs: {
+            ASSERT(i + 1 < argc);
 
-            if (m_currentRawGhostSize < System::RKG_HEADER_SIZE ||
-                    m_currentRawGhostSize > sizeof(System::RawGhostFile)) {
-                PANIC("File cannot be a ghost! Check the file size.");
+            int jobs = atoi(argv[++i]);
+            if (jobs < 0) {
+                PANIC("Job count is out of bounds (expected 0 or more), got %d", jobs);
             }
 
-            // Creating the raw ghost file validates it
-            System::RawGhostFile file = System::RawGhostFile(m_currentRawGhost);
-
-            m_currentGhost = EGG::egg_new<System::GhostFile>(file);
-            ASSERT(m_currentGhost);
+            // 0 uses every hardware thread
+            m_jobCount = jobs > 0 ? static_cast<u32>(jobs) :
+                                    std::max<u32>(std::thread::hardware_concurrency(), 1);
         } break;
         case Host::EOption::Invalid:
         default:
@@ -83,6 +202,28 @@ void KReplaySystem::parseOptions(int argc, char **argv) {
             break;
         }
     }
+
+    if (!m_batch.empty()) {
+        if (m_currentRawGhost) {
+            PANIC("A single ghost cannot be replayed along with a batch!");
+        }
+
+        // Ghosts on the same course are replayed back to back, and invalid ghosts go last
+        std::stable_sort(m_batch.begin(), m_batch.end(),
+                [](const BatchGhost &lhs, const BatchGhost &rhs) {
+                    if (!lhs.error != !rhs.error) {
+                        return !lhs.error;
+                    }
+
+                    return !lhs.error && lhs.course < rhs.course;
+                });
+
+        if (!m_batch[0].error) {
+            loadGhost(m_batch[0].path.c_str());
+        }
+    } else if (!m_currentRawGhost) {
+        PANIC("Missing ghost or batch argument!");
+    }
 }
 
 KReplaySystem *KReplaySystem::CreateInstance() {
@@ -100,7 +241,7 @@ void KReplaySystem::DestroyInstance() {
 
 KReplaySystem::KReplaySystem()
     : m_currentGhostFileName(nullptr), m_currentGhost(nullptr), m_currentRawGhost(nullptr),
-      m_currentRawGhostSize(0) {}
+      m_currentRawGhostSize(0), m_csvPath("results.csv"), m_jobCount(1), m_sceneUs(0.0) {}
 
 KReplaySystem::~KReplaySystem() {
     if (s_instance) {
@@ -113,6 +254,235 @@ KReplaySystem::~KReplaySystem() {
     EGG::egg_free(const_cast<u8 *>(m_currentRawGhost));
 }
 
+/// @brief Loads a ghost to replay, replacing the current one.
+/// @param path The path of the ghost file.
+void KReplaySystem::loadGhost(const char *path) {
+    EGG::egg_delete(m_currentGhost);
+    EGG::egg_free(const_cast<u8 *>(m_currentRawGhost));
+
+    const char *error;
+    m_currentGhostFileName = path;
+    m_currentRawGhost = LoadGhostFile(m_currentGhostFileName, m_currentRawGhostSize, error);
+    if (!m_currentRawGhost) {
+        PANIC("%s cannot be replayed: %s", path, error);
+    }
+
+    System::RawGhostFile file = System::RawGhostFile(m_currentRawGhost);
+
+    m_currentGhost = EGG::egg_new<System::GhostFile>(file);
+    ASSERT(m_currentGhost);
+}
+
+/// @brief Adds every ghost in a directory or manifest to the batch.
+/// @details A directory contributes every .rkg file directly within it, in path order. A manifest
+/// lists one path per line, relative to the working directory, skipping blank lines and lines
+/// starting with '#'. Every ghost is validated now. Those which can't be replayed are reported and
+/// given a row with an error status, rather than stopping the batch.
+/// @param path The path of the directory or manifest.
+void KReplaySystem::parseBatch(const char *path) {
+    std::vector<std::string> paths;
+
+    if (std::filesystem::is_directory(path)) {
+        for (const auto &entry : std::filesystem::directory_iterator(path)) {
+            std::string extension = entry.path().extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(),
+                    [](unsigned char c) { return std::tolower(c); });
+
+            if (entry.is_regular_file() && extension == ".rkg") {
+                paths.push_back(entry.path().string());
+            }
+        }
+
+        std::sort(paths.begin(), paths.end());
+    } else {
+        std::ifstream stream(path);
+        if (!stream) {
+            PANIC("Batch with provided path %s was not loaded correctly!", path);
+        }
+
+        for (std::string line; std::getline(stream, line);) {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+
+            if (!line.empty() && line[0] != '#') {
+                paths.push_back(line);
+            }
+        }
+    }
+
+    for (const auto &ghostPath : paths) {
+        size_t size;
+        const char *error;
+        u8 *rawGhost = LoadGhostFile(ghostPath.c_str(), size, error);
+        if (!rawGhost) {
+            WARN("%s cannot be replayed: %s", ghostPath.c_str(), error);
+            m_batch.emplace_back(ghostPath, Course::Mario_Circuit, System::Timer(), error);
+            continue;
+        }
+
+        System::GhostFile ghost = System::GhostFile(System::RawGhostFile(rawGhost));
+        m_batch.emplace_back(ghostPath, ghost.course(), ghost.raceTimer(), nullptr);
+        EGG::egg_free(rawGhost);
+    }
+
+    if (paths.empty()) {
+        WARN("Batch %s has no ghosts", path);
+    }
+}
+
+/// @brief Replays every ghost of the batch in turn, writing a CSV row for each of them.
+/// @details Each ghost gets its own race scene, the same way KTestSystem moves to its next test
+/// case, while the system, its heaps and the archive cache are kept.
+/// @return Whether every ghost finished in sync.
+bool KReplaySystem::runBatch() {
+    u32 syncCount = 0;
+
+    for (size_t i = 0; i < m_batch.size(); ++i) {
+        std::string row;
+        if (m_batch[i].error) {
+            row = formatCsvRow(m_batch[i], "", "error", 0, 0.0);
+            Abstract::File::Append(m_csvPath, row.c_str(), row.size());
+            continue;
+        }
+
+        if (i > 0) {
+            startBatchGhost(i);
+        }
+
+        syncCount += replayBatchGhost(i, row);
+        Abstract::File::Append(m_csvPath, row.c_str(), row.size());
+    }
+
+    REPORT("Replayed %zu ghosts: %u in sync, %zu not (see %s)", m_batch.size(), syncCount,
+            m_batch.size() - syncCount, m_csvPath);
+    return syncCount == m_batch.size();
+}
+
+/// @brief Replays every ghost of the batch across a pool of worker processes.
+/// @details Each worker is forked from the first ghost's race scene, and moves on to its own ghost
+/// the same way runBatch() does. Rows are written in the same order as a sequential run. A ghost
+/// which can't be replayed, or whose worker fails to report, is given a row with an error status.
+/// @return Whether every ghost finished in sync.
+bool KReplaySystem::runBatchParallel() {
+    struct Result {
+        Host::BranchExplorer::Payload payload; ///< Whether the ghost synced, then its CSV row.
+        bool finished;
+        bool success;
+    };
+
+    const u32 ghostCount = static_cast<u32>(m_batch.size());
+    std::vector<Result> results(ghostCount, {{}, false, false});
+    u32 nextResult = 0;
+    u32 syncCount = 0;
+
+    auto onResult = [&](u32 id, bool finished, const Host::BranchExplorer::Payload &payload) {
+        results[id].finished = true;
+        results[id].success = finished && !payload.empty();
+        results[id].payload = payload;
+
+        for (; nextResult < ghostCount && results[nextResult].finished; ++nextResult) {
+            const Result &result = results[nextResult];
+
+            std::string row;
+            if (result.success) {
+                syncCount += result.payload[0] != 0;
+                row.assign(result.payload.begin() + 1, result.payload.end());
+            } else {
+                row = formatCsvRow(m_batch[nextResult], "", "error", 0, 0.0);
+            }
+
+            Abstract::File::Append(m_csvPath, row.c_str(), row.size());
+        }
+    };
+
+    auto runWorker = [this](u32 id, Host::BranchExplorer::Payload &payload) {
+        if (id > 0) {
+            startBatchGhost(id);
+        }
+
+        std::string row;
+        payload.push_back(replayBatchGhost(id, row) ? 1 : 0);
+        payload.insert(payload.end(), row.begin(), row.end());
+    };
+
+    Host::BranchExplorer explorer(onResult, m_jobCount);
+    for (u32 i = 0; i < ghostCount; ++i) {
+        if (m_batch[i].error) {
+            onResult(i, false, {});
+        } else {
+            explorer.spawn(i, runWorker);
+        }
+    }
+
+    explorer.wait();
+
+    REPORT("Replayed %u ghosts: %u in sync, %u not (see %s)", ghostCount, syncCount,
+            ghostCount - syncCount, m_csvPath);
+    return syncCount == ghostCount;
+}
+
+/// @brief Replaces the race scene with one for a ghost of the batch.
+/// @param idx The index of the ghost in the batch.
+void KReplaySystem::startBatchGhost(size_t idx) {
+    auto t0 = Clock::now();
+
+    m_sceneMgr->destroyScene(m_sceneMgr->currentScene());
+    loadGhost(m_batch[idx].path.c_str());
+    m_sceneMgr->createScene(static_cast<int>(Host::SceneId::Race), m_sceneMgr->currentScene());
+
+    m_sceneUs = ElapsedUs(t0, Clock::now());
+}
+
+/// @brief Replays the current ghost of the batch to the end.
+/// @param idx The index of the ghost in the batch.
+/// @param row Set to the ghost's CSV row.
+/// @return Whether the ghost finished in sync.
+bool KReplaySystem::replayBatchGhost(size_t idx, std::string &row) {
+    auto t0 = Clock::now();
+    while (!calcEnd()) {
+        calc();
+    }
+    f64 wallUs = m_sceneUs + ElapsedUs(t0, Clock::now());
+
+    const auto *raceManager = System::RaceManager::Instance();
+    if (raceManager->stage() != System::RaceManager::Stage::FinishGlobal) {
+        row = formatCsvRow(m_batch[idx], "", "unfinished", getDesyncingLap(), wallUs);
+        return false;
+    }
+
+    bool synced = getDesyncingTimerIdx() == -1;
+    std::string observed = FormatTimer(raceManager->player().raceTimer());
+    row = formatCsvRow(m_batch[idx], observed.c_str(), synced ? "ok" : "desync", getDesyncingLap(),
+            wallUs);
+    return synced;
+}
+
+/// @brief Formats a CSV row of the batch.
+/// @param ghost The ghost the row is for.
+/// @param observed The observed finishing time, or an empty string if the race didn't finish.
+/// @param status One of ok, desync, unfinished or error.
+/// @param desyncingLap The first lap whose split doesn't match the ghost, or 0 if none.
+/// @param wallUs The time taken to create the race scene and replay the ghost.
+std::string KReplaySystem::formatCsvRow(const BatchGhost &ghost, const char *observed,
+        const char *status, s32 desyncingLap, f64 wallUs) const {
+    char wallMs[32] = "";
+    if (wallUs > 0.0) {
+        snprintf(wallMs, sizeof(wallMs), "%.1f", wallUs / 1000.0);
+    }
+
+    std::string row = QuoteCsvField(ghost.path);
+    if (ghost.error) {
+        row += std::string(",,,") + observed + "," + status + ",";
+    } else {
+        row += std::string(",") + COURSE_NAMES[static_cast<s32>(ghost.course)];
+        row += "," + FormatTimer(ghost.expected) + "," + observed + "," + status + ",";
+    }
+    row += desyncingLap > 0 ? std::to_string(desyncingLap) : std::string();
+    row += std::string(",") + wallMs + "\n";
+    return row;
+}
+
 /// @brief Determines whether or not the ghost simulation should end.
 /// @return Whether the ghost should end or not.
 bool KReplaySystem::calcEnd() const {
@@ -141,14 +511,6 @@ void KReplaySystem::reportFail(const std::string &msg) const {
 /// @brief Determines whether the simulation was a success or not.
 /// @return Whether the simulation was a success or not.
 bool KReplaySystem::success() const {
-    auto format = [](const System::Timer &timer) {
-        std::ostringstream oss;
-        oss << std::setw(2) << std::setfill('0') << timer.min << ":" << std::setw(2)
-            << std::setfill('0') << timer.sec << "." << std::setw(3) << std::setfill('0')
-            << timer.mil;
-        return oss.str();
-    };
-
     const auto *raceManager = System::RaceManager::Instance();
     if (raceManager->stage() != System::RaceManager::Stage::FinishGlobal) {
         m_sceneMgr->currentScene()->heap()->enableAllocation();
@@ -168,7 +530,7 @@ bool KReplaySystem::success() const {
             msg = "Lap " + std::to_string(desyncingTimerIdx) + " timer desync!";
         }
 
-        msg += " Expected " + format(correct) + ", got " + format(incorrect);
+        msg += " Expected " + FormatTimer(correct) + ", got " + FormatTimer(incorrect);
         reportFail(msg);
         return false;
     }
@@ -184,7 +546,7 @@ s32 KReplaySystem::getDesyncingTimerIdx() const {
         return 0;
     }
 
-    for (size_t i = 0; i < 3; ++i) {
+    for (size_t i = 0; i < getLapCount(); ++i) {
         if (m_currentGhost->lapTimer(i) != player.getLapSplit(i + 1)) {
             return i + 1;
         }
@@ -193,6 +555,35 @@ s32 KReplaySystem::getDesyncingTimerIdx() const {
     return -1;
 }
 
+/// @brief Finds the first completed lap whose split doesn't match the ghost, if one exists.
+/// @return 0 if every completed lap matches, and 1+ for the desyncing lap.
+s32 KReplaySystem::getDesyncingLap() const {
+    const auto &player = System::RaceManager::Instance()->player();
+
+    for (size_t i = 0; i < getLapCount(); ++i) {
+        if (!player.lapTimer(i).valid) {
+            break;
+        }
+
+        if (m_currentGhost->lapTimer(i) != player.getLapSplit(i + 1)) {
+            return i + 1;
+        }
+    }
+
+    return 0;
+}
+
+/// @brief Gets the number of laps to compare, which is the course's lap count.
+/// @details Courses without stage info are raced over three laps. The player can't record more laps
+/// than it has timers for.
+size_t KReplaySystem::getLapCount() const {
+    constexpr size_t DEFAULT_LAP_COUNT = 3;
+
+    const auto *stageInfo = System::CourseMap::Instance()->getStageInfo();
+    size_t lapCount = stageInfo ? stageInfo->lapCount() : DEFAULT_LAP_COUNT;
+    return std::min(lapCount, System::RaceManager::Instance()->player().lapTimers().size());
+}
+
 /// @brief Gets the desyncing timer according to the index.
 /// @param i Index to the desyncing timer. Cannot be -1.
 /// @return The pair of timers. The first is the correct one, and the second is the incorrect one.
@@ -6,6 +6,9 @@
 
 #include <game/system/RaceConfig.hh>
 
+#include <string>
+#include <vector>
+
 namespace Kinoko {
 
 /// @brief Kinoko system designed to execute replays.
@@ -29,14 +32,34 @@ public:
 private:
     typedef std::pair<const System::Timer &, const System::Timer &> DesyncingTimerPair;
 
+    /// @brief A ghost to replay in batch mode.
+    struct BatchGhost {
+        std::string path;
+        Course course;
+        System::Timer expected; ///< The finishing time in the ghost's header.
+        const char *error;      ///< Why the ghost can't be replayed, or nullptr if it can.
+    };
+
     KReplaySystem(const KReplaySystem &) = delete;
     KReplaySystem(KReplaySystem &&) = delete;
 
+    void loadGhost(const char *path);
+    void parseBatch(const char *path);
+
+    bool runBatch();
+    bool runBatchParallel();
+    void startBatchGhost(size_t idx);
+    bool replayBatchGhost(size_t idx, std::string &row);
+    [[nodiscard]] std::string formatCsvRow(const BatchGhost &ghost, const char *observed,
+            const char *status, s32 desyncingLap, f64 wallUs) const;
+
     bool calcEnd() const;
     void reportFail(const std::string &msg) const;
 
     bool success() const;
     s32 getDesyncingTimerIdx() const;
+    s32 getDesyncingLap() const;
+    size_t getLapCount() const;
     DesyncingTimerPair getDesyncingTimer(s32 i) const;
 
     static void OnInit(System::RaceConfig *config, void *arg);
@@ -47,6 +70,11 @@ private:
     const System::GhostFile *m_currentGhost;
     const u8 *m_currentRawGhost;
     size_t m_currentRawGhostSize;
+
+    std::vector<BatchGhost> m_batch; ///< Every ghost to replay in batch mode, grouped by course.
+    const char *m_csvPath;           ///< Where batch mode writes a row per ghost.
+    u32 m_jobCount;                  ///< The number of worker processes to replay ghosts in.
+    f64 m_sceneUs;                   ///< The time taken to create the current race scene.
 };
 
 } // namespace Kinoko
@@ -1,5 +1,6 @@
 #include "KTestSystem.hh"
 
+#include "host/BranchExplorer.hh"
 #include "host/SceneCreatorDynamic.hh"
 
 #include <egg/core/Heap.hh>
@@ -9,6 +10,8 @@
 
 #include <abstract/File.hh>
 
+#include <thread>
+
 namespace Kinoko {
 
 // We use an unscoped enum to avoid static_casting in all usecases
@@ -115,6 +118,14 @@ void KTestSystem::calc() {
 /// @details A run consists of iterating over all tests.
 /// @return Whether the run was successful or not.
 bool KTestSystem::run() {
+    if (m_jobCount > 1) {
+        if (Host::BranchExplorer::IsSupported()) {
+            return runParallel();
+        }
+
+        WARN("Parallel tests are not supported on this host. Running sequentially");
+    }
+
     bool success = true;
 
     while (true) {
@@ -194,6 +205,18 @@ void KTestSystem::parseOptions(int argc, char **argv) {
             krkgPath = argv[++i];
 
             break;
+        case Host::EOption::Jobs: {
+            ASSERT(i + 1 < argc);
+
+            int jobs = atoi(argv[++i]);
+            if (jobs < 0) {
+                PANIC("Job count is out of bounds (expected 0 or more), got %d", jobs);
+            }
+
+            // 0 uses every hardware thread
+            m_jobCount = jobs > 0 ? static_cast<u32>(jobs) :
+                                    std::max<u32>(std::thread::hardware_concurrency(), 1);
+        } break;
         case Host::EOption::TargetFrame:
             ASSERT(i + 1 < argc);
             {
@@ -248,7 +271,7 @@ void KTestSystem::DestroyInstance() {
     EGG::egg_delete(instance);
 }
 
-KTestSystem::KTestSystem() : m_testMode(Host::EOption::Invalid) {}
+KTestSystem::KTestSystem() : m_testMode(Host::EOption::Invalid), m_jobCount(1) {}
 
 KTestSystem::~KTestSystem() {
     if (s_instance) {
@@ -444,14 +467,104 @@ bool KTestSystem::runTest() {
     return m_sync;
 }
 
+/// @brief Runs every test case across a pool of worker processes.
+/// @details Each worker is forked from the first test case's race scene, and moves on to its own
+/// test case the same way run() does between test cases. A worker's reports are captured, and
+/// are printed together with its results once every earlier test case has been written, so the
+/// output matches a sequential run.
+/// @return Whether every test case synchronized.
+bool KTestSystem::runParallel() {
+    struct Result {
+        FILE *output;
+        Host::BranchExplorer::Payload payload; ///< Whether the test synced, then its results.
+        bool finished;
+        bool success;
+    };
+
+    const u32 testCount = static_cast<u32>(m_testCases.size());
+    std::vector<Result> results(testCount, {nullptr, {}, false, false});
+    u32 nextResult = 0;
+    bool success = true;
+
+    auto onResult = [&](u32 id, bool finished, const Host::BranchExplorer::Payload &payload) {
+        results[id].finished = true;
+        results[id].success = finished && !payload.empty();
+        results[id].payload = payload;
+
+        for (; nextResult < testCount && results[nextResult].finished; ++nextResult) {
+            Result &result = results[nextResult];
+
+            char buffer[4096];
+            rewind(result.output);
+            for (size_t size; (size = fread(buffer, 1, sizeof(buffer), result.output)) > 0;) {
+                fwrite(buffer, 1, size, stdout);
+            }
+            fclose(result.output);
+
+            if (!result.success) {
+                // The worker's own output explains why it failed
+                success = false;
+                continue;
+            }
+
+            success &= result.payload[0] != 0;
+            Abstract::File::Append("results.txt",
+                    reinterpret_cast<const char *>(result.payload.data() + 1),
+                    result.payload.size() - 1);
+        }
+
+        fflush(stdout);
+    };
+
+    auto runWorker = [this](u32 id, Host::BranchExplorer::Payload &payload) {
+        if (id > 0) {
+            popTestCase();
+            for (u32 i = 1; i < id; ++i) {
+                m_testCases.pop();
+            }
+
+            m_sceneMgr->destroyScene(m_sceneMgr->currentScene());
+            startNextTestCase();
+            m_sceneMgr->createScene(2, m_sceneMgr->currentScene());
+        }
+
+        while (calcTest()) {
+            calc();
+        }
+
+        std::string output = formatTestOutput();
+        payload.push_back(m_sync ? 1 : 0);
+        payload.insert(payload.end(), output.begin(), output.end());
+    };
+
+    Host::BranchExplorer explorer(onResult, m_jobCount);
+    for (u32 i = 0; i < testCount; ++i) {
+        results[i].output = tmpfile();
+        if (!results[i].output) {
+            PANIC("Failed to create output file for test case %u", i);
+        }
+
+        explorer.spawn(i, runWorker, results[i].output);
+    }
+
+    explorer.wait();
+    return success;
+}
+
 /// @brief Writes details about the current test to file.
 /// @details This is designed to be cumulative across multiple tests.
 void KTestSystem::writeTestOutput() const {
+    std::string outStr = formatTestOutput();
+    Abstract::File::Append("results.txt", outStr.c_str(), outStr.size());
+}
+
+/// @brief Formats details about the current test, as written to file.
+std::string KTestSystem::formatTestOutput() const {
     std::string outStr(getCurrentTestCase().name.data());
     outStr += "\n" + std::string(m_sync ? "1" : "0") + "\n";
     outStr += std::to_string(getCurrentTestCase().targetFrame) + "\n";
     outStr += std::to_string(m_frameCount) + "\n";
-    Abstract::File::Append("results.txt", outStr.c_str(), outStr.size());
+    return outStr;
 }
 
 /// @brief Gets the current test case.
@@ -139,7 +139,9 @@ private:
     void testFrame(const TestData &data);
 
     bool runTest();
+    bool runParallel();
     void writeTestOutput() const;
+    [[nodiscard]] std::string formatTestOutput() const;
 
     const TestCase &getCurrentTestCase() const;
 
@@ -149,6 +151,7 @@ private:
     EGG::RamStream m_stream;
     std::queue<TestCase, std::deque<TestCase, EGG::Allocator<TestCase>>> m_testCases;
     Host::EOption m_testMode; ///< Differentiates between test suite and ghost+krkg
+    u32 m_jobCount;           ///< The number of worker processes to run test cases in.
 
     u16 m_versionMajor;
     u16 m_versionMinor;
@@ -0,0 +1,44 @@
+#include "KartState.hh"
+
+#include <game/kart/KartObjectManager.hh>
+
+#include <game/system/RaceManager.hh>
+
+namespace Kinoko::Host {
+
+static void CopyVector(float *dst, const EGG::Vector3f &v) {
+    dst[0] = v.x;
+    dst[1] = v.y;
+    dst[2] = v.z;
+}
+
+static void CopyQuat(float *dst, const EGG::Quatf &q) {
+    CopyVector(dst, q.v);
+    dst[3] = q.w;
+}
+
+/// @brief Captures the player's kart in the active race, as exposed by the C interface.
+/// @param state The state to fill in.
+/// @param frame The number of frames stepped in the race, which the engine doesn't track.
+void CaptureKartState(KinokoKartState &state, u32 frame) {
+    const auto *object = Kart::KartObjectManager::Instance()->object(0);
+    const auto *raceManager = System::RaceManager::Instance();
+    const auto &player = raceManager->player();
+
+    CopyVector(state.pos, object->pos());
+    CopyQuat(state.fullRot, object->fullRot());
+    CopyVector(state.extVel, object->extVel());
+    CopyVector(state.intVel, object->intVel());
+    state.speed = object->speed();
+    state.acceleration = object->acceleration();
+    state.softSpeedLimit = object->softSpeedLimit();
+    CopyQuat(state.mainRot, object->mainRot());
+    CopyVector(state.angVel2, object->angVel2());
+    state.raceCompletion = player.raceCompletion();
+    state.frame = frame;
+    state.checkpointId = player.checkpointId();
+    state.jugemId = player.jugemId();
+    state.stage = static_cast<uint8_t>(raceManager->stage());
+}
+
+} // namespace Kinoko::Host
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <Common.hh>
+
+#include <kinoko.h>
+
+namespace Kinoko::Host {
+
+void CaptureKartState(KinokoKartState &state, u32 frame);
+
+} // namespace Kinoko::Host
@@ -30,6 +30,66 @@ std::optional<EOption> CheckFlag(const char *arg) {
             return EOption::TargetFrame;
         }
 
+        if (strcmp(verbose_arg, "cache") == 0) {
+            return EOption::ArchiveCache;
+        }
+
+        if (strcmp(verbose_arg, "jobs") == 0) {
+            return EOption::Jobs;
+        }
+
+        if (strcmp(verbose_arg, "profile") == 0) {
+            return EOption::Profile;
+        }
+
+        if (strcmp(verbose_arg, "headless") == 0) {
+            return EOption::Headless;
+        }
+
+        if (strcmp(verbose_arg, "size-classes") == 0) {
+            return EOption::SizeClasses;
+        }
+
+        if (strcmp(verbose_arg, "arena-size") == 0) {
+            return EOption::ArenaSize;
+        }
+
+        if (strcmp(verbose_arg, "heap-stats") == 0) {
+            return EOption::HeapStats;
+        }
+
+        if (strcmp(verbose_arg, "json") == 0) {
+            return EOption::Json;
+        }
+
+        if (strcmp(verbose_arg, "warmup") == 0) {
+            return EOption::Warmup;
+        }
+
+        if (strcmp(verbose_arg, "repetitions") == 0) {
+            return EOption::Repetitions;
+        }
+
+        if (strcmp(verbose_arg, "batch") == 0) {
+            return EOption::Batch;
+        }
+
+        if (strcmp(verbose_arg, "csv") == 0) {
+            return EOption::Csv;
+        }
+
+        if (strcmp(verbose_arg, "retain-archives") == 0) {
+            return EOption::RetainArchives;
+        }
+
+        if (strcmp(verbose_arg, "channel") == 0) {
+            return EOption::Channel;
+        }
+
+        if (strcmp(verbose_arg, "filter") == 0) {
+            return EOption::Filter;
+        }
+
         return EOption::Invalid;
     } else {
         switch (arg[1]) {
@@ -45,6 +105,21 @@ std::optional<EOption> CheckFlag(const char *arg) {
         case 'F':
         case 'f':
             return EOption::TargetFrame;
+        case 'C':
+        case 'c':
+            return EOption::ArchiveCache;
+        case 'J':
+        case 'j':
+            return EOption::Jobs;
+        case 'P':
+        case 'p':
+            return EOption::Profile;
+        case 'B':
+        case 'b':
+            return EOption::Batch;
+        case 'R':
+        case 'r':
+            return EOption::Repetitions;
         default:
             return EOption::Invalid;
         }
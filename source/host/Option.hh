@@ -13,6 +13,21 @@ enum class EOption {
     Ghost,
     KRKG,
     TargetFrame,
+    ArchiveCache,
+    Jobs,
+    Profile,
+    Headless,
+    SizeClasses,
+    ArenaSize,
+    HeapStats,
+    Json,
+    Warmup,
+    Repetitions,
+    Batch,
+    Csv,
+    RetainArchives,
+    Channel,
+    Filter,
 };
 
 namespace Option {
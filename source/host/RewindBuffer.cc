@@ -0,0 +1,204 @@
+#include "RewindBuffer.hh"
+
+#include "host/DirtyPageTracker.hh"
+
+namespace Kinoko::Host {
+
+/// @brief Starts a history whose frame 0 is the current state of the memory space.
+/// @param budget The maximum number of bytes the history may use. Once exceeded, the oldest frames
+/// are discarded. The budget should fit at least a few keyframes, each the size of the memory
+/// space.
+/// @param keyframeInterval The number of frames between two full keyframes. Shorter intervals
+/// bound seek times more tightly, at the cost of history length.
+RewindBuffer::RewindBuffer(size_t budget, u32 keyframeInterval)
+    : m_budget(budget), m_keyframeInterval(keyframeInterval), m_oldestFrame(0),
+      m_historySize(0) {
+    ASSERT(m_keyframeInterval > 0);
+
+    Frame frame;
+    frame.statics = m_shadow.m_statics;
+    pushFrame(std::move(frame));
+
+    m_keyframes.push_back({0, m_shadow});
+    m_historySize += KeyframeSize();
+    evict();
+}
+
+RewindBuffer::~RewindBuffer() = default;
+
+/// @brief Appends the current state of the memory space as the newest frame.
+/// @details This should be called once after every frame. Only the heap words that changed since
+/// the previous call are stored.
+void RewindBuffer::record() {
+    m_scratch.clear();
+
+    if (DirtyPageTracker::IsEnabled() && m_shadow.m_syncEpoch != 0) {
+        size_t pageWords = DirtyPageTracker::PageSize() / sizeof(u32);
+        DirtyPageTracker::ForEachRunSince(m_shadow.m_syncEpoch, [&](size_t page, size_t count) {
+            encodeRange(page * pageWords, (page + count) * pageWords);
+        });
+    } else {
+        encodeRange(0, Context::MemorySpaceSize() / sizeof(u32));
+    }
+
+    m_shadow.m_syncEpoch = DirtyPageTracker::IsEnabled() ? DirtyPageTracker::Sync() : 0;
+    m_shadow.saveStatics();
+    m_shadow.retainArchives();
+
+    // Copy rather than move the scratch buffer, so that the stored delta is tightly allocated
+    Frame frame;
+    frame.delta = m_scratch;
+    frame.statics = m_shadow.m_statics;
+    pushFrame(std::move(frame));
+
+    u32 newest = newestFrame();
+    if (newest % m_keyframeInterval == 0) {
+        m_keyframes.push_back({newest, m_shadow});
+        m_historySize += KeyframeSize();
+    }
+
+    evict();
+}
+
+/// @brief Restores the memory space and statics to an earlier frame.
+/// @details The frame is reconstructed from whichever starting point requires the fewest words to
+/// be written: the newest frame or any keyframe, from which deltas are walked in either direction.
+/// All frames after the target are discarded, so that recording resumes from it.
+/// @param frame The frame to restore, between oldestFrame() and newestFrame().
+void RewindBuffer::seek(u32 frame) {
+    u32 newest = newestFrame();
+    ASSERT(frame >= m_oldestFrame && frame <= newest);
+
+    // Prefix sums of the delta sizes make the cost of any walk between two frames O(1)
+    std::vector<size_t> walked(m_frames.size(), 0);
+    for (size_t i = 1; i < m_frames.size(); ++i) {
+        walked[i] = walked[i - 1] + m_frames[i].delta.size();
+    }
+
+    auto walkCost = [&](u32 from, u32 to) {
+        return walked[std::max(from, to) - m_oldestFrame] -
+                walked[std::min(from, to) - m_oldestFrame];
+    };
+
+    const Keyframe *start = nullptr;
+    size_t bestCost = walkCost(newest, frame);
+    for (const auto &keyframe : m_keyframes) {
+        size_t cost = Context::MemorySpaceSize() / sizeof(u32) + walkCost(keyframe.frame, frame);
+        if (cost < bestCost) {
+            start = &keyframe;
+            bestCost = cost;
+        }
+    }
+
+    u32 current = newest;
+    if (start) {
+        Context::SetActiveContext(start->context);
+        current = start->frame;
+    } else {
+        Context::SetActiveContext(m_shadow);
+    }
+
+    // A frame's delta steps between it and the previous frame, in both directions
+    for (; current > frame; --current) {
+        ApplyDelta(frameAt(current).delta);
+    }
+
+    for (; current < frame; ++current) {
+        ApplyDelta(frameAt(current + 1).delta);
+    }
+
+    m_shadow.m_statics = frameAt(frame).statics;
+    m_shadow.loadStatics();
+    m_shadow.save();
+
+    while (newestFrame() > frame) {
+        m_historySize -= FrameSize(m_frames.back());
+        m_frames.pop_back();
+    }
+
+    while (!m_keyframes.empty() && m_keyframes.back().frame > frame) {
+        m_keyframes.pop_back();
+        m_historySize -= KeyframeSize();
+    }
+}
+
+void RewindBuffer::pushFrame(Frame &&frame) {
+    m_historySize += FrameSize(frame);
+    m_frames.push_back(std::move(frame));
+}
+
+/// @brief Discards the oldest frames until the history fits in the budget.
+/// @details The newest frame is always kept, as it is what the next delta is computed against.
+void RewindBuffer::evict() {
+    while (m_historySize > m_budget && m_frames.size() > 1) {
+        m_historySize -= FrameSize(m_frames.front());
+        m_frames.pop_front();
+        ++m_oldestFrame;
+
+        // The new oldest frame can no longer step back, so its delta is dead weight
+        Frame &oldest = m_frames.front();
+        m_historySize -= oldest.delta.size() * sizeof(u32);
+        std::vector<u32>().swap(oldest.delta);
+
+        while (!m_keyframes.empty() && m_keyframes.front().frame < m_oldestFrame) {
+            m_keyframes.pop_front();
+            m_historySize -= KeyframeSize();
+        }
+    }
+}
+
+/// @brief Appends the changed words in a range of the memory space to the scratch delta.
+/// @details The shadow is updated along the way, so that it mirrors the memory space afterwards.
+/// @param begin The first word of the range.
+/// @param end The word after the last word of the range.
+void RewindBuffer::encodeRange(size_t begin, size_t end) {
+    const u32 *live = static_cast<const u32 *>(Context::MemorySpace());
+    u32 *shadow = static_cast<u32 *>(m_shadow.m_contextMemory);
+
+    for (size_t i = begin; i < end;) {
+        if (live[i] == shadow[i]) {
+            ++i;
+            continue;
+        }
+
+        size_t runEnd = i + 1;
+        for (size_t j = runEnd; j < end && j < runEnd + RUN_MERGE_WORDS; ++j) {
+            if (live[j] != shadow[j]) {
+                runEnd = j + 1;
+            }
+        }
+
+        m_scratch.push_back(static_cast<u32>(i));
+        m_scratch.push_back(static_cast<u32>(runEnd - i));
+        for (; i < runEnd; ++i) {
+            m_scratch.push_back(live[i] ^ shadow[i]);
+            shadow[i] = live[i];
+        }
+    }
+}
+
+/// @brief XORs a frame delta into the memory space, stepping it to the adjacent frame.
+void RewindBuffer::ApplyDelta(const std::vector<u32> &delta) {
+    u32 *live = static_cast<u32 *>(Context::MemorySpace());
+
+    for (size_t i = 0; i < delta.size();) {
+        size_t offset = delta[i];
+        size_t count = delta[i + 1];
+        const u32 *words = delta.data() + i + 2;
+        i += 2 + count;
+
+        if (DirtyPageTracker::IsEnabled()) {
+            // Lift the protection up front rather than faulting in the middle of the run
+            size_t pageWords = DirtyPageTracker::PageSize() / sizeof(u32);
+            size_t firstPage = offset / pageWords;
+            size_t lastPage = (offset + count - 1) / pageWords;
+            DirtyPageTracker::MarkDirty(firstPage, lastPage - firstPage + 1);
+        }
+
+        for (size_t j = 0; j < count; ++j) {
+            live[offset + j] ^= words[j];
+        }
+    }
+}
+
+} // namespace Kinoko::Host
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "host/Context.hh"
+
+#include <deque>
+#include <vector>
+
+namespace Kinoko::Host {
+
+/// @brief Frame-by-frame history of the memory space, for stepping backwards through a race.
+/// @details Storing a Context per frame would cost 16 MiB each. Instead, every recorded frame only
+/// stores the XOR of the heap words that changed since the previous frame, run-length encoded so
+/// that unchanged words cost nothing. Since XOR is its own inverse, the same delta steps between
+/// two adjacent frames in either direction. Full keyframes are taken periodically, so that a seek
+/// never has to walk more deltas than the nearest keyframe allows.
+///
+/// The newest frame is mirrored in a shadow Context, which is what deltas are computed against.
+/// When incremental contexts are enabled, recording a frame only compares the pages written to
+/// since the previous one. Otherwise, the entire heap is compared every frame.
+///
+/// Seeking to a frame discards the history after it, as the race diverges from there on.
+class RewindBuffer {
+public:
+    RewindBuffer(size_t budget, u32 keyframeInterval);
+    ~RewindBuffer();
+
+    RewindBuffer(const RewindBuffer &) = delete;
+    RewindBuffer(RewindBuffer &&) = delete;
+
+    void record();
+    void seek(u32 frame);
+
+    /// @brief The earliest frame that can still be sought to.
+    [[nodiscard]] u32 oldestFrame() const {
+        return m_oldestFrame;
+    }
+
+    /// @brief The most recently recorded frame. The buffer's construction is frame 0.
+    [[nodiscard]] u32 newestFrame() const {
+        return m_oldestFrame + static_cast<u32>(m_frames.size()) - 1;
+    }
+
+    [[nodiscard]] size_t keyframeCount() const {
+        return m_keyframes.size();
+    }
+
+    /// @brief The number of bytes used by the history, which is kept under the budget.
+    [[nodiscard]] size_t historySize() const {
+        return m_historySize;
+    }
+
+    /// @brief The number of bytes used by the frame deltas alone, excluding keyframes.
+    [[nodiscard]] size_t deltaSize() const {
+        return m_historySize - m_keyframes.size() * KeyframeSize();
+    }
+
+private:
+    struct Frame {
+        /// Runs of XORed heap words, each encoded as a word offset, a word count and the words.
+        std::vector<u32> delta;
+        Context::Statics statics;
+    };
+
+    struct Keyframe {
+        u32 frame;
+        Context context;
+    };
+
+    void pushFrame(Frame &&frame);
+    void evict();
+    void encodeRange(size_t begin, size_t end);
+
+    [[nodiscard]] const Frame &frameAt(u32 frame) const {
+        return m_frames[frame - m_oldestFrame];
+    }
+
+    static void ApplyDelta(const std::vector<u32> &delta);
+
+    [[nodiscard]] static size_t FrameSize(const Frame &frame) {
+        return sizeof(Frame) + frame.delta.size() * sizeof(u32);
+    }
+
+    [[nodiscard]] static size_t KeyframeSize() {
+        return sizeof(Keyframe) + Context::MemorySpaceSize();
+    }
+
+    size_t m_budget;            ///< The maximum number of bytes used by the history.
+    u32 m_keyframeInterval;     ///< The number of frames between two keyframes.
+    u32 m_oldestFrame;          ///< The frame number of m_frames.front().
+    size_t m_historySize;       ///< The number of bytes used by m_frames and m_keyframes.
+    Context m_shadow;           ///< Mirror of the newest frame, which deltas are computed against.
+    std::deque<Frame> m_frames; ///< Every frame from the oldest to the newest.
+    std::deque<Keyframe> m_keyframes; ///< Sorted by frame.
+    std::vector<u32> m_scratch;       ///< Delta of the frame being recorded.
+
+    /// A gap of this many unchanged words costs no more than starting a new run.
+    static constexpr size_t RUN_MERGE_WORDS = 2;
+};
+
+} // namespace Kinoko::Host
@@ -0,0 +1,97 @@
+#include "host/KBenchSystem.hh"
+
+#include "host/Context.hh"
+#include "host/HostChannel.hh"
+#include "host/KartState.hh"
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <thread>
+
+namespace Kinoko {
+
+/// @brief Measures the latency of handing an input to Kinoko and getting the state back.
+/// @details The agent is a thread pushing one input at a time over a channel, as an agent in
+/// another process would, and timing until the state arrives. The round trip is measured on its
+/// own, answering with the same state, and with a frame simulated in between. The race is driven by
+/// the ghost, so the inputs are read but not applied.
+void KBenchSystem::benchChannel() {
+    constexpr u32 ROUND_TRIPS = 100000;
+    constexpr u32 FRAME_ROUND_TRIPS = 2000;
+
+    if (!Host::Channel::IsSupported()) {
+        WARN("Channels are not supported on this host");
+        return;
+    }
+
+    // The same memory layout as an agent's shared memory object, but private to this process
+    auto channel = std::make_unique<KinokoChannel>();
+    Host::Channel::Init(*channel, {});
+
+    Host::Context base;
+
+    auto roundTrip = [&](u32 count, bool simulate) {
+        std::vector<f64> latencyNs(count);
+        std::thread agent([&] {
+            KinokoChannelInput input = {KINOKO_CHANNEL_STEP, 0, 7, 7, 0};
+            u32 sink = 0;
+            for (u32 i = 0; i < count; ++i) {
+                auto t0 = Clock::now();
+                bool pushed = Host::Channel::PushInput(*channel, input);
+                std::optional<KinokoKartState> state = Host::Channel::PopState(*channel);
+                latencyNs[i] = std::chrono::duration<f64, std::nano>(Clock::now() - t0).count();
+                ASSERT(pushed && state);
+                sink += state->frame;
+            }
+
+            input.command = KINOKO_CHANNEL_QUIT;
+            bool pushed = Host::Channel::PushInput(*channel, input);
+            ASSERT(pushed);
+            s_sink = sink;
+        });
+
+        KinokoKartState state;
+        u32 frame = 0;
+        Host::CaptureKartState(state, frame);
+        while (true) {
+            std::optional<KinokoChannelInput> input = Host::Channel::PopInput(*channel);
+            ASSERT(input);
+            if (input->command == KINOKO_CHANNEL_QUIT) {
+                break;
+            }
+
+            if (simulate) {
+                calc();
+                Host::CaptureKartState(state, ++frame);
+            }
+
+            bool pushed = Host::Channel::PushState(*channel, state);
+            ASSERT(pushed);
+        }
+
+        agent.join();
+        Host::Context::SetActiveContext(base);
+
+        std::sort(latencyNs.begin(), latencyNs.end());
+        return latencyNs;
+    };
+
+    auto percentile = [](const std::vector<f64> &sorted, f64 p) {
+        return sorted[static_cast<size_t>(p * static_cast<f64>(sorted.size() - 1))];
+    };
+
+    std::vector<f64> handoffNs = roundTrip(ROUND_TRIPS, false);
+    std::vector<f64> frameNs = roundTrip(FRAME_ROUND_TRIPS, true);
+    f64 handoffUs = std::accumulate(handoffNs.begin(), handoffNs.end(), 0.0) / NS_PER_US;
+    f64 frameUs = std::accumulate(frameNs.begin(), frameNs.end(), 0.0) / NS_PER_US;
+    addMeasurement("channel.roundtrip", "round trip", ROUND_TRIPS, {handoffUs});
+    addMeasurement("channel.frame", "round trip", FRAME_ROUND_TRIPS, {frameUs});
+
+    REPORT("Channel: %.0f ns median, %.0f ns p99 round trip (%.2f us median, %.2f us p99 with a "
+           "frame)",
+            percentile(handoffNs, 0.5), percentile(handoffNs, 0.99),
+            percentile(frameNs, 0.5) / NS_PER_US, percentile(frameNs, 0.99) / NS_PER_US);
+}
+
+} // namespace Kinoko
@@ -0,0 +1,693 @@
+#include "host/KBenchSystem.hh"
+
+#include "host/Context.hh"
+
+#include <game/field/CourseColMgr.hh>
+#include <game/field/ObjectCollisionBox.hh>
+#include <game/field/ObjectCollisionConvexHull.hh>
+#include <game/field/ObjectCollisionSphere.hh>
+
+#include <game/kart/KartObjectManager.hh>
+
+#include <game/system/CourseMap.hh>
+#include <game/system/ResourceManager.hh>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <random>
+
+namespace Kinoko {
+
+/// @brief Finds the prism list for a position by walking the big-endian octree of a KCL file.
+/// @details This is how KColData::searchBlock worked before it preloaded the octree, and is kept as
+/// a baseline. The returned list is still big-endian.
+static const u16 *SearchBlockBigEndian(const void *file, const EGG::Vector3f &point) {
+    const auto *header = reinterpret_cast<const Field::KColHeader *>(file);
+    const int x = point.x - parse<f32>(header->area_min_pos.x);
+    const int y = point.y - parse<f32>(header->area_min_pos.y);
+    const int z = point.z - parse<f32>(header->area_min_pos.z);
+
+    if (x & parse<u32>(header->area_x_width_mask) || y & parse<u32>(header->area_y_width_mask) ||
+            z & parse<u32>(header->area_z_width_mask)) {
+        return nullptr;
+    }
+
+    u32 shift = parse<u32>(header->block_width_shift);
+    const u8 *curBlock = reinterpret_cast<const u8 *>(file) + parse<u32>(header->block_data_offset);
+    u32 index = 4 *
+            (((u32)z >> shift) << parse<u32>(header->area_xy_blocks_shift) |
+                    ((u32)y >> shift) << parse<u32>(header->area_x_blocks_shift) |
+                    (u32)x >> shift);
+
+    while (true) {
+        u32 offset = parse<u32>(*reinterpret_cast<const u32 *>(curBlock + index));
+        if ((offset & 0x80000000) != 0) {
+            return reinterpret_cast<const u16 *>(curBlock + (offset & ~0x80000000));
+        }
+
+        shift--;
+        curBlock += offset;
+        index = 4 * ((((u32)x >> shift) & 1) | ((((u32)y >> shift) & 1) << 1) |
+                            ((((u32)z >> shift) & 1) << 2));
+    }
+}
+
+/// @brief Measures KCL octree lookups per second over positions the kart actually visits.
+/// @details Lookups on the native octree are compared against walking the file's big-endian
+/// octree, and every prism list they return must match.
+void KBenchSystem::benchSearchBlock() {
+    constexpr u16 FRAMES = 600;
+    constexpr u32 PASSES = 50;
+
+    std::vector<EGG::Vector3f> positions = recordKartPositions(FRAMES);
+
+    const Field::KColData *data = Field::CourseColMgr::Instance()->data();
+    const void *file = System::ResourceManager::Instance()->getFile("course.kcl", nullptr,
+            System::ArchiveId::Course);
+
+    u32 mismatches = 0;
+    for (const auto &pos : positions) {
+        const u16 *native = data->searchBlock(pos);
+        const u16 *bigEndian = SearchBlockBigEndian(file, pos);
+        if (!native || !bigEndian) {
+            mismatches += native != bigEndian;
+            continue;
+        }
+
+        while (*++native == parse<u16>(*++bigEndian) && *native != 0) {}
+        mismatches += *native != parse<u16>(*bigEndian);
+    }
+
+    if (mismatches > 0) {
+        WARN("%u of %zu octree lookups did not match the file", mismatches, positions.size());
+        ++m_failedChecks;
+    }
+
+    uintptr_t sink = 0;
+    f64 lookups = static_cast<f64>(PASSES) * static_cast<f64>(positions.size());
+
+    f64 bigEndianUs = measure("kcl.searchBlock.bigEndian", "lookup", lookups, [&] {
+        for (u32 i = 0; i < PASSES; ++i) {
+            for (const auto &pos : positions) {
+                sink ^= reinterpret_cast<uintptr_t>(SearchBlockBigEndian(file, pos));
+            }
+        }
+    });
+
+    f64 nativeUs = measure("kcl.searchBlock", "lookup", lookups, [&] {
+        for (u32 i = 0; i < PASSES; ++i) {
+            for (const auto &pos : positions) {
+                sink ^= reinterpret_cast<uintptr_t>(data->searchBlock(pos));
+            }
+        }
+    });
+
+    s_sink = sink;
+
+    REPORT("searchBlock: %.0f lookups/s (big-endian), %.0f lookups/s (native)",
+            US_PER_SECOND * lookups / bigEndianUs, US_PER_SECOND * lookups / nativeUs);
+}
+
+/// @brief Measures sphere collision checks against the course over positions the kart visits.
+/// @details Each check is made from the kart's previous position, with the radius and mask of the
+/// kart's own checks. KColData::checkSphere is measured on its own, iterating every colliding
+/// prism after a lookup, and as part of CourseColMgr::checkSphereFullPush, which also gathers the
+/// collision info. The race is restored to its current state afterwards.
+void KBenchSystem::benchCourseCollision() {
+    constexpr u16 FRAMES = 600;
+    constexpr u32 PASSES = 20;
+    constexpr f32 RADIUS = 100.0f;
+
+    std::vector<EGG::Vector3f> positions = recordKartPositions(FRAMES);
+    if (positions.size() < 2) {
+        return;
+    }
+
+    Host::Context base;
+    auto *courseColMgr = Field::CourseColMgr::Instance();
+    Field::KColData *data = courseColMgr->data();
+
+    u32 collisions = 0;
+    f64 checks = static_cast<f64>(PASSES) * static_cast<f64>(positions.size() - 1);
+
+    f64 checkSphereUs = measure("kcl.checkSphere", "check", checks, [&] {
+        f32 dist;
+        EGG::Vector3f fnrm;
+        u16 attribute;
+
+        collisions = 0;
+        for (u32 i = 0; i < PASSES; ++i) {
+            for (size_t j = 1; j < positions.size(); ++j) {
+                data->lookupSphere(RADIUS, positions[j], positions[j - 1],
+                        KCL_TYPE_VEHICLE_COLLIDEABLE);
+                while (data->checkSphere(&dist, &fnrm, &attribute)) {
+                    ++collisions;
+                }
+            }
+        }
+    });
+
+    f64 fullPushUs = measure("courseColMgr.checkSphereFullPush", "check", checks, [&] {
+        Field::CollisionInfo info;
+        Field::KCLTypeMask mask;
+        uintptr_t sink = 0;
+
+        for (u32 i = 0; i < PASSES; ++i) {
+            for (size_t j = 1; j < positions.size(); ++j) {
+                info.reset();
+                mask = KCL_NONE;
+                sink += courseColMgr->checkSphereFullPush(1.0f, RADIUS, nullptr, positions[j],
+                        positions[j - 1], KCL_TYPE_VEHICLE_COLLIDEABLE, &info, &mask);
+            }
+        }
+
+        s_sink = sink;
+    });
+
+    // Pushing collision entries modifies the collision director
+    Host::Context::SetActiveContext(base);
+
+    REPORT("Course collision: %.0f checkSphere lookups/s (%.2f prisms hit per lookup), "
+           "%.0f checkSphereFullPush/s",
+            US_PER_SECOND * checks / checkSphereUs, static_cast<f64>(collisions) / checks,
+            US_PER_SECOND * checks / fullPushUs);
+}
+
+/// @brief Measures how quickly the course's prism cache is narrowed around recorded kart positions.
+/// @details This is done once per kart per frame, with the same radius and mask as KartSub. Dense
+/// areas of a course (i.e. Rainbow Road or Mushroom Gorge) cache the most prisms, which is where
+/// deduplicating them matters. Every cache must also list a subset of the prisms of the position's
+/// octree leaf, in the same order and without duplicates.
+void KBenchSystem::benchNarrowScope() {
+    constexpr u16 FRAMES = 600;
+    constexpr u32 PASSES = 200;
+    constexpr f32 RADIUS = 250.0f;
+
+    std::vector<EGG::Vector3f> positions = recordKartPositions(FRAMES);
+
+    Host::Context base;
+    auto *courseColMgr = Field::CourseColMgr::Instance();
+    const Field::KColData *data = courseColMgr->data();
+
+    size_t cachedPrisms = 0;
+    size_t maxCachedPrisms = 0;
+    u32 mismatches = 0;
+    for (const auto &pos : positions) {
+        courseColMgr->scaledNarrowScopeLocal(1.0f, RADIUS, nullptr, pos,
+                KCL_TYPE_VEHICLE_INTERACTABLE);
+
+        const u16 *list = data->searchBlock(pos);
+        size_t count = 0;
+        for (; data->prismCache(count) != 0; ++count) {
+            u16 prism = data->prismCache(count);
+            for (u32 i = 0; i < count; ++i) {
+                mismatches += data->prismCache(i) == prism;
+            }
+
+            while (list && *++list != 0 && *list != prism) {}
+            if (!list || *list == 0) {
+                ++mismatches;
+                break;
+            }
+        }
+
+        cachedPrisms += count;
+        maxCachedPrisms = std::max(maxCachedPrisms, count);
+    }
+
+    if (mismatches > 0) {
+        WARN("%u prism cache entries are out of order or duplicated", mismatches);
+        ++m_failedChecks;
+    }
+
+    auto t0 = Clock::now();
+    for (u32 i = 0; i < PASSES; ++i) {
+        for (const auto &pos : positions) {
+            courseColMgr->scaledNarrowScopeLocal(1.0f, RADIUS, nullptr, pos,
+                    KCL_TYPE_VEHICLE_INTERACTABLE);
+        }
+    }
+    auto t1 = Clock::now();
+
+    Host::Context::SetActiveContext(base);
+
+    f64 queries = static_cast<f64>(PASSES) * static_cast<f64>(positions.size());
+    REPORT("narrowScopeLocal: %.0f queries/s, %.1f cached prisms on average, %zu at most",
+            US_PER_SECOND * queries / ElapsedUs(t0, t1),
+            static_cast<f64>(cachedPrisms) / static_cast<f64>(positions.size()), maxCachedPrisms);
+}
+
+/// @brief Checks every supported SIMD level of convex hulls against the scalar level.
+/// @details Random hulls, including ties, infinities and NaNs, are transformed and searched for
+/// support points at each level, which must give the same support indices and bit-identical
+/// points, other than the sign of NaNs. The race is then run at each level, which must leave the
+/// kart in the same position on every frame. The race is restored to its current state afterwards.
+void KBenchSystem::benchConvexHull() {
+    typedef Field::ObjectCollisionConvexHull ConvexHull;
+    typedef ConvexHull::SimdLevel SimdLevel;
+
+    constexpr u32 HULL_COUNT = 512;
+    constexpr u32 MAX_POINT_COUNT = 64;
+    constexpr u32 DIRECTION_COUNT = 64;
+    constexpr u32 PASSES = 20;
+    constexpr u16 FRAMES = 600;
+    constexpr std::array<SimdLevel, 3> LEVELS = {{
+            SimdLevel::Scalar,
+            SimdLevel::SSE2,
+            SimdLevel::AVX2,
+    }};
+    constexpr std::array<const char *, 3> LEVEL_NAMES = {{"scalar", "SSE2", "AVX2"}};
+
+    constexpr f32 INF = std::numeric_limits<f32>::infinity();
+    constexpr f32 NAN_VALUE = std::numeric_limits<f32>::quiet_NaN();
+
+    SimdLevel prevLevel = ConvexHull::GetSimdLevel();
+    Host::Context base;
+    EGG::Heap *heap = m_sceneMgr->currentScene()->heap();
+    heap->enableAllocation();
+
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<f32> coord(-5000.0f, 5000.0f);
+    std::uniform_real_distribution<f32> unit(-1.0f, 1.0f);
+
+    // Rare special values exercise the tie-break and NaN handling
+    auto randomValue = [&](std::uniform_real_distribution<f32> &dist) {
+        switch (rng() % 64) {
+        case 0:
+            return NAN_VALUE;
+        case 1:
+            return INF;
+        case 2:
+            return -INF;
+        case 3:
+            return 0.0f;
+        case 4:
+            return -0.0f;
+        default:
+            return dist(rng);
+        }
+    };
+
+    // The sign of a NaN depends on the order the compiler picks for commutative scalar operations
+    auto canonicalBits = [](f32 val) { return val != val ? f2u(NAN_VALUE) : f2u(val); };
+
+    std::vector<std::unique_ptr<ConvexHull>> hulls;
+    std::vector<EGG::Matrix34f> matrices;
+    for (u32 i = 0; i < HULL_COUNT; ++i) {
+        // Most hulls in the game are boxes
+        size_t pointCount = i % 2 == 0 ? 8 : 1 + rng() % MAX_POINT_COUNT;
+        std::vector<EGG::Vector3f> points(pointCount);
+        for (auto &point : points) {
+            point = EGG::Vector3f(randomValue(coord), randomValue(coord), randomValue(coord));
+        }
+
+        // Duplicate points tie on every direction
+        if (pointCount > 2 && i % 3 == 0) {
+            points[pointCount - 1] = points[rng() % (pointCount - 1)];
+        }
+
+        hulls.push_back(std::make_unique<ConvexHull>(points));
+
+        EGG::Matrix34f mat;
+        for (size_t row = 0; row < 3; ++row) {
+            for (size_t col = 0; col < 3; ++col) {
+                mat[row, col] = randomValue(unit);
+            }
+
+            mat[row, 3] = randomValue(coord);
+        }
+
+        matrices.push_back(mat);
+    }
+
+    std::vector<EGG::Vector3f> directions = {EGG::Vector3f::zero, EGG::Vector3f::ex,
+            EGG::Vector3f(NAN_VALUE, 0.0f, 0.0f), EGG::Vector3f(INF, -INF, 0.0f)};
+    while (directions.size() < DIRECTION_COUNT) {
+        directions.emplace_back(randomValue(unit), randomValue(unit), randomValue(unit));
+    }
+
+    std::array<std::vector<u32>, LEVELS.size()> bits;
+    std::array<std::vector<size_t>, LEVELS.size()> supports;
+    std::array<f64, LEVELS.size()> elapsedUs = {};
+    std::array<std::vector<EGG::Vector3f>, LEVELS.size()> positions;
+
+    for (size_t level = 0; level < LEVELS.size(); ++level) {
+        if (!ConvexHull::IsSimdLevelSupported(LEVELS[level])) {
+            continue;
+        }
+
+        ConvexHull::SetSimdLevel(LEVELS[level]);
+
+        for (u32 i = 0; i < HULL_COUNT; ++i) {
+            hulls[i]->transform(matrices[i], EGG::Vector3f(1.5f, 1.5f, 1.5f));
+            for (const auto &point : hulls[i]->worldPoints()) {
+                bits[level].push_back(canonicalBits(point.x));
+                bits[level].push_back(canonicalBits(point.y));
+                bits[level].push_back(canonicalBits(point.z));
+            }
+
+            for (const auto &dir : directions) {
+                const EGG::Vector3f &support = hulls[i]->getSupport(dir);
+                supports[level].push_back(&support - hulls[i]->worldPoints().data());
+            }
+        }
+
+        uintptr_t sink = 0;
+        auto t0 = Clock::now();
+        for (u32 pass = 0; pass < PASSES; ++pass) {
+            for (u32 i = 0; i < HULL_COUNT; ++i) {
+                hulls[i]->transform(matrices[i], EGG::Vector3f::unit);
+                for (const auto &dir : directions) {
+                    sink += GetAddrNum(&hulls[i]->getSupport(dir));
+                }
+            }
+        }
+        elapsedUs[level] = ElapsedUs(t0, Clock::now());
+        s_sink = sink;
+    }
+
+    // The hulls must be freed before restoring the heap they were allocated from
+    hulls.clear();
+    heap->disableAllocation();
+    Host::Context::SetActiveContext(base);
+
+    for (size_t level = 0; level < LEVELS.size(); ++level) {
+        if (!ConvexHull::IsSimdLevelSupported(LEVELS[level])) {
+            continue;
+        }
+
+        ConvexHull::SetSimdLevel(LEVELS[level]);
+        positions[level].reserve(FRAMES);
+        for (u16 i = 0; i < FRAMES; ++i) {
+            calc();
+            positions[level].push_back(Kart::KartObjectManager::Instance()->object(0)->pos());
+        }
+
+        Host::Context::SetActiveContext(base);
+    }
+
+    ConvexHull::SetSimdLevel(prevLevel);
+
+    f64 searchCount = static_cast<f64>(PASSES) * static_cast<f64>(HULL_COUNT) *
+            static_cast<f64>(directions.size());
+
+    for (size_t level = 1; level < LEVELS.size(); ++level) {
+        if (bits[level].empty()) {
+            continue;
+        }
+
+        if (bits[level] != bits[0]) {
+            WARN("%s convex hull points do not match the scalar points", LEVEL_NAMES[level]);
+            ++m_failedChecks;
+        }
+
+        if (supports[level] != supports[0]) {
+            WARN("%s support points do not match the scalar support points", LEVEL_NAMES[level]);
+            ++m_failedChecks;
+        }
+
+        if (positions[level] != positions[0]) {
+            WARN("%s kart positions do not match the scalar kart positions", LEVEL_NAMES[level]);
+            ++m_failedChecks;
+        }
+    }
+
+    for (size_t level = 0; level < LEVELS.size(); ++level) {
+        if (!bits[level].empty()) {
+            REPORT("Convex hull support (%s): %.1f ns/search, including transforms",
+                    LEVEL_NAMES[level], NS_PER_US * elapsedUs[level] / searchCount);
+        }
+    }
+}
+
+/// @brief Measures GJK collision checks between object colliders.
+/// @details Random boxes, spheres and convex hulls are rotated and placed so that about half of
+/// the pairs overlap, as objects are mostly checked once their bounding spheres overlap. The race
+/// is restored to its current state afterwards.
+void KBenchSystem::benchObjectCollision() {
+    typedef Field::ObjectCollisionBase Collider;
+
+    constexpr u32 COLLIDER_COUNT = 256;
+    constexpr u32 HULL_POINT_COUNT = 12;
+    constexpr u32 PASSES = 50;
+
+    Host::Context base;
+    EGG::Heap *heap = m_sceneMgr->currentScene()->heap();
+    heap->enableAllocation();
+
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<f32> extent(100.0f, 400.0f);
+    std::uniform_real_distribution<f32> angle(-F_PI, F_PI);
+    std::uniform_real_distribution<f32> offset(-300.0f, 300.0f);
+
+    std::vector<std::unique_ptr<Collider>> colliders;
+    for (u32 i = 0; i < COLLIDER_COUNT; ++i) {
+        switch (i % 3) {
+        case 0:
+            colliders.push_back(std::make_unique<Field::ObjectCollisionBox>(extent(rng),
+                    extent(rng), extent(rng), EGG::Vector3f::zero));
+            break;
+        case 1:
+            colliders.push_back(std::make_unique<Field::ObjectCollisionSphere>(extent(rng),
+                    EGG::Vector3f::zero));
+            break;
+        default: {
+            std::vector<EGG::Vector3f> points(HULL_POINT_COUNT);
+            for (auto &point : points) {
+                point = EGG::Vector3f(offset(rng), offset(rng), offset(rng));
+            }
+
+            colliders.push_back(std::make_unique<Field::ObjectCollisionConvexHull>(points));
+        } break;
+        }
+
+        EGG::Matrix34f mat;
+        mat.makeRT(EGG::Vector3f(angle(rng), angle(rng), angle(rng)),
+                EGG::Vector3f(offset(rng), offset(rng), offset(rng)));
+        colliders.back()->transform(mat, EGG::Vector3f::unit);
+    }
+
+    // Pair every collider with the next, and with one a quarter of the way around
+    std::vector<std::pair<Collider *, Collider *>> pairs;
+    for (u32 i = 0; i < COLLIDER_COUNT; ++i) {
+        for (u32 step : {1u, COLLIDER_COUNT / 4}) {
+            pairs.emplace_back(colliders[i].get(), colliders[(i + step) % COLLIDER_COUNT].get());
+        }
+    }
+
+    u32 overlaps = 0;
+    f64 checks = static_cast<f64>(PASSES) * static_cast<f64>(pairs.size());
+    f64 elapsedUs = measure("objectCollision.check", "check", checks, [&] {
+        EGG::Vector3f distance;
+
+        overlaps = 0;
+        for (u32 i = 0; i < PASSES; ++i) {
+            for (auto [lhs, rhs] : pairs) {
+                overlaps += lhs->check(*rhs, distance);
+            }
+        }
+    });
+
+    // The colliders must be freed before restoring the heap they were allocated from
+    pairs.clear();
+    colliders.clear();
+    heap->disableAllocation();
+    Host::Context::SetActiveContext(base);
+
+    REPORT("Object collision: %.1f ns/check (%.0f%% of pairs overlap)",
+            NS_PER_US * elapsedUs / checks, 100.0 * static_cast<f64>(overlaps) / checks);
+}
+
+/// @brief Measures area lookups per second, with and without the area index.
+/// @details Lookups are made for every area type on the course, over recorded kart positions,
+/// random positions within the course and positions near each area. Both ways of looking up an
+/// area must find the same one.
+void KBenchSystem::benchAreaLookup() {
+    constexpr u16 FRAMES = 600;
+    constexpr u32 RANDOM_COUNT = 4096;
+    constexpr u32 NEARBY_COUNT = 64;
+    constexpr u32 PASSES = 50;
+
+    auto *courseMap = System::CourseMap::Instance();
+    if (courseMap->getAreaCount() == 0) {
+        REPORT("Area lookup: this course has no areas");
+        return;
+    }
+
+    std::vector<EGG::Vector3f> positions = recordKartPositions(FRAMES);
+
+    std::mt19937 rng(0);
+    const EGG::BoundBox3f &bbox = Field::CourseColMgr::Instance()->data()->bbox();
+    std::uniform_real_distribution<f32> x(bbox.min.x, bbox.max.x);
+    std::uniform_real_distribution<f32> y(bbox.min.y, bbox.max.y);
+    std::uniform_real_distribution<f32> z(bbox.min.z, bbox.max.z);
+    for (u32 i = 0; i < RANDOM_COUNT; ++i) {
+        positions.emplace_back(x(rng), y(rng), z(rng));
+    }
+
+    std::vector<System::MapdataAreaBase::Type> types;
+    std::uniform_real_distribution<f32> offset(-1.0f, 1.0f);
+    for (u16 i = 0; i < courseMap->getAreaCount(); ++i) {
+        const System::MapdataAreaBase *area = courseMap->getArea(i);
+        if (std::find(types.begin(), types.end(), area->type()) == types.end()) {
+            types.push_back(area->type());
+        }
+
+        // Most of these land near the area's edges, where the index must not miss it
+        f32 radius = std::sqrt(area->sqBoundingSphereRadius());
+        for (u32 j = 0; j < NEARBY_COUNT; ++j) {
+            EGG::Vector3f dir(offset(rng), offset(rng), offset(rng));
+            positions.push_back(area->position() + dir * radius);
+        }
+    }
+
+    std::array<f64, 2> elapsedUs = {};
+    std::array<std::vector<s16>, 2> areaIds;
+    for (bool indexed : {false, true}) {
+        System::MapdataAreaAccessor::SetIndexEnabled(indexed);
+
+        s32 sink = 0;
+        auto t0 = Clock::now();
+        for (u32 i = 0; i < PASSES; ++i) {
+            for (auto type : types) {
+                for (const auto &pos : positions) {
+                    sink += courseMap->getCurrentAreaID(-1, pos, type);
+                }
+            }
+        }
+        elapsedUs[indexed] = ElapsedUs(t0, Clock::now());
+        s_sink = sink;
+
+        for (auto type : types) {
+            for (const auto &pos : positions) {
+                areaIds[indexed].push_back(courseMap->getCurrentAreaID(-1, pos, type));
+            }
+        }
+    }
+
+    System::MapdataAreaAccessor::SetIndexEnabled(true);
+
+    u32 mismatches = 0;
+    u32 hits = 0;
+    for (size_t i = 0; i < areaIds[0].size(); ++i) {
+        mismatches += areaIds[0][i] != areaIds[1][i];
+        hits += areaIds[0][i] >= 0;
+    }
+
+    if (mismatches > 0) {
+        WARN("%u of %zu indexed area lookups did not match the scan", mismatches,
+                areaIds[0].size());
+        ++m_failedChecks;
+    }
+
+    f64 lookups = static_cast<f64>(PASSES) * static_cast<f64>(areaIds[0].size());
+    REPORT("Area lookup (%u areas, %zu types, %u of %zu in an area): %.0f lookups/s (scan), "
+           "%.0f lookups/s (indexed)",
+            courseMap->getAreaCount(), types.size(), hits, areaIds[0].size(),
+            US_PER_SECOND * lookups / elapsedUs[0], US_PER_SECOND * lookups / elapsedUs[1]);
+}
+
+/// @brief Counts the checkpoint sector tests made by findSector, with and without the sector index.
+/// @details Sectors are searched for from every checkpoint over recorded kart positions and random
+/// positions within the course, most of which are off track and fall back to the regional search.
+/// Both ways of searching must find the same checkpoint and distance ratio. The race is then run
+/// either way to count tests per frame. The race is restored to its current state afterwards.
+void KBenchSystem::benchSectorSearch() {
+    typedef System::CourseMap CourseMap;
+
+    constexpr u16 FRAMES = 600;
+    constexpr u32 RANDOM_COUNT = 1024;
+    constexpr u32 PASSES = 5;
+
+    auto *courseMap = CourseMap::Instance();
+    u16 checkpointCount = courseMap->getCheckPointCount();
+    if (checkpointCount == 0 || courseMap->getCheckPathCount() == 0) {
+        REPORT("Sector search: this course has no checkpoints");
+        return;
+    }
+
+    std::vector<EGG::Vector3f> positions = recordKartPositions(FRAMES);
+
+    std::mt19937 rng(0);
+    const EGG::BoundBox3f &bbox = Field::CourseColMgr::Instance()->data()->bbox();
+    std::uniform_real_distribution<f32> x(bbox.min.x, bbox.max.x);
+    std::uniform_real_distribution<f32> y(bbox.min.y, bbox.max.y);
+    std::uniform_real_distribution<f32> z(bbox.min.z, bbox.max.z);
+    for (u32 i = 0; i < RANDOM_COUNT; ++i) {
+        positions.emplace_back(x(rng), y(rng), z(rng));
+    }
+
+    Host::Context base;
+
+    std::array<f64, 2> elapsedUs = {};
+    std::array<CourseMap::SectorSearchStats, 2> searchStats;
+    std::array<std::vector<std::pair<s16, u32>>, 2> sectors;
+    for (bool indexed : {false, true}) {
+        System::MapdataCheckPointAccessor::SetSectorIndexEnabled(indexed);
+        CourseMap::ResetSectorSearchStats();
+
+        s32 sink = 0;
+        auto t0 = Clock::now();
+        for (u32 i = 0; i < PASSES; ++i) {
+            for (size_t j = 0; j < positions.size(); ++j) {
+                f32 distanceRatio;
+                sink += courseMap->findSector(positions[j], j % checkpointCount, distanceRatio);
+            }
+        }
+        elapsedUs[indexed] = ElapsedUs(t0, Clock::now());
+        searchStats[indexed] = CourseMap::GetSectorSearchStats();
+        s_sink = sink;
+
+        for (size_t j = 0; j < positions.size(); ++j) {
+            f32 distanceRatio;
+            s16 id = courseMap->findSector(positions[j], j % checkpointCount, distanceRatio);
+            sectors[indexed].emplace_back(id, id != -1 ? f2u(distanceRatio) : 0);
+        }
+    }
+
+    u32 mismatches = 0;
+    for (size_t i = 0; i < positions.size(); ++i) {
+        mismatches += sectors[0][i] != sectors[1][i];
+    }
+
+    if (mismatches > 0) {
+        WARN("%u of %zu indexed sector searches did not match the full search", mismatches,
+                positions.size());
+        ++m_failedChecks;
+    }
+
+    // The race itself mostly finds the sector locally, as the kart stays on track
+    std::array<CourseMap::SectorSearchStats, 2> raceStats;
+    for (bool indexed : {false, true}) {
+        Host::Context::SetActiveContext(base);
+        System::MapdataCheckPointAccessor::SetSectorIndexEnabled(indexed);
+        CourseMap::ResetSectorSearchStats();
+
+        for (u16 i = 0; i < FRAMES; ++i) {
+            calc();
+        }
+
+        raceStats[indexed] = CourseMap::GetSectorSearchStats();
+    }
+
+    System::MapdataCheckPointAccessor::SetSectorIndexEnabled(true);
+    CourseMap::ResetSectorSearchStats();
+    Host::Context::SetActiveContext(base);
+
+    f64 searches = static_cast<f64>(searchStats[0].searches);
+    f64 frames = static_cast<f64>(FRAMES);
+    REPORT("Sector search (%u checkpoints): %.1f tests/search (full), %.1f tests/search "
+           "(indexed, %.1f skipped)",
+            checkpointCount, static_cast<f64>(searchStats[0].tests) / searches,
+            static_cast<f64>(searchStats[1].tests) / searches,
+            static_cast<f64>(searchStats[1].skippedTests) / searches);
+    REPORT("Sector search: %.0f searches/s (full), %.0f searches/s (indexed)",
+            US_PER_SECOND * searches / elapsedUs[0], US_PER_SECOND * searches / elapsedUs[1]);
+    REPORT("Sector search (%u frames): %.2f tests/frame (full), %.2f tests/frame (indexed)", FRAMES,
+            static_cast<f64>(raceStats[0].tests) / frames,
+            static_cast<f64>(raceStats[1].tests) / frames);
+}
+
+} // namespace Kinoko
@@ -0,0 +1,210 @@
+#include "host/KBenchSystem.hh"
+
+#include "host/BranchExplorer.hh"
+#include "host/Context.hh"
+#include "host/RewindBuffer.hh"
+
+#include <game/kart/KartObjectManager.hh>
+
+#include <algorithm>
+#include <cstdio>
+
+namespace Kinoko {
+
+/// @brief Measures the save and restore throughput of Host::Context.
+/// @details This mirrors an input search: restore a base state, advance a frame, and save the
+/// result. In incremental mode, the frame time also includes the write faults of dirty tracking.
+/// Each phase is measured over its own repetitions of the whole cycle. The system itself lives in
+/// the heap, so all measurements are kept on the stack.
+/// @param incremental Whether to only copy the heap pages modified since the last sync.
+void KBenchSystem::benchContext(bool incremental) {
+    constexpr size_t ITERATIONS = 500;
+
+    const char *modeName = incremental ? "incremental" : "full";
+    if (incremental && !Host::Context::EnableIncremental()) {
+        WARN("Incremental contexts are not supported on this host");
+        return;
+    }
+
+    Host::Context base;
+    Host::Context scratch;
+
+    auto cycle = [&](size_t phase) {
+        f64 phaseUs = 0.0;
+        for (size_t i = 0; i < ITERATIONS; ++i) {
+            auto t0 = Clock::now();
+            Host::Context::SetActiveContext(base);
+            auto t1 = Clock::now();
+            calc();
+            auto t2 = Clock::now();
+            scratch.save();
+            auto t3 = Clock::now();
+
+            std::array<f64, 3> times = {{ElapsedUs(t0, t1), ElapsedUs(t1, t2), ElapsedUs(t2, t3)}};
+            phaseUs += times[phase];
+        }
+
+        return phaseUs;
+    };
+
+    char name[64];
+    f64 iterations = static_cast<f64>(ITERATIONS);
+    snprintf(name, sizeof(name), "context.%s.restore", modeName);
+    f64 restoreUs = measure(name, "restore", iterations, [&] { return cycle(0); });
+    snprintf(name, sizeof(name), "context.%s.frame", modeName);
+    f64 calcUs = measure(name, "frame", iterations, [&] { return cycle(1); });
+    snprintf(name, sizeof(name), "context.%s.save", modeName);
+    f64 saveUs = measure(name, "save", iterations, [&] { return cycle(2); });
+
+    // Leave the race where we found it for subsequent benchmarks
+    Host::Context::SetActiveContext(base);
+
+    if (incremental) {
+        Host::Context::DisableIncremental();
+    }
+
+    REPORT("Context (%s): %.0f restores/s, %.0f saves/s, %.2f us/frame", modeName,
+            US_PER_SECOND * iterations / restoreUs, US_PER_SECOND * iterations / saveUs,
+            calcUs / iterations);
+}
+
+/// @brief Measures the throughput of exploring race branches in forked processes.
+/// @details Each branch advances the race and reports the kart's position. For comparison, the same
+/// branches are then explored in-process by restoring a Host::Context before each of them, which
+/// also provides the expected position every branch must report.
+/// @param maxConcurrent The maximum number of branches alive at once.
+void KBenchSystem::benchBranch(u32 maxConcurrent) {
+    constexpr u32 BRANCHES = 256;
+    constexpr u16 FRAMES_PER_BRANCH = 60;
+
+    if (!Host::BranchExplorer::IsSupported()) {
+        WARN("Forked branches are not supported on this host");
+        return;
+    }
+
+    auto explore = [this](u32 /* id */, Host::BranchExplorer::Payload &payload) {
+        for (u16 i = 0; i < FRAMES_PER_BRANCH; ++i) {
+            calc();
+        }
+
+        const EGG::Vector3f &pos = Kart::KartObjectManager::Instance()->object(0)->pos();
+        const u8 *data = reinterpret_cast<const u8 *>(&pos);
+        payload.insert(payload.end(), data, data + sizeof(EGG::Vector3f));
+    };
+
+    Host::Context base;
+    Host::BranchExplorer::Payload expected;
+
+    auto t0 = Clock::now();
+    for (u32 i = 0; i < BRANCHES; ++i) {
+        expected.clear();
+        explore(i, expected);
+        Host::Context::SetActiveContext(base);
+    }
+    auto t1 = Clock::now();
+
+    u32 mismatches = 0;
+    auto onResult = [&](u32 /* id */, bool success, const Host::BranchExplorer::Payload &payload) {
+        if (!success || payload != expected) {
+            ++mismatches;
+        }
+    };
+
+    auto t2 = Clock::now();
+    {
+        Host::BranchExplorer explorer(onResult, maxConcurrent);
+        for (u32 i = 0; i < BRANCHES; ++i) {
+            explorer.spawn(i, explore);
+        }
+    }
+    auto t3 = Clock::now();
+
+    if (mismatches > 0) {
+        WARN("%u of %u branches did not match the in-process result", mismatches, BRANCHES);
+        ++m_failedChecks;
+    }
+
+    f64 branches = static_cast<f64>(BRANCHES);
+    REPORT("Branch (%u concurrent, %d frames): %.0f forked branches/s, %.0f context branches/s",
+            maxConcurrent, FRAMES_PER_BRANCH, US_PER_SECOND * branches / ElapsedUs(t2, t3),
+            US_PER_SECOND * branches / ElapsedUs(t0, t1));
+}
+
+/// @brief Measures the memory use of a rewind history and the time to seek back through it.
+/// @details The kart's position is recorded alongside every frame, and must match again after each
+/// seek. After seeking back, the race is simulated forward again to refill the history.
+void KBenchSystem::benchRewind() {
+    constexpr u32 FRAMES = 1200;
+    constexpr u32 KEYFRAME_INTERVAL = 300;
+    constexpr size_t BUDGET = 256 * 1024 * 1024;
+    constexpr std::array<u32, 5> SEEK_DISTANCES = {{1, 10, 60, 300, FRAMES}};
+
+    bool incremental = Host::Context::EnableIncremental();
+    if (!incremental) {
+        WARN("Incremental contexts are not supported on this host, recording compares the heap");
+    }
+
+    auto kartPos = []() { return Kart::KartObjectManager::Instance()->object(0)->pos(); };
+
+    Host::Context base;
+    std::vector<EGG::Vector3f> positions;
+    positions.push_back(kartPos());
+
+    {
+        Host::RewindBuffer rewind(BUDGET, KEYFRAME_INTERVAL);
+
+        f64 recordUs = 0.0;
+        for (u32 i = 0; i < FRAMES; ++i) {
+            calc();
+            positions.push_back(kartPos());
+
+            auto t0 = Clock::now();
+            rewind.record();
+            recordUs += ElapsedUs(t0, Clock::now());
+        }
+
+        constexpr f64 BYTES_PER_KIB = 1024.0;
+        f64 frames = static_cast<f64>(FRAMES);
+        REPORT("Rewind (%u frames, keyframe every %u): %.1f KiB/frame of deltas, %.1f MiB total, "
+               "%.2f us/record",
+                FRAMES, KEYFRAME_INTERVAL,
+                static_cast<f64>(rewind.deltaSize()) / BYTES_PER_KIB / frames,
+                static_cast<f64>(rewind.historySize()) / BYTES_PER_KIB / BYTES_PER_KIB,
+                recordUs / frames);
+
+        u32 mismatches = 0;
+        for (u32 distance : SEEK_DISTANCES) {
+            u32 newest = rewind.newestFrame();
+            u32 target = newest - std::min(distance, newest - rewind.oldestFrame());
+
+            auto t0 = Clock::now();
+            rewind.seek(target);
+            auto t1 = Clock::now();
+
+            if (kartPos() != positions[target]) {
+                ++mismatches;
+            }
+
+            REPORT("Rewind: seeking back %u frames took %.2f us", newest - target,
+                    ElapsedUs(t0, t1));
+
+            for (u32 frame = target; frame < newest; ++frame) {
+                calc();
+                rewind.record();
+            }
+        }
+
+        if (mismatches > 0) {
+            WARN("%u rewinds did not restore the recorded kart position", mismatches);
+            ++m_failedChecks;
+        }
+    }
+
+    Host::Context::SetActiveContext(base);
+
+    if (incremental) {
+        Host::Context::DisableIncremental();
+    }
+}
+
+} // namespace Kinoko
@@ -0,0 +1,217 @@
+#include "host/KBenchSystem.hh"
+
+#include <game/system/GhostTimeline.hh>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <span>
+
+namespace Kinoko {
+
+/// @brief Reads a ghost's inputs one frame at a time, from its run-length encoded streams.
+/// @details This is how KPadGhostController read ghosts before they were decoded into a
+/// System::GhostTimeline, and is kept as a baseline and as the reference for differential checks.
+/// @param inputs The uncompressed input data section.
+/// @param frameCount The number of frames to read.
+/// @param onFrame Called with the index and inputs of every frame.
+template <typename F>
+static void ReadGhostStreams(const u8 *inputs, size_t frameCount, F &&onFrame) {
+    System::KPadGhostFaceButtonsStream face;
+    System::KPadGhostDirectionButtonsStream direction;
+    System::KPadGhostTrickButtonsStream trick;
+    std::array<System::KPadGhostButtonsStream *, 3> streams = {&face, &direction, &trick};
+
+    EGG::RamStream stream(inputs, System::RKG_UNCOMPRESSED_INPUT_DATA_SECTION_SIZE);
+    std::array<u16, 3> counts;
+    for (u16 &count : counts) {
+        count = stream.read_u16();
+    }
+    stream.skip(2);
+
+    for (size_t i = 0; i < streams.size(); ++i) {
+        streams[i]->buffer = stream.split(counts[i] * 2);
+        streams[i]->currentSequence = 0;
+        streams[i]->readSequenceFrames = 0;
+        streams[i]->state = 1;
+    }
+
+    System::RaceInputState state;
+    for (size_t frame = 0; frame < frameCount; ++frame) {
+        state.buttons = streams[0]->readFrame();
+        u8 sticks = streams[1]->readFrame();
+        state.stickXRaw = sticks >> 4 & 0xF;
+        state.stickYRaw = sticks & 0xF;
+        state.stick = EGG::Vector2f(System::RawStickToState(state.stickXRaw),
+                System::RawStickToState(state.stickYRaw));
+        state.trickRaw = streams[2]->readFrame();
+
+        u8 trickDirection = state.trickRaw >> 4;
+        state.trick = trickDirection >= 1 && trickDirection <= 4 ?
+                static_cast<System::Trick>(trickDirection) :
+                System::Trick::None;
+
+        onFrame(frame, state);
+    }
+}
+
+/// @brief Measures decoding and encoding ghosts, and reading a frame of one at random.
+/// @details Every ghost next to the benchmarked one is decoded into a timeline, which must play
+/// back exactly as its streams read. The timeline, and an edited copy of it, are then written with
+/// and without compression, and must play back the same once read again. Reading a frame at random
+/// is compared to the streams, which can only reach it by reading every frame before it.
+void KBenchSystem::benchGhostTimeline() {
+    constexpr u32 SEEK_COUNT = 0x100;
+
+    auto samePlayback = [](const System::GhostTimeline &lhs, const System::GhostTimeline &rhs) {
+        for (size_t i = 0; i <= std::max(lhs.size(), rhs.size()); ++i) {
+            const auto &l = lhs.playback(i);
+            const auto &r = rhs.playback(i);
+            if (l.buttons != r.buttons || l.stickXRaw != r.stickXRaw ||
+                    l.stickYRaw != r.stickYRaw || l.trick != r.trick) {
+                return false;
+            }
+        }
+
+        return true;
+    };
+
+    std::vector<u8> inputs(System::RKG_UNCOMPRESSED_INPUT_DATA_SECTION_SIZE);
+    std::vector<u8> rkg(System::RKG_MAX_WRITE_SIZE);
+
+    // Writes the timeline, and checks that it plays back the same once read again
+    auto roundTrip = [&](const System::RawGhostFile &raw, const System::GhostTimeline &timeline,
+                             bool compress) {
+        size_t size = timeline.writeRKG(raw, rkg.data(), compress);
+        if (size == 0) {
+            return static_cast<size_t>(0);
+        }
+
+        auto written = std::make_unique<System::RawGhostFile>(rkg.data());
+        System::GhostTimeline reread(written->buffer() + System::RKG_HEADER_SIZE);
+        return samePlayback(timeline, reread) ? size : 0;
+    };
+
+    std::filesystem::path directory = std::filesystem::path(m_ghostFileName).parent_path();
+    if (directory.empty()) {
+        directory = ".";
+    }
+
+    u32 ghostCount = 0;
+    u32 identicalCount = 0;
+    u32 mismatches = 0;
+    size_t frameCount = 0;
+    size_t originalSize = 0;
+    size_t compressedSize = 0;
+
+    for (const auto &entry : std::filesystem::directory_iterator(directory)) {
+        if (entry.path().extension() != ".rkg") {
+            continue;
+        }
+
+        std::vector<u8> file = ReadFile(entry.path().string().c_str());
+        auto raw = std::make_unique<System::RawGhostFile>(file.data());
+        const u8 *original = raw->buffer() + System::RKG_HEADER_SIZE;
+
+        System::GhostTimeline timeline(original);
+        bool decoded = true;
+        ReadGhostStreams(original, timeline.size() + 1,
+                [&](size_t frame, const System::RaceInputState &state) {
+                    const auto &actual = timeline.playback(frame);
+                    decoded &= actual.buttons == state.buttons &&
+                            actual.stick.x == state.stick.x && actual.stick.y == state.stick.y &&
+                            actual.stickXRaw == state.stickXRaw &&
+                            actual.stickYRaw == state.stickYRaw &&
+                            actual.trickRaw == state.trickRaw && actual.trick == state.trick;
+                });
+
+        // The header of the section is the number of tuples in each stream
+        size_t originalInputSize = 0x8;
+        for (size_t i = 0; i < 3; ++i) {
+            originalInputSize += 2 * (original[2 * i] << 8 | original[2 * i + 1]);
+        }
+
+        size_t inputSize = timeline.encode(inputs.data());
+        bool identical = inputSize == originalInputSize &&
+                memcmp(inputs.data(), original, inputSize) == 0;
+        identicalCount += identical;
+
+        // Loop a stretch of the ghost over a later one, and drop some items along the way
+        System::GhostTimeline edited = timeline;
+        size_t third = edited.size() / 3;
+        if (third > 0) {
+            edited.splice(third, third / 2, std::span(&timeline[0], third));
+        }
+        for (size_t i = 0; i < edited.size(); i += 60) {
+            edited[i].buttons ^= 0x4;
+        }
+
+        size_t compressed = roundTrip(*raw, timeline, true);
+        if (!decoded || compressed == 0 || roundTrip(*raw, timeline, false) == 0 ||
+                roundTrip(*raw, edited, true) == 0) {
+            WARN("%s does not round trip", entry.path().string().c_str());
+            ++mismatches;
+            ++m_failedChecks;
+        }
+
+        ++ghostCount;
+        frameCount += timeline.size();
+        originalSize += file.size();
+        compressedSize += compressed;
+    }
+
+    if (ghostCount == 0) {
+        WARN("No ghosts were found next to %s", m_ghostFileName);
+        return;
+    }
+
+    REPORT("GhostTimeline: %u ghosts (%zu frames) round tripped, %u mismatched, %u with identical "
+           "inputs, %zu bytes compressed (%zu originally)",
+            ghostCount, frameCount, mismatches, identicalCount, compressedSize, originalSize);
+
+    auto raw = std::make_unique<System::RawGhostFile>(m_rawGhost);
+    const u8 *original = raw->buffer() + System::RKG_HEADER_SIZE;
+    System::GhostTimeline timeline(original);
+
+    std::mt19937 rng(0);
+    std::vector<size_t> seeks(SEEK_COUNT);
+    for (auto &seek : seeks) {
+        seek = rng() % timeline.size();
+    }
+
+    f64 frames = static_cast<f64>(timeline.size());
+    f64 decodeUs = measure("ghost.decode", "frame", frames, [&] {
+        System::GhostTimeline decoded(original);
+        s_sink = decoded.size();
+    });
+    f64 encodeUs = measure("ghost.encode", "frame", frames,
+            [&] { s_sink = timeline.writeRKG(*raw, rkg.data(), true); });
+
+    f64 seekCount = static_cast<f64>(SEEK_COUNT);
+    f64 streamSeekUs = measure("ghost.seekStreams", "seek", seekCount, [&] {
+        u32 sink = 0;
+        for (size_t seek : seeks) {
+            ReadGhostStreams(original, seek + 1,
+                    [&](size_t frame, const System::RaceInputState &state) {
+                        sink += frame == seek ? state.buttons : 0;
+                    });
+        }
+        s_sink = sink;
+    });
+    f64 seekUs = measure("ghost.seek", "seek", seekCount, [&] {
+        u32 sink = 0;
+        for (size_t seek : seeks) {
+            sink += timeline.playback(seek).buttons;
+        }
+        s_sink = sink;
+    });
+
+    REPORT("GhostTimeline (%zu frames): %.1f ns/frame decode, %.1f ns/frame compressed encode, "
+           "%.1f us/seek with streams, %.1f ns/seek",
+            timeline.size(), NS_PER_US * decodeUs / frames, NS_PER_US * encodeUs / frames,
+            streamSeekUs / seekCount, NS_PER_US * seekUs / seekCount);
+}
+
+} // namespace Kinoko
@@ -0,0 +1,58 @@
+#include "host/KBenchSystem.hh"
+
+#include <egg/math/Math.hh>
+
+#include <cmath>
+#include <random>
+
+namespace Kinoko {
+
+/// @brief Computes EGG::Mathf::frsqrt with the double-precision frsqrte.
+/// @details This is how frsqrt worked before frsqrte handled floats directly, and is kept as a
+/// baseline.
+static f32 FrsqrtDoubleEstimate(f32 x) {
+    f64 est = EGG::Mathf::frsqrte(static_cast<f64>(x));
+
+    f32 tmp0 = static_cast<f32>(est * EGG::Mathf::force25Bit(est));
+    f32 tmp1 = static_cast<f32>(est * static_cast<f64>(0.5f));
+    f32 tmp2 =
+            static_cast<f32>(static_cast<f64>(3.0f) - static_cast<f64>(tmp0) * static_cast<f64>(x));
+    return tmp1 * tmp2;
+}
+
+/// @brief Measures the throughput of frsqrt with the single and double-precision frsqrte.
+/// @details That both match on every float is checked by the frsqrt test.
+void KBenchSystem::benchFrsqrt() {
+    constexpr u32 SAMPLE_COUNT = 1 << 16;
+    constexpr u32 PASSES = 50;
+
+    // Squared lengths in the game are positive and mostly span a few orders of magnitude
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<f32> exponent(-8.0f, 16.0f);
+    std::vector<f32> samples(SAMPLE_COUNT);
+    for (auto &sample : samples) {
+        sample = std::exp2(exponent(rng));
+    }
+
+    std::vector<f32> results(SAMPLE_COUNT);
+    auto compute = [&](auto &&func) {
+        for (u32 i = 0; i < PASSES; ++i) {
+            for (u32 j = 0; j < SAMPLE_COUNT; ++j) {
+                results[j] = func(samples[j]);
+            }
+
+            s_sink = f2u(results[i % SAMPLE_COUNT]);
+        }
+    };
+
+    f64 calls = static_cast<f64>(PASSES) * static_cast<f64>(SAMPLE_COUNT);
+    f64 referenceUs = measure("frsqrt.doubleEstimate", "call", calls,
+            [&] { compute(FrsqrtDoubleEstimate); });
+    f64 floatUs = measure("frsqrt", "call", calls,
+            [&] { compute([](f32 x) { return EGG::Mathf::frsqrt(x); }); });
+
+    REPORT("frsqrt: %.2f ns/call (double estimate), %.2f ns/call (float estimate)",
+            NS_PER_US * referenceUs / calls, NS_PER_US * floatUs / calls);
+}
+
+} // namespace Kinoko
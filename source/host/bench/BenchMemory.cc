@@ -0,0 +1,162 @@
+#include "host/KBenchSystem.hh"
+
+#include "host/SceneId.hh"
+
+#include <egg/core/ExpHeap.hh>
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <unordered_map>
+
+namespace Kinoko {
+
+/// @brief Measures allocations and frees on an expanded heap, with and without size classes.
+/// @details A fixed sequence of random allocations and frees is replayed onto a fresh heap outside
+/// of the arena, keeping a few hundred blocks alive at once. Sizes are mostly small, like those of
+/// the race's objects, with the occasional large buffer.
+void KBenchSystem::benchExpHeap() {
+    constexpr size_t HEAP_SIZE = 0x400000;
+    constexpr u32 SLOT_COUNT = 512;
+    constexpr u32 OPERATION_COUNT = 1 << 16;
+
+    struct Operation {
+        u32 slot;
+        u32 size;
+        s32 align;
+    };
+
+    std::mt19937 rng(0);
+    std::vector<Operation> operations(OPERATION_COUNT);
+    for (auto &operation : operations) {
+        operation.slot = rng() % SLOT_COUNT;
+        operation.size = rng() % 16 == 0 ? 0x400 + rng() % 0x2000 : 4 + rng() % 0x100;
+        operation.align = rng() % 4 == 0 ? 32 : 4;
+    }
+
+    std::vector<u8> buffer(HEAP_SIZE);
+    std::vector<void *> blocks(SLOT_COUNT);
+    u32 failures = 0;
+
+    // An operation frees the slot's block if it has one, or allocates one into it otherwise
+    auto replay = [&](u16 opt) {
+        EGG::ExpHeap *heap = EGG::ExpHeap::create(buffer.data(), buffer.size(), opt);
+        ASSERT(heap);
+        std::fill(blocks.begin(), blocks.end(), nullptr);
+
+        auto t0 = Clock::now();
+        for (const auto &operation : operations) {
+            void *&block = blocks[operation.slot];
+            if (block) {
+                heap->free(block);
+                block = nullptr;
+            } else {
+                block = heap->alloc(operation.size, operation.align);
+                failures += !block;
+            }
+        }
+        f64 elapsedUs = ElapsedUs(t0, Clock::now());
+
+        heap->destroy();
+        return elapsedUs;
+    };
+
+    using OptFlag = Abstract::Memory::MEMiHeapHead::OptFlag;
+    using eOptFlag = Abstract::Memory::MEMiHeapHead::eOptFlag;
+
+    f64 count = static_cast<f64>(OPERATION_COUNT);
+    f64 baseUs = measure("expHeap.allocFree", "operation", count,
+            [&] { return replay(DEFAULT_OPT); });
+    f64 sizeClassUs = measure("expHeap.allocFree.sizeClasses", "operation", count,
+            [&] { return replay(OptFlag(DEFAULT_OPT).setBit(eOptFlag::SizeClasses)); });
+
+    if (failures > 0) {
+        WARN("%u allocations failed", failures);
+        ++m_failedChecks;
+    }
+
+    REPORT("ExpHeap: %.1f ns/operation, %.1f ns/operation with size classes",
+            NS_PER_US * baseUs / count, NS_PER_US * sizeClassUs / count);
+}
+
+/// @brief Replays the allocations made on the scene heap while creating the race scene.
+/// @details The trace is recorded once, and replayed onto a fresh heap of the same size, with and
+/// without size classes. Every allocation that succeeded while recording must succeed again.
+void KBenchSystem::benchAllocationTrace() {
+    constexpr u32 REPETITIONS = 20;
+
+    std::vector<EGG::ExpHeap::TraceEvent> trace;
+    m_sceneMgr->destroyScene(m_sceneMgr->currentScene());
+    EGG::ExpHeap::SetTrace(&trace);
+    m_sceneMgr->createScene(static_cast<int>(Host::SceneId::Race), m_sceneMgr->currentScene());
+    EGG::ExpHeap::SetTrace(nullptr);
+
+    EGG::Heap *sceneHeap = m_sceneMgr->currentScene()->heap();
+    std::erase_if(trace, [sceneHeap](const EGG::ExpHeap::TraceEvent &event) {
+        return event.heap != sceneHeap || !event.block;
+    });
+
+    // Pair each free with the allocation it releases, so that replays don't search for blocks
+    constexpr size_t NO_ALLOCATION = std::numeric_limits<size_t>::max();
+    std::vector<size_t> allocations(trace.size(), NO_ALLOCATION);
+    u32 allocCount = 0;
+    {
+        std::unordered_map<void *, size_t> live;
+        for (size_t i = 0; i < trace.size(); ++i) {
+            if (!trace[i].isFree) {
+                live[trace[i].block] = i;
+                ++allocCount;
+            } else if (auto it = live.find(trace[i].block); it != live.end()) {
+                allocations[i] = it->second;
+                live.erase(it);
+            }
+        }
+    }
+
+    size_t heapSize = GetAddrNum(sceneHeap->getEndAddress()) -
+            GetAddrNum(sceneHeap->getStartAddress());
+    std::vector<u8> buffer(heapSize);
+    std::vector<void *> blocks(trace.size());
+
+    auto replay = [&](u16 opt, u32 &failures) {
+        f64 elapsedUs = 0.0;
+
+        for (u32 i = 0; i < REPETITIONS; ++i) {
+            EGG::ExpHeap *heap = EGG::ExpHeap::create(buffer.data(), buffer.size(), opt);
+            ASSERT(heap);
+
+            auto t0 = Clock::now();
+            for (size_t j = 0; j < trace.size(); ++j) {
+                const auto &event = trace[j];
+                if (!event.isFree) {
+                    blocks[j] = heap->alloc(event.size, event.align);
+                    failures += !blocks[j];
+                } else if (allocations[j] != NO_ALLOCATION) {
+                    heap->free(blocks[allocations[j]]);
+                }
+            }
+            elapsedUs += ElapsedUs(t0, Clock::now());
+
+            heap->destroy();
+        }
+
+        return elapsedUs / static_cast<f64>(REPETITIONS);
+    };
+
+    using OptFlag = Abstract::Memory::MEMiHeapHead::OptFlag;
+    using eOptFlag = Abstract::Memory::MEMiHeapHead::eOptFlag;
+
+    u32 failures = 0;
+    f64 baseUs = replay(DEFAULT_OPT, failures);
+    f64 sizeClassUs = replay(OptFlag(DEFAULT_OPT).setBit(eOptFlag::SizeClasses), failures);
+
+    if (failures > 0) {
+        WARN("%u replayed allocations failed", failures);
+        ++m_failedChecks;
+    }
+
+    REPORT("Allocation trace (%u allocations, %zu frees): %.2f us, %.2f us with size classes",
+            allocCount, trace.size() - allocCount, baseUs, sizeClassUs);
+}
+
+} // namespace Kinoko
@@ -0,0 +1,370 @@
+#include "host/KBenchSystem.hh"
+
+#include "host/Arena.hh"
+#include "host/Context.hh"
+#include "host/DirtyPageTracker.hh"
+#include "host/SceneCreatorDynamic.hh"
+#include "host/SceneId.hh"
+
+#include <game/field/ObjectDrivableDirector.hh>
+
+#include <game/kart/KartObjectManager.hh>
+
+#include <game/scene/GameScene.hh>
+
+#include <game/system/ResourceManager.hh>
+
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace Kinoko {
+
+/// @brief Measures frames per second with and without headless mode.
+/// @details Both runs start from the same state, and the kart must be in the same position after
+/// every frame. Each repetition then replays the same frames from that state. The race is restored
+/// to its current state afterwards.
+void KBenchSystem::benchHeadless() {
+    constexpr u16 FRAMES = 600;
+
+    bool wasHeadless = Scene::GameScene::IsHeadless();
+    Host::Context base;
+
+    std::array<std::vector<EGG::Vector3f>, 2> positions;
+    for (bool headless : {false, true}) {
+        Scene::GameScene::SetHeadless(headless);
+        positions[headless].reserve(FRAMES);
+
+        for (u16 i = 0; i < FRAMES; ++i) {
+            calc();
+            positions[headless].push_back(Kart::KartObjectManager::Instance()->object(0)->pos());
+        }
+
+        Host::Context::SetActiveContext(base);
+    }
+
+    u32 mismatches = 0;
+    for (u16 i = 0; i < FRAMES; ++i) {
+        if (positions[0][i] != positions[1][i]) {
+            ++mismatches;
+        }
+    }
+
+    if (mismatches > 0) {
+        WARN("%u of %u headless frames did not match the kart position", mismatches, FRAMES);
+        ++m_failedChecks;
+    }
+
+    if (Field::ObjectDrivableDirector::Instance()->hasObjects()) {
+        WARN("This course has drivable objects, so headless mode still calculates the camera");
+    }
+
+    auto race = [&] {
+        auto t0 = Clock::now();
+        for (u16 i = 0; i < FRAMES; ++i) {
+            calc();
+        }
+        f64 elapsedUs = ElapsedUs(t0, Clock::now());
+
+        Host::Context::SetActiveContext(base);
+        return elapsedUs;
+    };
+
+    f64 frames = static_cast<f64>(FRAMES);
+    std::array<f64, 2> elapsedUs;
+    Scene::GameScene::SetHeadless(false);
+    elapsedUs[0] = measure("race.frame", "frame", frames, race);
+    Scene::GameScene::SetHeadless(true);
+    elapsedUs[1] = measure("race.frame.headless", "frame", frames, race);
+
+    Scene::GameScene::SetHeadless(wasHeadless);
+
+    REPORT("Headless (%u frames, %s statics): %.0f frames/s, %.0f frames/s headless", FRAMES,
+            THREAD_LOCAL_STATICS ? "thread-local" : "plain", US_PER_SECOND * frames / elapsedUs[0],
+            US_PER_SECOND * frames / elapsedUs[1]);
+}
+
+/// @brief Measures the throughput of stepping many races interleaved frame by frame.
+/// @details Each race is created in its own Host::Arena, so switching to it only swaps the statics,
+/// and every race must leave the kart in the same position as the race scene does on every frame.
+/// For comparison, the same interleaving is done in the process's memory space by restoring a
+/// Host::Context per race, which copies the entire heap in and out on every switch. The contexts
+/// are a full memory space each, so fewer of them are stepped.
+void KBenchSystem::benchArenas() {
+    constexpr u32 RACE_COUNT = 64;
+    constexpr u32 CONTEXT_RACE_COUNT = 8;
+    constexpr u16 FRAME_COUNT = 300;
+    constexpr u16 CONTEXT_FRAME_COUNT = 20;
+    constexpr size_t RETAIN_BUDGET = 64 * 1024 * 1024;
+
+    if (Host::DirtyPageTracker::IsEnabled()) {
+        WARN("Arenas can't be created while incremental contexts are enabled");
+        return;
+    }
+
+    // Share the course's archives between races instead of decompressing them into every arena
+    size_t retainBudget = System::ResourceManager::RetainBudget();
+    System::ResourceManager::SetRetainBudget(RETAIN_BUDGET);
+
+    m_sceneMgr->destroyScene(m_sceneMgr->currentScene());
+    m_sceneMgr->createScene(static_cast<int>(Host::SceneId::Race), m_sceneMgr->currentScene());
+    std::vector<EGG::Vector3f> expected = recordKartPositions(FRAME_COUNT);
+
+    auto t0 = Clock::now();
+    std::vector<std::unique_ptr<Host::Arena>> arenas;
+    std::vector<EGG::SceneManager *> sceneMgrs;
+    arenas.reserve(RACE_COUNT);
+    sceneMgrs.reserve(RACE_COUNT);
+    for (u32 i = 0; i < RACE_COUNT; ++i) {
+        auto &arena = arenas.emplace_back(std::make_unique<Host::Arena>());
+        arena->activate();
+
+        auto *sceneCreator = EGG::egg_new<Host::SceneCreatorDynamic>();
+        auto *sceneMgr = sceneMgrs.emplace_back(EGG::egg_new<EGG::SceneManager>(sceneCreator));
+        sceneMgr->changeScene(0);
+    }
+    Host::Arena::Deactivate();
+    f64 createUs = ElapsedUs(t0, Clock::now());
+
+    u32 desyncs = 0;
+    t0 = Clock::now();
+    for (u16 frame = 0; frame < FRAME_COUNT; ++frame) {
+        for (u32 i = 0; i < RACE_COUNT; ++i) {
+            arenas[i]->activate();
+            sceneMgrs[i]->calc();
+
+            const auto &pos = Kart::KartObjectManager::Instance()->object(0)->pos();
+            desyncs += pos != expected[frame] ? 1 : 0;
+        }
+    }
+    Host::Arena::Deactivate();
+    f64 arenaUs = ElapsedUs(t0, Clock::now());
+
+    if (desyncs > 0) {
+        WARN("Arenas desynced on %u race frames", desyncs);
+        ++m_failedChecks;
+    }
+
+    // The race scene has already been recreated, so it is on the same frame as every arena was
+    std::vector<Host::Context> contexts(CONTEXT_RACE_COUNT);
+    t0 = Clock::now();
+    for (u16 frame = 0; frame < CONTEXT_FRAME_COUNT; ++frame) {
+        for (auto &context : contexts) {
+            Host::Context::SetActiveContext(context);
+            calc();
+            context.save();
+        }
+    }
+    f64 contextUs = ElapsedUs(t0, Clock::now());
+
+    // Destroy each race while its arena is active, to release the archives it retains
+    for (u32 i = 0; i < RACE_COUNT; ++i) {
+        arenas[i]->activate();
+        sceneMgrs[i]->destroyScene(sceneMgrs[i]->currentScene());
+    }
+    arenas.clear();
+    Host::Arena::Deactivate();
+
+    System::ResourceManager::SetRetainBudget(retainBudget);
+
+    f64 arenaFrames = static_cast<f64>(RACE_COUNT) * FRAME_COUNT;
+    f64 contextFrames = static_cast<f64>(CONTEXT_RACE_COUNT) * CONTEXT_FRAME_COUNT;
+    addMeasurement("arenas.frame", "frame", arenaFrames, {arenaUs});
+    addMeasurement("arenas.context.frame", "frame", contextFrames, {contextUs});
+
+    REPORT("Arenas: %u races created in %.2f ms, %.0f race frames/s interleaved (%.0f race "
+           "frames/s restoring a context per race)",
+            RACE_COUNT, createUs / US_PER_MS, US_PER_SECOND * arenaFrames / arenaUs,
+            US_PER_SECOND * contextFrames / contextUs);
+}
+
+/// @brief Measures how the throughput of simulating races scales with the number of threads.
+/// @details Each thread replays the ghost in its own Host::Arena, as the engine's statics are
+/// thread-local, and every frame of every thread must match the KRKG file next to the ghost.
+/// Threads only start stepping once all of their races are created. Races are also created and
+/// destroyed on every hardware thread at once, so that creation contends on every static it uses.
+void KBenchSystem::benchThreads() {
+    constexpr u32 MAX_THREADS = 64;
+    constexpr u16 MAX_FRAME_COUNT = 600;
+    constexpr u32 CONTENTION_ROUNDS = 8;
+    constexpr u16 CONTENTION_FRAME_COUNT = 60;
+    constexpr size_t RETAIN_BUDGET = 64 * 1024 * 1024;
+
+#ifdef BUILD_SINGLE_THREADED
+    WARN("Threads can't simulate races when the engine's statics are not thread-local");
+    return;
+#endif
+
+    if (Host::DirtyPageTracker::IsEnabled()) {
+        WARN("Threads can't create arenas while incremental contexts are enabled");
+        return;
+    }
+
+    std::string krkgPath =
+            std::filesystem::path(m_ghostFileName).replace_extension(".krkg").string();
+    std::vector<KrkgFrame> expected = ReadKrkg(krkgPath.c_str());
+    if (expected.size() < 2) {
+        WARN("Threads need a KRKG file with frames next to the ghost: %s", krkgPath.c_str());
+        ++m_failedChecks;
+        return;
+    }
+
+    // The first entry is the state before the first frame is simulated
+    u16 frameCount = static_cast<u16>(std::min<size_t>(MAX_FRAME_COUNT, expected.size() - 1));
+
+    // Share the course's archives between threads instead of decompressing them in every arena
+    size_t retainBudget = System::ResourceManager::RetainBudget();
+    System::ResourceManager::SetRetainBudget(RETAIN_BUDGET);
+    m_sceneMgr->destroyScene(m_sceneMgr->currentScene());
+    m_sceneMgr->createScene(static_cast<int>(Host::SceneId::Race), m_sceneMgr->currentScene());
+
+    u16 heapOptionFlg = EGG::SceneManager::HeapOptionFlg();
+    f64 singleThreadFramesPerSecond = 0.0;
+
+    // Steps the race on the calling thread, which must match the KRKG file on every frame
+    auto stepInSync = [&](EGG::SceneManager *sceneMgr, u16 count) {
+        for (u16 i = 0; i < count; ++i) {
+            sceneMgr->calc();
+            if (!(CaptureKrkgFrame() == expected[i + 1])) {
+                return false;
+            }
+        }
+
+        return true;
+    };
+
+    for (u32 threadCount = 1; threadCount <= MAX_THREADS; threadCount *= 2) {
+        // The main thread joins both barriers, to time the frames between them
+        std::barrier created(threadCount + 1);
+        std::barrier stepped(threadCount + 1);
+        std::atomic<u32> desyncs = 0;
+
+        auto race = [&] {
+            // New threads start with the statics the process started with
+            EGG::SceneManager::SetHeapOptionFlg(heapOptionFlg);
+            System::RaceConfig::RegisterInitCallback(OnInit, nullptr);
+
+            Host::Arena arena;
+            arena.activate();
+
+            auto *sceneCreator = EGG::egg_new<Host::SceneCreatorDynamic>();
+            auto *sceneMgr = EGG::egg_new<EGG::SceneManager>(sceneCreator);
+            sceneMgr->changeScene(0);
+            created.arrive_and_wait();
+
+            if (!stepInSync(sceneMgr, frameCount)) {
+                ++desyncs;
+            }
+            stepped.arrive_and_wait();
+
+            // Release the archives the race retains before its arena is freed
+            sceneMgr->destroyScene(sceneMgr->currentScene());
+            Host::Arena::Deactivate();
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(threadCount);
+        for (u32 i = 0; i < threadCount; ++i) {
+            threads.emplace_back(race);
+        }
+
+        created.arrive_and_wait();
+        auto t0 = Clock::now();
+        stepped.arrive_and_wait();
+        f64 elapsedUs = ElapsedUs(t0, Clock::now());
+
+        for (auto &thread : threads) {
+            thread.join();
+        }
+
+        if (desyncs > 0) {
+            WARN("%u of %u threads desynced from %s", desyncs.load(), threadCount,
+                    krkgPath.c_str());
+            ++m_failedChecks;
+        }
+
+        char name[64];
+        snprintf(name, sizeof(name), "threads.%u.frame", threadCount);
+        f64 frames = static_cast<f64>(threadCount) * frameCount;
+        addMeasurement(name, "frame", frames, {elapsedUs});
+
+        f64 framesPerSecond = US_PER_SECOND * frames / elapsedUs;
+        if (threadCount == 1) {
+            singleThreadFramesPerSecond = framesPerSecond;
+        }
+
+        REPORT("Threads (%u): %.0f race frames/s (%.2fx one thread)", threadCount, framesPerSecond,
+                framesPerSecond / singleThreadFramesPerSecond);
+    }
+
+    u32 threadCount = std::max<u32>(std::thread::hardware_concurrency(), 2);
+    u16 contentionFrameCount = std::min(CONTENTION_FRAME_COUNT, frameCount);
+    std::barrier started(threadCount + 1);
+    std::barrier finished(threadCount + 1);
+    std::atomic<u32> desyncs = 0;
+
+    auto recreate = [&] {
+        EGG::SceneManager::SetHeapOptionFlg(heapOptionFlg);
+        System::RaceConfig::RegisterInitCallback(OnInit, nullptr);
+
+        Host::Arena arena;
+        arena.activate();
+
+        auto *sceneCreator = EGG::egg_new<Host::SceneCreatorDynamic>();
+        auto *sceneMgr = EGG::egg_new<EGG::SceneManager>(sceneCreator);
+        started.arrive_and_wait();
+
+        for (u32 round = 0; round < CONTENTION_ROUNDS; ++round) {
+            if (round == 0) {
+                sceneMgr->changeScene(0);
+            } else {
+                sceneMgr->destroyScene(sceneMgr->currentScene());
+                sceneMgr->createScene(static_cast<int>(Host::SceneId::Race),
+                        sceneMgr->currentScene());
+            }
+
+            if (!stepInSync(sceneMgr, contentionFrameCount)) {
+                ++desyncs;
+            }
+        }
+        finished.arrive_and_wait();
+
+        sceneMgr->destroyScene(sceneMgr->currentScene());
+        Host::Arena::Deactivate();
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount);
+    for (u32 i = 0; i < threadCount; ++i) {
+        threads.emplace_back(recreate);
+    }
+
+    started.arrive_and_wait();
+    auto t0 = Clock::now();
+    finished.arrive_and_wait();
+    f64 elapsedUs = ElapsedUs(t0, Clock::now());
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    if (desyncs > 0) {
+        WARN("%u of %u races created under contention desynced from %s", desyncs.load(),
+                threadCount * CONTENTION_ROUNDS, krkgPath.c_str());
+        ++m_failedChecks;
+    }
+
+    f64 races = static_cast<f64>(threadCount) * CONTENTION_ROUNDS;
+    addMeasurement("threads.create", "race", races, {elapsedUs});
+    REPORT("Threads (%u creating races): %.0f races/s with %u frames each", threadCount,
+            US_PER_SECOND * races / elapsedUs, contentionFrameCount);
+
+    System::ResourceManager::SetRetainBudget(retainBudget);
+}
+
+} // namespace Kinoko
@@ -0,0 +1,424 @@
+#include "host/KBenchSystem.hh"
+
+#include "host/Context.hh"
+#include "host/SceneId.hh"
+
+#include <abstract/Archive.hh>
+#include <abstract/ArchiveCache.hh>
+
+#include <egg/core/Decomp.hh>
+
+#include <game/system/ResourceManager.hh>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <span>
+#include <string>
+
+namespace Kinoko {
+
+/// @brief Performs YAZ0 decompression one byte at a time.
+/// @details This is how EGG::Decomp::DecodeSZS worked before it copied in bulk, and is kept as a
+/// baseline and as the reference for differential checks.
+static s32 DecodeSZSBytewise(const u8 *src, u8 *dst) {
+    s32 expandSize = EGG::Decomp::GetExpandSize(src);
+    s32 srcIdx = 0x10;
+    u8 code = 0;
+
+    u8 byte;
+
+    for (s32 destIdx = 0; destIdx < expandSize; code >>= 1) {
+        if (!code) {
+            code = 0x80;
+            byte = src[srcIdx++];
+        }
+
+        if (byte & code) {
+            dst[destIdx++] = src[srcIdx++];
+        } else {
+            s32 distToDest = (src[srcIdx] << 8) | src[srcIdx + 1];
+            srcIdx += sizeof(u8) * 2;
+            s32 runSrcIdx = destIdx - (distToDest & 0xfff);
+            s32 runLen = ((distToDest >> 12) == 0) ? src[srcIdx++] + 0x12 : (distToDest >> 12) + 2;
+
+            for (; runLen > 0; runLen--, destIdx++, runSrcIdx++) {
+                if (destIdx >= expandSize) {
+                    PANIC("Malformed compressed SZS data.");
+                }
+
+                dst[destIdx] = dst[runSrcIdx - 1];
+            }
+        }
+    }
+
+    return expandSize;
+}
+
+/// @brief Encodes a random, well-formed YAZ0 stream.
+/// @details Literals are drawn from real data. Runs are mostly short and close, so that runs which
+/// overlap themselves are common, but may have any distance and length the format allows.
+/// @param literals The bytes to draw literals from.
+/// @param expandSize The size of the stream once decoded.
+/// @param rng The random number generator.
+static std::vector<u8> EncodeRandomSZS(std::span<const u8> literals, u32 expandSize,
+        std::mt19937 &rng) {
+    constexpr u32 MAX_DIST = 0x1000;
+    constexpr u32 MAX_LEN = 0x111;
+
+    std::vector<u8> stream = {'Y', 'a', 'z', '0', static_cast<u8>(expandSize >> 24),
+            static_cast<u8>(expandSize >> 16), static_cast<u8>(expandSize >> 8),
+            static_cast<u8>(expandSize), 0, 0, 0, 0, 0, 0, 0, 0};
+
+    for (u32 size = 0; size < expandSize;) {
+        size_t codeIdx = stream.size();
+        stream.push_back(0);
+
+        for (u8 bit = 0x80; bit != 0 && size < expandSize; bit >>= 1) {
+            u32 maxLen = std::min(MAX_LEN, expandSize - size);
+            if (size == 0 || maxLen < 3 || rng() % 2 == 0) {
+                stream[codeIdx] |= bit;
+                stream.push_back(literals[rng() % literals.size()]);
+                ++size;
+                continue;
+            }
+
+            u32 dist = 1 + rng() % std::min(rng() % 2 == 0 ? 16 : MAX_DIST, size);
+            u32 len = 3 + rng() % (std::min(rng() % 2 == 0 ? 0x20 : MAX_LEN, maxLen) - 2);
+
+            if (len < 0x12) {
+                stream.push_back(static_cast<u8>(((len - 2) << 4) | ((dist - 1) >> 8)));
+                stream.push_back(static_cast<u8>(dist - 1));
+            } else {
+                stream.push_back(static_cast<u8>((dist - 1) >> 8));
+                stream.push_back(static_cast<u8>(dist - 1));
+                stream.push_back(static_cast<u8>(len - 0x12));
+            }
+
+            size += len;
+        }
+    }
+
+    return stream;
+}
+
+/// @brief Compares decompressing the race's archives against loading them from the archive cache.
+/// @details The archives are loaded from the same paths as during startup, so this reuses the
+/// cache entries stored then. Every page of a cached archive is compared against the decompressed
+/// archive, which also shows the cost of faulting in a memory-mapped entry.
+void KBenchSystem::benchArchiveCache() {
+    if (!Abstract::ArchiveCache::IsEnabled()) {
+        WARN("The archive cache is disabled. Pass -c <directory> to measure it");
+        return;
+    }
+
+    char coursePath[256];
+    auto course = System::RaceConfig::Instance()->raceScenario().course;
+    snprintf(coursePath, sizeof(coursePath), "Race/Course/%s%s",
+            COURSE_NAMES[static_cast<s32>(course)], SZS_EXTENSION);
+
+    const std::array<const char *, 2> paths = {{"/Race/Common.szs", coursePath}};
+
+    for (const char *path : paths) {
+        std::vector<u8> source = ReadFile(path[0] == '/' ? path + 1 : path);
+
+        auto t0 = Clock::now();
+        auto key = Abstract::ArchiveCache::CreateKey(path, source.data(), source.size());
+        auto t1 = Clock::now();
+        std::vector<u8> archive(EGG::Decomp::GetExpandSize(source.data()));
+        EGG::Decomp::DecodeSZS(source.data(), archive.data());
+        auto t2 = Clock::now();
+
+        // Startup should have stored the entry already, unless the cache was just enabled
+        size_t size = 0;
+        void *cached = Abstract::ArchiveCache::Load(key, size);
+        if (cached) {
+            Abstract::ArchiveCache::Release(cached);
+        } else {
+            Abstract::ArchiveCache::Store(key, archive.data(), archive.size());
+        }
+
+        auto t3 = Clock::now();
+        cached = Abstract::ArchiveCache::Load(key, size);
+        if (!cached) {
+            WARN("Failed to cache %s", path);
+            ++m_failedChecks;
+            continue;
+        }
+
+        auto t4 = Clock::now();
+        bool matches = size == archive.size() && memcmp(cached, archive.data(), size) == 0;
+        auto t5 = Clock::now();
+
+        Abstract::ArchiveCache::Release(cached);
+
+        if (!matches) {
+            WARN("Cached archive %s does not match its decompression", path);
+            ++m_failedChecks;
+        }
+
+        REPORT("Archive %s: %.2f ms hashing, %.2f ms decompressing, %.2f ms loading from cache "
+               "(%.2f ms faulting in)",
+                path, ElapsedUs(t0, t1) / US_PER_MS, ElapsedUs(t1, t2) / US_PER_MS,
+                ElapsedUs(t3, t4) / US_PER_MS, ElapsedUs(t4, t5) / US_PER_MS);
+    }
+}
+
+/// @brief Checks YAZ0 decompression over Common and every course archive present, and measures its
+/// throughput over the race's archives.
+/// @details Each archive is decoded both by EGG::Decomp::DecodeSZS and by the byte-wise decoder it
+/// replaced, and the outputs are compared. Every archive also seeds random streams, which cover
+/// run lengths and distances, and buffer ends, that real archives rarely exercise. Throughput is
+/// only measured over Common and the course archive, so that it doesn't depend on which other
+/// archives are present.
+void KBenchSystem::benchDecodeSZS() {
+    constexpr u32 STREAMS_PER_ARCHIVE = 64;
+    constexpr u32 MAX_STREAM_SIZE = 0x10000;
+    constexpr size_t LITERAL_WINDOW_SIZE = 0x100;
+
+    std::mt19937 rng(0);
+    std::vector<u8> expected;
+    std::vector<u8> actual;
+
+    u32 archiveCount = 0;
+    u32 streamCount = 0;
+    u32 mismatches = 0;
+    size_t decodedSize = 0;
+
+    auto decodeBoth = [&](const u8 *src) {
+        s32 expandSize = EGG::Decomp::GetExpandSize(src);
+        expected.assign(expandSize, 0);
+        actual.assign(expandSize, 0xFF);
+
+        s32 expectedSize = DecodeSZSBytewise(src, expected.data());
+        s32 actualSize = EGG::Decomp::DecodeSZS(src, actual.data());
+
+        if (expectedSize != actualSize || expected != actual) {
+            ++mismatches;
+        }
+    };
+
+    std::vector<std::string> paths = {"Race/Common.szs"};
+    for (const char *name : COURSE_NAMES) {
+        if (name) {
+            paths.push_back(std::string("Race/Course/") + name + SZS_EXTENSION);
+        }
+    }
+
+    for (const auto &path : paths) {
+        if (!std::filesystem::exists(path)) {
+            continue;
+        }
+
+        std::vector<u8> source = ReadFile(path.c_str());
+        if (EGG::Decomp::GetExpandSize(source.data()) < 0) {
+            continue;
+        }
+
+        decodeBoth(source.data());
+        decodedSize += actual.size();
+        ++archiveCount;
+
+        std::vector<u8> archive = std::move(actual);
+        size_t windowCount = archive.size() / LITERAL_WINDOW_SIZE;
+        for (u32 i = 0; i < STREAMS_PER_ARCHIVE && windowCount > 0; ++i) {
+            size_t window = LITERAL_WINDOW_SIZE * (rng() % windowCount);
+            std::span<const u8> literals(archive.data() + window, LITERAL_WINDOW_SIZE);
+
+            // Small streams never leave the checked tail of the decoder
+            u32 expandSize = 1 + rng() % (i % 4 == 0 ? 0x100 : MAX_STREAM_SIZE);
+            std::vector<u8> stream = EncodeRandomSZS(literals, expandSize, rng);
+            decodeBoth(stream.data());
+            ++streamCount;
+        }
+    }
+
+    if (archiveCount == 0) {
+        WARN("No course archives were found");
+        return;
+    }
+
+    if (mismatches > 0) {
+        WARN("%u SZS decodes do not match the byte-wise decoder", mismatches);
+        ++m_failedChecks;
+    }
+
+    constexpr f64 BYTES_PER_MIB = 1024.0 * 1024.0;
+    REPORT("DecodeSZS: %u archives (%.1f MiB) and %u random streams checked", archiveCount,
+            static_cast<f64>(decodedSize) / BYTES_PER_MIB, streamCount);
+
+    char coursePath[256];
+    auto course = System::RaceConfig::Instance()->raceScenario().course;
+    snprintf(coursePath, sizeof(coursePath), "Race/Course/%s%s",
+            COURSE_NAMES[static_cast<s32>(course)], SZS_EXTENSION);
+
+    std::vector<std::vector<u8>> sources;
+    std::vector<std::vector<u8>> archives;
+    size_t raceSize = 0;
+    for (const char *path : {"Race/Common.szs", static_cast<const char *>(coursePath)}) {
+        sources.push_back(ReadFile(path));
+        archives.emplace_back(EGG::Decomp::GetExpandSize(sources.back().data()));
+        raceSize += archives.back().size();
+    }
+
+    auto decodeAll = [&](s32 (*decode)(const u8 *, u8 *)) {
+        for (size_t i = 0; i < sources.size(); ++i) {
+            decode(sources[i].data(), archives[i].data());
+        }
+    };
+
+    f64 bytes = static_cast<f64>(raceSize);
+    f64 bytewiseUs = measure("szs.decodeBytewise", "byte", bytes,
+            [&] { decodeAll(DecodeSZSBytewise); });
+    f64 bulkUs = measure("szs.decode", "byte", bytes, [&] { decodeAll(EGG::Decomp::DecodeSZS); });
+
+    f64 raceMiB = bytes / BYTES_PER_MIB;
+    REPORT("DecodeSZS (Common and course, %.1f MiB): %.1f MiB/s (byte-wise), %.1f MiB/s (bulk)",
+            raceMiB, US_PER_SECOND * raceMiB / bytewiseUs, US_PER_SECOND * raceMiB / bulkUs);
+}
+
+/// @brief Measures how quickly archive paths are resolved, with and without the path index.
+/// @details Common and the course archive are each resolved by every file's name, as the game
+/// looks files up, and by every entry's full path. Both ways of resolving a path must agree.
+void KBenchSystem::benchPathLookup() {
+    constexpr u32 PASSES = 20;
+
+    char coursePath[256];
+    auto course = System::RaceConfig::Instance()->raceScenario().course;
+    snprintf(coursePath, sizeof(coursePath), "Race/Course/%s%s",
+            COURSE_NAMES[static_cast<s32>(course)], SZS_EXTENSION);
+
+    const std::array<const char *, 2> paths = {{"Race/Common.szs", coursePath}};
+
+    // Indexing allocates, which the race scene otherwise forbids after creation
+    Host::Context base;
+    EGG::Heap *heap = m_sceneMgr->currentScene()->heap();
+    heap->enableAllocation();
+
+    for (const char *path : paths) {
+        std::vector<u8> source = ReadFile(path);
+        std::vector<u8> archive(EGG::Decomp::GetExpandSize(source.data()));
+        EGG::Decomp::DecodeSZS(source.data(), archive.data());
+
+        auto t0 = Clock::now();
+        Abstract::ArchiveHandle handle(archive.data());
+        auto t1 = Clock::now();
+
+        // Each directory entry's subtree ends at its next entry, so full paths follow a stack
+        std::vector<std::string> lookups;
+        std::vector<std::pair<u32, std::string>> directories = {{handle.count(), ""}};
+        for (u32 i = 1; i < handle.count(); ++i) {
+            while (i >= directories.back().first) {
+                directories.pop_back();
+            }
+
+            std::string fullPath = directories.back().second + "/" + handle.entryName(i);
+            lookups.push_back(fullPath);
+
+            if (handle.node(i)->isDirectory()) {
+                directories.emplace_back(parse<u32>(handle.node(i)->directory.next), fullPath);
+            } else {
+                lookups.push_back(std::string("/") + handle.entryName(i));
+            }
+        }
+
+        std::array<f64, 2> elapsedUs = {};
+        std::array<std::vector<s32>, 2> entryIds;
+        for (bool indexed : {false, true}) {
+            Abstract::ArchiveHandle::SetPathIndexEnabled(indexed);
+
+            uintptr_t sink = 0;
+            auto t2 = Clock::now();
+            for (u32 i = 0; i < PASSES; ++i) {
+                for (const auto &lookup : lookups) {
+                    sink += handle.convertPathToEntryId(lookup.c_str());
+                }
+            }
+            elapsedUs[indexed] = ElapsedUs(t2, Clock::now());
+            s_sink = sink;
+
+            for (const auto &lookup : lookups) {
+                entryIds[indexed].push_back(handle.convertPathToEntryId(lookup.c_str()));
+            }
+        }
+
+        Abstract::ArchiveHandle::SetPathIndexEnabled(true);
+
+        if (entryIds[0] != entryIds[1]) {
+            WARN("Indexed paths in %s do not resolve to the same entries", path);
+            ++m_failedChecks;
+        }
+
+        f64 lookupCount = static_cast<f64>(PASSES) * static_cast<f64>(lookups.size());
+        REPORT("Path lookup in %s: %u entries indexed in %.0f us, %.0f ns/lookup (linear), "
+               "%.0f ns/lookup (indexed)",
+                path, handle.count(), ElapsedUs(t0, t1), NS_PER_US * elapsedUs[0] / lookupCount,
+                NS_PER_US * elapsedUs[1] / lookupCount);
+    }
+
+    heap->disableAllocation();
+    Host::Context::SetActiveContext(base);
+}
+
+/// @brief Measures how long the race scene takes to create, with and without the path index, and
+/// with retained archives.
+/// @details The scene is recreated the same way KTestSystem moves to its next test case. This
+/// includes loading the race's archives, so the archive cache reduces the noise around lookups.
+/// Retained archives skip loading entirely, and must leave the kart in the same position on every
+/// frame as archives loaded into the heap.
+void KBenchSystem::benchSceneCreation() {
+    constexpr u32 REPETITIONS = 5;
+    constexpr size_t RETAIN_BUDGET = 64 * 1024 * 1024;
+    constexpr u16 CHECKED_FRAMES = 300;
+
+    enum Variant { Linear, Indexed, Retained, VariantCount };
+
+    size_t retainBudget = System::ResourceManager::RetainBudget();
+
+    auto recreate = [this](Variant variant) {
+        Abstract::ArchiveHandle::SetPathIndexEnabled(variant != Linear);
+        System::ResourceManager::SetRetainBudget(variant == Retained ? RETAIN_BUDGET : 0);
+        m_sceneMgr->destroyScene(m_sceneMgr->currentScene());
+
+        auto t0 = Clock::now();
+        m_sceneMgr->createScene(static_cast<int>(Host::SceneId::Race),
+                m_sceneMgr->currentScene());
+        return ElapsedUs(t0, Clock::now());
+    };
+
+    // Retain the archives before timing
+    recreate(Retained);
+
+    std::array<f64, VariantCount> elapsedUs = {};
+    for (u32 i = 0; i < REPETITIONS; ++i) {
+        for (Variant variant : {Linear, Indexed, Retained}) {
+            elapsedUs[variant] += recreate(variant);
+        }
+    }
+
+    std::vector<EGG::Vector3f> retainedPositions = recordKartPositions(CHECKED_FRAMES);
+    recreate(Indexed);
+    std::vector<EGG::Vector3f> positions = recordKartPositions(CHECKED_FRAMES);
+
+    for (u16 i = 0; i < CHECKED_FRAMES; ++i) {
+        if (retainedPositions[i] != positions[i]) {
+            WARN("Retained archives desynced on frame %u", i);
+            ++m_failedChecks;
+            break;
+        }
+    }
+
+    const auto &stats = System::ResourceManager::GetRetainStats();
+    Abstract::ArchiveHandle::SetPathIndexEnabled(true);
+    System::ResourceManager::SetRetainBudget(retainBudget);
+
+    REPORT("RaceScene creation: %.2f ms (linear paths), %.2f ms (indexed paths), %.2f ms "
+           "(retained archives, %u hits, %u misses)",
+            elapsedUs[Linear] / US_PER_MS / REPETITIONS,
+            elapsedUs[Indexed] / US_PER_MS / REPETITIONS,
+            elapsedUs[Retained] / US_PER_MS / REPETITIONS, stats.hits, stats.misses);
+}
+
+} // namespace Kinoko
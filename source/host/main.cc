@@ -1,9 +1,19 @@
+#include "host/Context.hh"
+#include "host/DirtyPageTracker.hh"
+#include "host/KBenchSystem.hh"
+#include "host/KHostSystem.hh"
 #include "host/KReplaySystem.hh"
 #include "host/KTestSystem.hh"
 #include "host/Option.hh"
 
+#include <abstract/ArchiveCache.hh>
+#include <abstract/Profiler.hh>
+
 #include <egg/core/ExpHeap.hh>
 
+#include <game/scene/GameScene.hh>
+#include <game/system/ResourceManager.hh>
+
 using namespace Kinoko;
 
 #if defined(__arm64__) || defined(__aarch64__)
@@ -22,18 +32,143 @@ static void FlushDenormalsToZero() {
 
 static void *s_memorySpace = nullptr;
 static EGG::Heap *s_rootHeap = nullptr;
+static const char *s_profilePrefix = nullptr; ///< Where to write the profile, if profiling.
+static u16 s_heapOpt = DEFAULT_OPT;
+static size_t s_memorySpaceSize = MEMORY_SPACE_SIZE;
+static bool s_heapStats = false; ///< Whether to report heap usage after running.
+
+/// Arena sizes are rounded up to this, which is a multiple of any page size we expect to run on.
+static constexpr size_t ARENA_GRANULE = 0x10000;
 
 static void InitMemory() {
-    s_memorySpace = malloc(MEMORY_SPACE_SIZE);
-    s_rootHeap = EGG::ExpHeap::create(s_memorySpace, MEMORY_SPACE_SIZE, DEFAULT_OPT);
+    // Page-aligned, so that contexts can track which pages are modified
+    s_memorySpace = Host::DirtyPageTracker::AllocPages(s_memorySpaceSize);
+    s_rootHeap = EGG::ExpHeap::create(s_memorySpace, s_memorySpaceSize, s_heapOpt);
+    ASSERT(s_rootHeap);
     s_rootHeap->setName("EGGRoot");
     s_rootHeap->becomeCurrentHeap();
 
     EGG::SceneManager::SetRootHeap(s_rootHeap);
+    EGG::SceneManager::SetHeapOptionFlg(s_heapOpt);
+    Host::Context::SetMemorySpaceSize(s_memorySpaceSize);
+}
+
+/// @brief Parses a size in bytes, optionally suffixed with K or M.
+static size_t ParseSize(const char *arg) {
+    char *end = nullptr;
+    unsigned long long size = strtoull(arg, &end, 0);
+
+    if (*end == 'K' || *end == 'k') {
+        size <<= 10;
+        ++end;
+    } else if (*end == 'M' || *end == 'm') {
+        size <<= 20;
+        ++end;
+    }
+
+    if (end == arg || *end != '\0' || size == 0) {
+        PANIC("Invalid size: %s", arg);
+    }
+
+    return static_cast<size_t>(size);
+}
+
+/// @brief Reports the usage of each group in the current heap and all of its parents.
+/// @details The suggested arena size is the peak use plus 1/8th as headroom for fragmentation.
+static void ReportHeapUsage() {
+    for (EGG::Heap *heap = EGG::Heap::getCurrentHeap(); heap; heap = heap->getParentHeap()) {
+        EGG::ExpHeap *expHeap = EGG::Heap::dynamicCastToExp(heap);
+        if (!expHeap) {
+            continue;
+        }
+
+        REPORT("Heap %s: %u bytes used, %u bytes peak", expHeap->getName(), expHeap->usedSize(),
+                expHeap->peakUsedSize());
+
+        for (u16 groupID = 0; groupID < 256; ++groupID) {
+            const EGG::ExpHeap::GroupUsage &usage = expHeap->groupUsage(groupID);
+            if (usage.allocCount == 0) {
+                continue;
+            }
+
+            REPORT("  Group %3u: %9u bytes used, %9u bytes peak, %7u allocations", groupID,
+                    usage.current, usage.peak, usage.allocCount);
+        }
+    }
+
+    size_t peak = EGG::ExpHeap::PeakArenaUse();
+    size_t suggested = RoundUp(peak + peak / 8, ARENA_GRANULE);
+    REPORT("Peak arena use: %zu of %zu bytes (suggested --arena-size 0x%zx)", peak,
+            s_memorySpaceSize, suggested);
+}
+
+/// @brief Handles options shared by all modes, and removes them from the arguments.
+/// @details This runs before memory is initialized, so that options may configure the heaps.
+/// @return The number of remaining arguments.
+static int ParseGenericOptions(int argc, char **argv) {
+    int remaining = 0;
+
+    for (int i = 0; i < argc; ++i) {
+        std::optional<Host::EOption> flag = Host::Option::CheckFlag(argv[i]);
+        if (flag && *flag == Host::EOption::ArchiveCache) {
+            ASSERT(i + 1 < argc);
+            Abstract::ArchiveCache::SetDirectory(argv[++i]);
+            continue;
+        }
+
+        if (flag && *flag == Host::EOption::Profile) {
+            ASSERT(i + 1 < argc);
+            if (!Abstract::Profiler::IsSupported()) {
+                PANIC("Profiling requires a build with BUILD_PROFILE defined!");
+            }
+
+            s_profilePrefix = argv[++i];
+            Abstract::Profiler::Enable();
+            continue;
+        }
+
+        if (flag && *flag == Host::EOption::Headless) {
+            Scene::GameScene::SetHeadless(true);
+            continue;
+        }
+
+        if (flag && *flag == Host::EOption::SizeClasses) {
+            s_heapOpt = Abstract::Memory::MEMiHeapHead::OptFlag(s_heapOpt)
+                                .setBit(Abstract::Memory::MEMiHeapHead::eOptFlag::SizeClasses);
+            continue;
+        }
+
+        if (flag && *flag == Host::EOption::ArenaSize) {
+            ASSERT(i + 1 < argc);
+            s_memorySpaceSize = RoundUp(ParseSize(argv[++i]), ARENA_GRANULE);
+            continue;
+        }
+
+        if (flag && *flag == Host::EOption::HeapStats) {
+            s_heapStats = true;
+            continue;
+        }
+
+        if (flag && *flag == Host::EOption::RetainArchives) {
+            ASSERT(i + 1 < argc);
+            System::ResourceManager::SetRetainBudget(ParseSize(argv[++i]));
+            continue;
+        }
+
+        argv[remaining++] = argv[i];
+    }
+
+    return remaining;
 }
 
 int main(int argc, char **argv) {
     FlushDenormalsToZero();
+
+    if (argc < 2) {
+        PANIC("Too few arguments!");
+    }
+
+    int optionCount = ParseGenericOptions(argc - 2, argv + 2);
     InitMemory();
 
     // The hashmap cannot be constexpr, as it heap-allocates
@@ -42,12 +177,10 @@ int main(int argc, char **argv) {
     const std::unordered_map<std::string, std::function<KSystem *()>> modeMap = {
             {"test", []() -> KSystem * { return KTestSystem::CreateInstance(); }},
             {"replay", []() -> KSystem * { return KReplaySystem::CreateInstance(); }},
+            {"bench", []() -> KSystem * { return KBenchSystem::CreateInstance(); }},
+            {"host", []() -> KSystem * { return KHostSystem::CreateInstance(); }},
     };
 
-    if (argc < 2) {
-        PANIC("Too few arguments!");
-    }
-
     KSystem *sys = nullptr;
 
     // The first argument is the executable, so we ignore it
@@ -61,7 +194,17 @@ int main(int argc, char **argv) {
         PANIC("Invalid mode!");
     }
 
-    sys->parseOptions(argc - 2, argv + 2);
+    sys->parseOptions(optionCount, argv + 2);
     sys->init();
-    return sys->run() ? 0 : 1;
+    bool success = sys->run();
+
+    if (s_profilePrefix) {
+        Abstract::Profiler::WriteReport(s_profilePrefix);
+    }
+
+    if (s_heapStats) {
+        ReportHeapUsage();
+    }
+
+    return success ? 0 : 1;
 }
@@ -0,0 +1,89 @@
+#include <egg/math/Math.hh>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace Kinoko;
+
+/// @brief Computes EGG::Mathf::frsqrt with the double-precision frsqrte.
+/// @details This is how frsqrt worked before frsqrte handled floats directly.
+static f32 FrsqrtDoubleEstimate(f32 x) {
+    f64 est = EGG::Mathf::frsqrte(static_cast<f64>(x));
+
+    f32 tmp0 = static_cast<f32>(est * EGG::Mathf::force25Bit(est));
+    f32 tmp1 = static_cast<f32>(est * static_cast<f64>(0.5f));
+    f32 tmp2 =
+            static_cast<f32>(static_cast<f64>(3.0f) - static_cast<f64>(tmp0) * static_cast<f64>(x));
+    return tmp1 * tmp2;
+}
+
+/// @brief Whether frsqrte and frsqrt of a float match the double-precision frsqrte bit for bit.
+static bool Matches(u32 bits) {
+    f32 x = std::bit_cast<f32>(bits);
+    f64 estimate = EGG::Mathf::frsqrte(x);
+    f64 reference = EGG::Mathf::frsqrte(static_cast<f64>(x));
+
+    return std::bit_cast<u64>(estimate) == std::bit_cast<u64>(reference) &&
+            f2u(EGG::Mathf::frsqrt(x)) == f2u(FrsqrtDoubleEstimate(x));
+}
+
+/// @brief Checks the single-precision frsqrte and frsqrt against the double-precision frsqrte on
+/// every float, including NaNs, infinities, zeroes, denormals and negative numbers.
+/// @details Floats are checked in chunks handed out in order to every hardware thread. Once a
+/// mismatch is found, no further chunks are started, and the lowest mismatching input is reported.
+/// @return 0 if every float matches, or 1 otherwise.
+int main() {
+    constexpr u64 FLOAT_COUNT = 1ULL << 32;
+    constexpr u64 CHUNK_SIZE = 1ULL << 20;
+    constexpr u64 NO_MISMATCH = FLOAT_COUNT;
+
+    std::atomic<u64> nextChunk = 0;
+    std::atomic<u64> firstMismatch = NO_MISMATCH;
+
+    auto check = [&] {
+        for (u64 start = nextChunk.fetch_add(CHUNK_SIZE); start < FLOAT_COUNT;
+                start = nextChunk.fetch_add(CHUNK_SIZE)) {
+            if (start >= firstMismatch) {
+                return;
+            }
+
+            for (u64 bits = start; bits < start + CHUNK_SIZE; ++bits) {
+                if (Matches(static_cast<u32>(bits))) {
+                    continue;
+                }
+
+                u64 prev = firstMismatch;
+                while (bits < prev && !firstMismatch.compare_exchange_weak(prev, bits)) {}
+                return;
+            }
+        }
+    };
+
+    u32 threadCount = std::max<u32>(std::thread::hardware_concurrency(), 1);
+    std::vector<std::thread> threads;
+    for (u32 i = 0; i < threadCount; ++i) {
+        threads.emplace_back(check);
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    if (firstMismatch != NO_MISMATCH) {
+        f32 x = std::bit_cast<f32>(static_cast<u32>(firstMismatch.load()));
+        u64 estimate = std::bit_cast<u64>(EGG::Mathf::frsqrte(x));
+        u64 reference = std::bit_cast<u64>(EGG::Mathf::frsqrte(static_cast<f64>(x)));
+
+        WARN("frsqrt mismatch on 0x%08X (%g): estimate 0x%016llX (expected 0x%016llX), result "
+             "0x%08X (expected 0x%08X)",
+                f2u(x), static_cast<f64>(x), static_cast<unsigned long long>(estimate),
+                static_cast<unsigned long long>(reference), f2u(EGG::Mathf::frsqrt(x)),
+                f2u(FrsqrtDoubleEstimate(x)));
+        return 1;
+    }
+
+    REPORT("frsqrt: every float matches the double-precision estimate (%u threads)",
+            threadCount);
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include <egg/core/ExpHeap.hh>
+
+#include <game/system/GhostFile.hh>
+#include <game/system/GhostTimeline.hh>
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <vector>
+
+using namespace Kinoko;
+
+/// @brief Whether two timelines play back the same inputs on every frame, including past the end.
+static bool SamePlayback(const System::GhostTimeline &lhs, const System::GhostTimeline &rhs) {
+    for (size_t i = 0; i <= std::max(lhs.size(), rhs.size()); ++i) {
+        const auto &l = lhs.playback(i);
+        const auto &r = rhs.playback(i);
+        if (l.buttons != r.buttons || l.stickXRaw != r.stickXRaw || l.stickYRaw != r.stickYRaw ||
+                l.trick != r.trick) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// @brief Writes a timeline over a ghost, which must be valid and play back the same once read.
+static bool RoundTrips(const System::RawGhostFile &raw, const System::GhostTimeline &timeline,
+        bool compress) {
+    std::vector<u8> rkg(System::RKG_MAX_WRITE_SIZE);
+    size_t size = timeline.writeRKG(raw, rkg.data(), compress);
+    if (size == 0 || System::RawGhostFile::FindError(rkg.data(), size)) {
+        return false;
+    }
+
+    auto written = std::make_unique<System::RawGhostFile>(rkg.data());
+    System::GhostTimeline reread(written->buffer() + System::RKG_HEADER_SIZE);
+    return SamePlayback(timeline, reread);
+}
+
+/// @brief Decodes a ghost, and writes it back with and without compression, along with a copy
+/// that loops a stretch of it over a later one and drops some items along the way.
+/// @return Why the ghost doesn't round trip, or nullptr if it does.
+static const char *CheckGhost(const std::filesystem::path &path) {
+    std::error_code ec;
+    uintmax_t size = std::filesystem::file_size(path, ec);
+    if (ec || size > sizeof(System::RawGhostFile)) {
+        return "Invalid file size";
+    }
+
+    // Ghosts are read as a whole RawGhostFile, so the file is padded to its size
+    std::vector<u8> file(sizeof(System::RawGhostFile));
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream.read(reinterpret_cast<char *>(file.data()), static_cast<std::streamsize>(size))) {
+        return "Failed to read file";
+    }
+
+    if (const char *error = System::RawGhostFile::FindError(file.data(), size)) {
+        return error;
+    }
+
+    auto raw = std::make_unique<System::RawGhostFile>(file.data());
+    System::GhostTimeline timeline(raw->buffer() + System::RKG_HEADER_SIZE);
+
+    System::GhostTimeline edited = timeline;
+    size_t third = edited.size() / 3;
+    if (third > 0) {
+        edited.splice(third, third / 2, std::span(&timeline[0], third));
+    }
+    for (size_t i = 0; i < edited.size(); i += 60) {
+        edited[i].buttons ^= 0x4;
+    }
+
+    if (!RoundTrips(*raw, timeline, true)) {
+        return "Compressed inputs play back differently";
+    }
+
+    if (!RoundTrips(*raw, timeline, false)) {
+        return "Uncompressed inputs play back differently";
+    }
+
+    if (!RoundTrips(*raw, edited, true)) {
+        return "Edited inputs play back differently";
+    }
+
+    return nullptr;
+}
+
+/// @brief Checks that every ghost in a directory round trips through System::GhostTimeline.
+/// @details The directory is the first argument, or the samples directory of the working
+/// directory. Ghosts are allocated on a root heap, as they are in a race.
+/// @return 0 if every ghost round trips, or 1 if any doesn't or none were found.
+int main(int argc, char **argv) {
+    std::filesystem::path directory = argc > 1 ? argv[1] : "samples";
+
+    void *memorySpace = malloc(MEMORY_SPACE_SIZE);
+    EGG::Heap *rootHeap = EGG::ExpHeap::create(memorySpace, MEMORY_SPACE_SIZE, DEFAULT_OPT);
+    ASSERT(rootHeap);
+    rootHeap->becomeCurrentHeap();
+
+    u32 ghostCount = 0;
+    u32 failures = 0;
+    std::error_code ec;
+    for (const auto &entry : std::filesystem::directory_iterator(directory, ec)) {
+        if (entry.path().extension() != ".rkg") {
+            continue;
+        }
+
+        ++ghostCount;
+        if (const char *error = CheckGhost(entry.path())) {
+            WARN("%s does not round trip: %s", entry.path().string().c_str(), error);
+            ++failures;
+        }
+    }
+
+    if (ghostCount == 0) {
+        WARN("No ghosts were found in %s", directory.string().c_str());
+        return 1;
+    }
+
+    if (failures > 0) {
+        WARN("%u of %u ghosts do not round trip", failures, ghostCount);
+        return 1;
+    }
+
+    REPORT("ghostTimeline: %u ghosts round trip", ghostCount);
+    return 0;
+}
@@ -0,0 +1,184 @@
+// Measures how many episodes per second a host can run through the C interface in kinoko.h,
+// compared to spawning a Kinoko process per episode. An episode replays a ghost to the end of the
+// race, either by creating the race scene again, or by restoring a context saved at its start.
+// Exits with a non-zero status if any episode ends differently from the first.
+//
+// Usage, from the directory with the game files:
+//     ./bench_episodes <path to kinoko> <path to rkg> [episodes]
+
+#include <kinoko.h>
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+extern char **environ;
+
+/// Replays stop once the race has gone on for 10 minutes, as in replay mode.
+#define MAX_EPISODE_FRAMES (10 * 60 * 60 + 600)
+
+static double NowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void *LoadFile(const char *path, size_t *size) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    void *data = length > 0 ? malloc((size_t)length) : NULL;
+    if (data && fread(data, 1, (size_t)length, file) != (size_t)length) {
+        free(data);
+        data = NULL;
+    }
+
+    fclose(file);
+    *size = (size_t)length;
+    return data;
+}
+
+/// Runs `kinoko replay -g <ghost> --headless` to completion, discarding its output.
+/// @return The exit status, which is non-zero if the ghost desynced, or -1 if the process failed.
+static int SpawnReplay(const char *executable, const char *ghost) {
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+
+    char *argv[] = {(char *)executable, "replay", "-g", (char *)ghost, "--headless", NULL};
+    pid_t pid;
+    int result = posix_spawn(&pid, executable, &actions, NULL, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    if (result != 0) {
+        return -1;
+    }
+
+    int status = 0;
+    if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status)) {
+        return -1;
+    }
+
+    return WEXITSTATUS(status);
+}
+
+/// Steps the current race until it finishes, and returns its final state.
+static KinokoKartState StepToFinish(void) {
+    KinokoKartState state;
+    kinoko_get_kart_state(&state);
+
+    while (state.stage != KINOKO_STAGE_FINISH_GLOBAL && state.frame < MAX_EPISODE_FRAMES) {
+        kinoko_step(1);
+        kinoko_get_kart_state(&state);
+    }
+
+    return state;
+}
+
+static int SameState(const KinokoKartState *lhs, const KinokoKartState *rhs) {
+    return lhs->frame == rhs->frame && memcmp(lhs->pos, rhs->pos, sizeof(lhs->pos)) == 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <path to kinoko> <path to rkg> [episodes]\n", argv[0]);
+        return 1;
+    }
+
+    const char *executable = argv[1];
+    const char *ghostPath = argv[2];
+    int episodes = argc > 3 ? atoi(argv[3]) : 10;
+    if (episodes <= 0) {
+        fprintf(stderr, "Invalid episode count: %s\n", argv[3]);
+        return 1;
+    }
+
+    if (kinoko_api_version() != KINOKO_API_VERSION) {
+        fprintf(stderr, "Expected API version %d, but the library has version %u\n",
+                KINOKO_API_VERSION, kinoko_api_version());
+        return 1;
+    }
+
+    size_t ghostSize = 0;
+    void *ghost = LoadFile(ghostPath, &ghostSize);
+    if (!ghost) {
+        fprintf(stderr, "Failed to read %s\n", ghostPath);
+        return 1;
+    }
+
+    double t0 = NowSeconds();
+    for (int i = 0; i < episodes; ++i) {
+        if (SpawnReplay(executable, ghostPath) < 0) {
+            fprintf(stderr, "Failed to replay %s with %s\n", ghostPath, executable);
+            return 1;
+        }
+    }
+    double processSeconds = NowSeconds() - t0;
+
+    KinokoConfig config;
+    memset(&config, 0, sizeof(config));
+    config.headless = 1;
+    config.retainBudget = 64 * 1024 * 1024;
+    if (kinoko_init(&config) != KINOKO_OK) {
+        fprintf(stderr, "Failed to initialize Kinoko\n");
+        return 1;
+    }
+
+    // Episodes which end differently from the first, after which the run fails
+    int divergences = 0;
+    KinokoKartState expected;
+    t0 = NowSeconds();
+    for (int i = 0; i < episodes; ++i) {
+        if (kinoko_race_create_ghost(ghost, ghostSize) != KINOKO_OK) {
+            fprintf(stderr, "Failed to create a race from %s\n", ghostPath);
+            return 1;
+        }
+
+        KinokoKartState state = StepToFinish();
+        if (i == 0) {
+            expected = state;
+        } else if (!SameState(&state, &expected)) {
+            fprintf(stderr, "Episode %d ended differently after recreating the race\n", i);
+            ++divergences;
+        }
+    }
+    double createSeconds = NowSeconds() - t0;
+
+    kinoko_race_create_ghost(ghost, ghostSize);
+    KinokoContext *start = kinoko_context_create();
+    t0 = NowSeconds();
+    for (int i = 0; i < episodes; ++i) {
+        kinoko_context_restore(start);
+        KinokoKartState state = StepToFinish();
+        if (!SameState(&state, &expected)) {
+            fprintf(stderr, "Episode %d ended differently after restoring a context\n", i);
+            ++divergences;
+        }
+    }
+    double restoreSeconds = NowSeconds() - t0;
+    kinoko_context_destroy(start);
+
+    printf("Episodes: %d (%u frames each)\n", episodes, expected.frame);
+    printf("Process per episode: %.2f episodes/s\n", episodes / processSeconds);
+    printf("Library, race per episode: %.2f episodes/s\n", episodes / createSeconds);
+    printf("Library, context per episode: %.2f episodes/s\n", episodes / restoreSeconds);
+
+    free(ghost);
+
+    if (divergences > 0) {
+        fprintf(stderr, "%d episodes diverged\n", divergences);
+        return 1;
+    }
+
+    return 0;
+}